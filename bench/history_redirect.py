@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Benchmark `history > file`: waktu dan jumlah write(2) listing builtin.
+
+Usage: bench/history_redirect.py [NSH] [--entries N] [--runs N]
+
+nsh hanya memuat history di mode interaktif, jadi setiap run adalah shell
+baru di pseudo-terminal dengan HISTFILE sementara berisi N entry. Run
+`history -r` saja dikurangkan dari run `history -r; history > file`, sisanya
+biaya menulis listing. Yang dilaporkan median dari semua run. Jika strace
+tersedia, jumlah write(2) juga dihitung dengan cara yang sama.
+
+Contoh membandingkan dua build:
+    bench/history_redirect.py /tmp/before/build/nsh
+    bench/history_redirect.py build/nsh
+"""
+
+import argparse
+import os
+import pty
+import select
+import shutil
+import signal
+import statistics
+import sys
+import tempfile
+import time
+
+JOB_SIGNALS = (signal.SIGINT, signal.SIGTSTP, signal.SIGTTOU, signal.SIGQUIT)
+RUN_TIMEOUT = 30.0
+
+
+def spawn_in_pty(argv, env):
+    """Jalankan argv sebagai foreground process group di pty baru.
+
+    Shell interaktif tidak boleh menjadi session leader (setpgid akan gagal),
+    jadi session leader pty hanya menunggu anak yang menjalankan argv.
+    """
+    pid, fd = pty.fork()
+    if pid == 0:
+        for sig in JOB_SIGNALS:
+            signal.signal(sig, signal.SIG_IGN)
+        child = os.fork()
+        if child == 0:
+            os.setpgid(0, 0)
+            os.tcsetpgrp(0, os.getpid())
+            for sig in JOB_SIGNALS:
+                signal.signal(sig, signal.SIG_DFL)
+            os.execve(argv[0], argv, env)
+        _, status = os.waitpid(child, 0)
+        os._exit(os.waitstatus_to_exitcode(status) & 0xff)
+    return pid, fd
+
+
+def run_session(argv, env, lines):
+    """Kirim baris ke shell setelah prompt pertama, return durasi (detik)."""
+    start = time.perf_counter()
+    pid, fd = spawn_in_pty(argv, env)
+    deadline = start + RUN_TIMEOUT
+    sent = False
+    while time.perf_counter() < deadline:
+        ready, _, _ = select.select([fd], [], [], 0.05)
+        if not ready:
+            continue
+        try:
+            data = os.read(fd, 65536)
+        except OSError:
+            break  # shell sudah exit, sisi slave tertutup
+        if not data:
+            break
+        if not sent:
+            os.write(fd, "".join(line + "\n" for line in lines).encode())
+            sent = True
+    os.waitpid(pid, 0)
+    os.close(fd)
+    elapsed = time.perf_counter() - start
+    if elapsed >= RUN_TIMEOUT:
+        sys.exit(f"history_redirect.py: {argv[0]}: session timed out")
+    return elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark `history > file` in nsh.")
+    parser.add_argument("nsh", nargs="?", default="build/nsh")
+    parser.add_argument("--entries", type=int, default=100000)
+    parser.add_argument("--runs", type=int, default=7)
+    args = parser.parse_args()
+
+    nsh = os.path.abspath(args.nsh)
+    if not os.access(nsh, os.X_OK):
+        sys.exit(f"history_redirect.py: {args.nsh}: not executable (run make first)")
+
+    with tempfile.TemporaryDirectory() as work:
+        home = os.path.join(work, "home")
+        os.mkdir(home)
+        histfile = os.path.join(work, "history")
+        listing = os.path.join(work, "listing")
+        entries = "".join(f"echo history entry {i}\n" for i in range(1, args.entries + 1))
+
+        env = dict(os.environ, HOME=home, HISTFILE=histfile, TERM="dumb")
+        scenarios = {
+            "load": ["history -r", "exit"],
+            "full": ["history -r", f"history > {listing}", "exit"],
+        }
+
+        def run(name, wrapper=()):
+            # Shell menyimpan history saat exit: setiap run mulai dari file yang sama
+            with open(histfile, "w") as f:
+                f.write(entries)
+            return run_session(list(wrapper) + [nsh], env, scenarios[name])
+
+        times = {name: [] for name in scenarios}
+        for _ in range(args.runs):
+            for name in scenarios:
+                times[name].append(run(name))
+        with open(listing) as f:
+            listed = sum(1 for _ in f)
+        if listed < args.entries:
+            sys.exit(f"history_redirect.py: listing has {listed} lines, expected {args.entries}")
+
+        load = statistics.median(times["load"]) * 1000
+        full = statistics.median(times["full"]) * 1000
+        print(f"nsh: {args.nsh}, {args.entries} entries, median of {args.runs} runs")
+        print(f"  {'history -r':<30} {load:8.1f} ms")
+        print(f"  {'history -r; history > file':<30} {full:8.1f} ms")
+        print(f"  {'history > file (difference)':<30} {full - load:8.1f} ms")
+
+        strace = shutil.which("strace")
+        if not strace:
+            print("  (strace not found: write(2) count skipped)")
+            return
+        counts = {}
+        for name in scenarios:
+            trace = os.path.join(work, f"strace.{name}")
+            run(name, [strace, "-f", "-qq", "-e", "trace=write", "-o", trace])
+            with open(trace) as f:
+                counts[name] = sum(1 for _ in f)
+        print(f"  {'write(2) for history > file':<30} {counts['full'] - counts['load']:8d}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+#include "builtin_io.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+thread_local std::ostream *current_builtin_out = nullptr;
+// Cukup besar supaya `history > file` dengan ratusan ribu entry hanya
+// butuh beberapa write(2), bukan satu per baris seperti std::endl
+constexpr size_t FD_OUT_BUFFER_SIZE = 64 * 1024;
+}
+
+FdOutBuf::FdOutBuf(int fd, bool never_block)
+    : out_fd(fd), line_buffered(isatty(fd)), never_block(never_block), buffer(FD_OUT_BUFFER_SIZE)
+{
+    if (never_block)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+FdOutBuf::~FdOutBuf()
+{
+    if (never_block)
+        drain();
+    else
+        flush_buffer();
+}
+
+bool write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        len -= written;
+    }
+    return true;
+}
+
+bool FdOutBuf::write_some(const char *&data, size_t &len)
+{
+    while (len > 0) {
+        ssize_t written = write(out_fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN;
+        }
+        data += written;
+        len -= written;
+    }
+    return true;
+}
+
+bool FdOutBuf::write_pending()
+{
+    const char *data = pending.data();
+    size_t len = pending.size();
+    bool ok = write_some(data, len);
+    pending.erase(0, pending.size() - len);
+    return ok;
+}
+
+bool FdOutBuf::flush_buffer()
+{
+    const char *data = pbase();
+    size_t len = pptr() - pbase();
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    if (broken || len == 0)
+        return !broken;
+    if (!never_block) {
+        // EPIPE: the reader closed its end (e.g. `history | head`), drop the rest
+        broken = !write_all(out_fd, data, len);
+        return !broken;
+    }
+
+    // Pipe full: keep the rest behind what is already waiting for drain()
+    if (!write_pending() || (pending.empty() && !write_some(data, len)))
+        broken = true;
+    else
+        pending.append(data, len);
+    return !broken;
+}
+
+bool FdOutBuf::drain()
+{
+    flush_buffer();
+    while (!broken && !pending.empty()) {
+        if (!write_pending()) {
+            broken = true;
+            break;
+        }
+        struct pollfd pfd = {out_fd, POLLOUT, 0};
+        if (!pending.empty() && poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            broken = true;
+    }
+    if (broken)
+        pending.clear();
+    return !broken;
+}
+
+FdOutBuf::int_type FdOutBuf::overflow(int_type ch)
+{
+    if (!flush_buffer())
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        if (line_buffered && traits_type::to_char_type(ch) == '\n' && !flush_buffer())
+            return traits_type::eof();
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize FdOutBuf::xsputn(const char *s, std::streamsize n)
+{
+    std::streamsize done = 0;
+    while (done < n) {
+        std::streamsize room = epptr() - pptr();
+        if (room == 0) {
+            if (!flush_buffer())
+                return done;
+            continue;
+        }
+        std::streamsize chunk = std::min(room, n - done);
+        traits_type::copy(pptr(), s + done, chunk);
+        pbump(static_cast<int>(chunk));
+        done += chunk;
+    }
+    // Terminal: tampilkan per baris seperti stdout biasa
+    if (line_buffered && traits_type::find(s, n, '\n') && !flush_buffer())
+        return n;
+    return done;
+}
+
+int FdOutBuf::sync()
+{
+    return flush_buffer() ? 0 : -1;
+}
+
+BuiltinOutputScope::BuiltinOutputScope(int fd)
+    : buf(new FdOutBuf(fd)), owned_stream(new std::ostream(buf.get())),
+      stream(owned_stream.get()), previous(current_builtin_out)
+{
+    current_builtin_out = stream;
+}
+
+BuiltinOutputScope::BuiltinOutputScope(std::ostream &target)
+    : stream(&target), previous(current_builtin_out)
+{
+    current_builtin_out = stream;
+}
+
+BuiltinOutputScope::~BuiltinOutputScope()
+{
+    stream->flush();
+    current_builtin_out = previous;
+}
+
+bool builtin_out_bound()
+{
+    return current_builtin_out != nullptr;
+}
+
+std::ostream &builtin_out()
+{
+    return current_builtin_out ? *current_builtin_out : std::cout;
+}
@@ -9,6 +9,7 @@
 #include "execution.h"
 #include "signals.h"
 #include "terminal.h"
+#include "builtin_io.h"
 
 #include <iostream>
 #include <iomanip>
@@ -37,4 +38,11 @@
 #include "builtins/exec.def.cc"
 #include "builtins/unset.def.cc"
 #include "builtins/hash.def.cc"
-#include "builtins/jobspec.def.cc"
\ No newline at end of file
+#include "builtins/jobspec.def.cc"
+#include "builtins/coproc.def.cc"
+#include "builtins/read.def.cc"
+#include "builtins/wait.def.cc"
+#include "builtins/parallel.def.cc"
+#include "builtins/timer.def.cc"
+#include "builtins/every.def.cc"
+#include "builtins/ulimit.def.cc"
\ No newline at end of file
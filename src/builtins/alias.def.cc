@@ -16,7 +16,7 @@ void handle_builtin_alias(const std::vector<std::string>& tokens) {
     if (tokens.size() == 1) {
         // Menampilkan semua alias yang ada
         if (aliases.empty()) {
-            std::cout << "No aliases defined." << std::endl;
+            builtin_out() << "No aliases defined.\n";
             last_exit_code = 0;
             return;
         }
@@ -31,8 +31,8 @@ void handle_builtin_alias(const std::vector<std::string>& tokens) {
         
         // Tampilkan semua alias dengan formatting rapi
         for (const auto& [name, value] : aliases) {
-            std::cout << "alias " << std::left << std::setw(max_name_length) << name 
-                      << "='" << value << "'" << std::endl;
+            builtin_out() << "alias " << std::left << std::setw(max_name_length) << name 
+                      << "='" << value << "'\n";
         }
         last_exit_code = 0;
         return;
@@ -53,7 +53,7 @@ void handle_builtin_alias(const std::vector<std::string>& tokens) {
             const std::string& alias_name = tokens[i];
             auto it = aliases.find(alias_name);
             if (it != aliases.end()) {
-                std::cout << "alias " << it->first << "='" << it->second << "'" << std::endl;
+                builtin_out() << "alias " << it->first << "='" << it->second << "'\n";
                 last_exit_code = 0;
             } else {
                 std::cerr << "nsh: alias: " << alias_name << ": not found" << std::endl;
@@ -154,5 +154,5 @@ void handle_builtin_alias(const std::vector<std::string>& tokens) {
     save_aliases();
     
     // Tampilkan konfirmasi
-    std::cout << "alias " << alias_name << "='" << alias_value << "'" << std::endl;
+    builtin_out() << "alias " << alias_name << "='" << alias_value << "'\n";
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "execution.h"
+#include "globals.h"
+#include "events.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <string>
+
+// Fd milik shell untuk setiap coproc yang masih hidup, per NAME. Entry
+// dihapus saat job coproc selesai (coproc_job_finished) atau saat NAME yang
+// sama dijalankan ulang.
+struct CoprocFds {
+    pid_t pid;
+    int read_fd;   // NAME_0: stdout coproc
+    int write_fd;  // NAME_1: stdin coproc
+};
+static std::map<std::string, CoprocFds> coproc_table;
+
+static bool is_valid_coproc_name(const std::string &name)
+{
+    if (name.empty() || (!isalpha(static_cast<unsigned char>(name[0])) && name[0] != '_'))
+        return false;
+    for (char c : name)
+    {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_')
+            return false;
+    }
+    return true;
+}
+
+// Pindahkan fd ke nomor >= 10 (tetap O_CLOEXEC) supaya tidak bentrok
+// dengan fd yang biasa dipakai script (`exec 3>file`)
+static int move_coproc_fd(int fd)
+{
+    int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+    if (high_fd == -1)
+        return fd;
+    close(fd);
+    return high_fd;
+}
+
+/**
+ * @brief Builtin coproc: jalankan command-list sebagai proses latar belakang
+ *        dengan stdin dan stdout tersambung ke shell lewat dua pipe.
+ *
+ * Parser menyatukan `coproc NAME { cmd; }` menjadi token {"coproc", NAME, BODY}.
+ * Fd tersedia di variabel NAME_0 (baca output coproc), NAME_1 (tulis ke
+ * stdin coproc) dan PID di NAME_PID. Job dicatat seperti job background.
+ */
+void handle_builtin_coproc(const std::vector<std::string> &tokens)
+{
+    if (tokens.size() < 3 || tokens[1] == "--help" || tokens[1] == "-h")
+    {
+        builtin_out() << "coproc: coproc [NAME] { command-list; }\n"
+                      << "    Create a coprocess named NAME.\n\n"
+                      << "    Execute COMMAND-LIST asynchronously, with its standard input and\n"
+                      << "    standard output connected via pipes to file descriptors stored in\n"
+                      << "    the variables NAME_1 (write to the coprocess) and NAME_0 (read its\n"
+                      << "    output) of the executing shell. NAME_PID holds the process id.\n"
+                      << "    The default NAME is \"COPROC\".\n\n"
+                      << "    Example:\n"
+                      << "      coproc BC { bc -l; }\n"
+                      << "      echo '2^10' >&$BC_1; read -u $BC_0 result\n\n"
+                      << "    Exit Status:\n"
+                      << "    The coproc command returns an exit status of 0.\n";
+        last_exit_code = tokens.size() < 3 ? 2 : 0;
+        return;
+    }
+
+    const std::string &name = tokens[1];
+    const std::string &body = tokens[2];
+
+    if (!is_valid_coproc_name(name))
+    {
+        std::cerr << "nsh: coproc: `" << name << "': not a valid identifier" << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+    if (body.empty())
+    {
+        std::cerr << "nsh: coproc: missing command" << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+
+    auto existing = coproc_table.find(name);
+    if (existing != coproc_table.end())
+    {
+        if (kill(existing->second.pid, 0) == 0)
+        {
+            std::cerr << "nsh: warning: coproc [" << existing->second.pid << ":" << name
+                      << "] still exists" << std::endl;
+        }
+        close(existing->second.read_fd);
+        close(existing->second.write_fd);
+        coproc_table.erase(existing);
+    }
+
+    int to_coproc[2], from_coproc[2];
+    if (pipe2(to_coproc, O_CLOEXEC) < 0)
+    {
+        std::cerr << "nsh: coproc: pipe: " << strerror(errno) << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+    if (pipe2(from_coproc, O_CLOEXEC) < 0)
+    {
+        std::cerr << "nsh: coproc: pipe: " << strerror(errno) << std::endl;
+        close(to_coproc[0]);
+        close(to_coproc[1]);
+        last_exit_code = 1;
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "nsh: coproc: fork: " << strerror(errno) << std::endl;
+        close(to_coproc[0]); close(to_coproc[1]);
+        close(from_coproc[0]); close(from_coproc[1]);
+        last_exit_code = 1;
+        return;
+    }
+
+    if (pid == 0)
+    {
+        // Coproc adalah job sendiri; command di dalamnya tidak mengambil
+        // alih process group maupun terminal
+        in_helper_child = true;
+        setpgid(0, 0);
+        for (int sig : {SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD, SIGPIPE})
+            signal(sig, SIG_DFL);
+
+        for (const auto &[other_name, fds] : coproc_table)
+        {
+            close(fds.read_fd);
+            close(fds.write_fd);
+        }
+
+        dup2(to_coproc[0], STDIN_FILENO);
+        dup2(from_coproc[1], STDOUT_FILENO);
+        close(to_coproc[0]); close(to_coproc[1]);
+        close(from_coproc[0]); close(from_coproc[1]);
+
+        int code = execute_subshell_direct(body);
+        std::cout.flush();
+        // _exit, bukan exit(): lihat start_process_substitution
+        _exit(code);
+    }
+
+    setpgid(pid, pid);
+    event_loop_track_child(pid, pid, false);
+    close(to_coproc[0]);
+    close(from_coproc[1]);
+
+    CoprocFds fds = {pid, move_coproc_fd(from_coproc[0]), move_coproc_fd(to_coproc[1])};
+    coproc_table[name] = fds;
+
+    set_env_var(name + "_0", std::to_string(fds.read_fd), false);
+    set_env_var(name + "_1", std::to_string(fds.write_fd), false);
+    set_env_var(name + "_PID", std::to_string(pid), false);
+
+    int job_id = add_job_to_list(pid, "coproc " + name + " { " + body + " }", JobStatus::RUNNING, true);
+    builtin_out() << "[" << job_id << "] " << pid << '\n';
+    last_exit_code = 0;
+}
+
+/**
+ * @brief Dipanggil job_process_changed saat job coproc selesai.
+ *
+ * Seperti bash, fd NAME_0/NAME_1 milik shell ditutup dan NAME_0, NAME_1,
+ * NAME_PID di-unset; output coproc yang belum dibaca ikut hilang.
+ */
+void coproc_job_finished(pid_t pgid)
+{
+    std::lock_guard<std::recursive_mutex> lock(builtin_state_mutex);
+    for (auto it = coproc_table.begin(); it != coproc_table.end(); ++it)
+    {
+        if (it->second.pid != pgid)
+            continue;
+        close(it->second.read_fd);
+        close(it->second.write_fd);
+        unset_env_var(it->first + "_0");
+        unset_env_var(it->first + "_1");
+        unset_env_var(it->first + "_PID");
+        coproc_table.erase(it);
+        return;
+    }
+}
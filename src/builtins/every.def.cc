@@ -0,0 +1,301 @@
+// builtins/every.def.cc
+
+#include "execution.h"
+#include "events.h"
+#include "globals.h"
+#include "parser.h"
+#include "terminal.h"
+#include "utils.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void show_every_help()
+{
+    builtin_out() << "every: every [-n COUNT] [--skip | --queue] [-q] INTERVAL COMMAND...\n"
+                  << "    Run COMMAND every INTERVAL on a fixed schedule.\n\n"
+                  << "    COMMAND is parsed once and started at 0, INTERVAL, 2*INTERVAL, ...\n"
+                  << "    after the first run, measured from an absolute deadline so the\n"
+                  << "    schedule does not drift by the runtime of COMMAND. INTERVAL takes\n"
+                  << "    the same suffixes as sleep. Variables in COMMAND are expanded again\n"
+                  << "    for every run. Stops on Ctrl-C or after COUNT runs, then prints\n"
+                  << "    latency statistics to standard error.\n\n"
+                  << "    Options:\n"
+                  << "      -n, --count COUNT  stop after COUNT runs\n"
+                  << "      --skip             drop ticks that arrive while COMMAND is still\n"
+                  << "                         running (default)\n"
+                  << "      --queue            run COMMAND again right after the previous run\n"
+                  << "                         for every tick that arrived meanwhile\n"
+                  << "      -q, --quiet        do not print statistics\n\n"
+                  << "    Exit Status:\n"
+                  << "    The status of the last run; 130 if interrupted; 2 on usage error.\n";
+}
+
+using every_clock = std::chrono::steady_clock;
+
+static double millis_between(every_clock::time_point from, every_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Ringkasan min/avg/p95/max dalam milidetik
+static std::string summarize_millis(std::vector<double> values)
+{
+    if (values.empty())
+        return "-";
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double value : values)
+        sum += value;
+    size_t p95 = std::min(values.size() - 1, static_cast<size_t>(values.size() * 0.95));
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << "min " << values.front() << " ms, avg "
+        << sum / values.size() << " ms, p95 " << values[p95] << " ms, max " << values.back() << " ms";
+    return out.str();
+}
+
+/**
+ * @brief Builtin every: jalankan command yang di-parse sekali secara periodik.
+ *
+ * Jadwal memakai timerfd periodik di event loop shell (deadline absolut
+ * CLOCK_MONOTONIC). Setiap run dijalankan seperti run `parallel`
+ * (spawn_parallel_run, parallel.def.cc) dan exit-nya dibaca dari pidfd di
+ * loop yang sama. Durasi diparse seperti sleep (timer.def.cc).
+ */
+void handle_builtin_every(const std::vector<std::string> &tokens)
+{
+    long max_runs = 0;
+    bool queue_ticks = false;
+    bool quiet = false;
+
+    size_t i = 1;
+    for (; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (token == "--")
+        {
+            ++i;
+            break;
+        }
+        if (token.size() < 2 || token[0] != '-')
+            break;
+        if (token == "--help" || token == "-h")
+        {
+            show_every_help();
+            last_exit_code = 0;
+            return;
+        }
+        if (token == "--skip")
+        {
+            queue_ticks = false;
+        }
+        else if (token == "--queue")
+        {
+            queue_ticks = true;
+        }
+        else if (token == "-q" || token == "--quiet")
+        {
+            quiet = true;
+        }
+        else if (token == "-n" || token == "--count")
+        {
+            long count = 0;
+            if (i + 1 < tokens.size() && is_string_numeric(tokens[i + 1]))
+            {
+                errno = 0;
+                count = strtol(tokens[i + 1].c_str(), nullptr, 10);
+                if (errno != 0)
+                    count = 0;
+            }
+            if (count <= 0)
+            {
+                std::cerr << "nsh: every: " << token << ": expected a positive count" << std::endl;
+                last_exit_code = 2;
+                return;
+            }
+            max_runs = count;
+            ++i;
+        }
+        else
+        {
+            std::cerr << "nsh: every: " << token << ": invalid option" << std::endl;
+            std::cerr << "every: usage: every [-n COUNT] [--skip | --queue] [-q] INTERVAL COMMAND..." << std::endl;
+            last_exit_code = 2;
+            return;
+        }
+    }
+
+    if (i + 1 >= tokens.size())
+    {
+        std::cerr << "every: usage: every [-n COUNT] [--skip | --queue] [-q] INTERVAL COMMAND..." << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+
+    double interval = 0;
+    // Di bawah 1 ns it_interval timerfd menjadi 0, timer hanya sekali jalan
+    if (!parse_duration(tokens[i], interval) || interval < 1e-9)
+    {
+        std::cerr << "nsh: every: invalid interval `" << tokens[i] << "'" << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+
+    std::vector<ParsedCommand> commands;
+    try
+    {
+        Parser parser;
+        commands = parser.parse(join_command_words(tokens, i + 1, tokens.size()));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "nsh: every: " << e.what() << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+    if (commands.empty())
+    {
+        std::cerr << "nsh: every: missing command" << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0)
+    {
+        std::cerr << "nsh: every: timerfd: " << strerror(errno) << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+    int high_fd = fcntl(timer_fd, F_DUPFD_CLOEXEC, 10);
+    if (high_fd >= 0)
+    {
+        close(timer_fd);
+        timer_fd = high_fd;
+    }
+
+    // Tick ke-k jatuh tempo di start + k*interval; timer absolut, jadi
+    // keterlambatan satu run tidak menggeser tick berikutnya
+    auto period = std::chrono::duration_cast<every_clock::duration>(std::chrono::duration<double>(interval));
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    every_clock::time_point start = every_clock::now();
+
+    struct itimerspec spec = {};
+    spec.it_interval = duration_to_timespec(interval);
+    if (spec.it_interval.tv_sec == 0 && spec.it_interval.tv_nsec == 0)
+        spec.it_interval.tv_nsec = 1; // 1e-9 yang terpotong pembulatan
+    spec.it_value = now_ts;
+    spec.it_value.tv_sec += spec.it_interval.tv_sec;
+    spec.it_value.tv_nsec += spec.it_interval.tv_nsec;
+    if (spec.it_value.tv_nsec >= 1000000000L)
+    {
+        spec.it_value.tv_sec++;
+        spec.it_value.tv_nsec -= 1000000000L;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    uint64_t ticks = 0;                  // tick yang sudah jatuh tempo (tick 0 = start)
+    std::deque<uint64_t> due_ticks = {0}; // tick yang menunggu run
+    size_t skipped = 0;
+    long runs_started = 0;
+    pid_t active_pid = 0;
+    every_clock::time_point active_start;
+    std::vector<double> lateness;  // start run - jadwal tick-nya
+    std::vector<double> durations; // lama run
+    int last_status = 0;
+    bool interrupted = false;
+
+    event_loop_add_fd(timer_fd, EPOLLIN, [&](uint32_t) {
+        uint64_t expirations = 0;
+        if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return;
+        for (uint64_t k = 0; k < expirations; ++k)
+        {
+            ++ticks;
+            // --skip: tick yang datang saat run masih berjalan dibuang
+            if (queue_ticks || (active_pid == 0 && due_ticks.empty()))
+                due_ticks.push_back(ticks);
+            else
+                skipped++;
+        }
+    });
+
+    safe_set_cooked_mode();
+
+    while (true)
+    {
+        if (active_pid == 0 && !due_ticks.empty() && !interrupted &&
+            (max_runs == 0 || runs_started < max_runs))
+        {
+            uint64_t tick = due_ticks.front();
+            due_ticks.pop_front();
+            int unused_fd;
+            active_start = every_clock::now();
+            active_pid = spawn_parallel_run(commands, nullptr, false, false, unused_fd);
+            if (active_pid < 0)
+            {
+                active_pid = 0;
+                last_status = 1 << 8;
+                break;
+            }
+            runs_started++;
+            lateness.push_back(millis_between(start + period * tick, active_start));
+        }
+
+        if (active_pid == 0 && (interrupted || (max_runs != 0 && runs_started >= max_runs)))
+            break;
+
+        event_loop_run_once(-1);
+
+        if (received_sigint && !interrupted)
+        {
+            interrupted = true;
+            if (active_pid != 0)
+                kill(-active_pid, SIGINT);
+        }
+
+        int status = 0;
+        if (active_pid != 0 && event_loop_child_exited(active_pid, &status))
+        {
+            durations.push_back(millis_between(active_start, every_clock::now()));
+            last_status = status;
+            active_pid = 0;
+        }
+    }
+
+    safe_set_raw_mode();
+    event_loop_remove_fd(timer_fd);
+    close(timer_fd);
+
+    if (!quiet)
+    {
+        std::cerr << "every: " << runs_started << " runs, " << skipped << " skipped ticks, interval "
+                  << std::fixed << std::setprecision(3) << interval << " s\n"
+                  << "  start latency: " << summarize_millis(lateness) << "\n"
+                  << "  run time:      " << summarize_millis(durations) << std::endl;
+    }
+
+    if (interrupted)
+        last_exit_code = 130;
+    else if (WIFSIGNALED(last_status))
+        last_exit_code = 128 + WTERMSIG(last_status);
+    else
+        last_exit_code = WIFEXITED(last_status) ? WEXITSTATUS(last_status) : 0;
+}
@@ -1,5 +1,6 @@
 #include "execution.h"
 #include "terminal.h"
+#include "events.h"
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -242,6 +243,7 @@ void handle_builtin_exec(const std::vector<std::string> &tokens)
     }
     
     restore_terminal_mode();
+    event_loop_prepare_exec();
 
     // Eksekusi perintah menggunakan execve
     if (execve(binary_path.c_str(), argv, envp) == -1) {
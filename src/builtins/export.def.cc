@@ -2,7 +2,7 @@ void handle_builtin_export(const std::vector<std::string> &tokens)
 {
     if (tokens.size() > 1 && (tokens[1] == "--help" || tokens[1] == "-h"))
     {
-        std::cout << "export: export [-fn] [name[=value] ...] or export -p\n"
+        builtin_out() << "export: export [-fn] [name[=value] ...] or export -p\n"
                   << "    Set export attribute for shell variables.\n\n"
                   << "    Marks each NAME for automatic export to the environment of\n"
                   << "    subsequently executed commands.  If VALUE is supplied, assign\n"
@@ -81,7 +81,7 @@ void handle_builtin_export(const std::vector<std::string> &tokens)
     {
         for (char **env = environ; *env; ++env)
         {
-            std::cout << "export " << *env << std::endl;
+            builtin_out() << "export " << *env << '\n';
         }
         last_exit_code = 0;
         return;
@@ -109,7 +109,7 @@ void handle_builtin_export(const std::vector<std::string> &tokens)
     {
         for (char **env = environ; *env; ++env)
         {
-            std::cout << "export " << *env << std::endl;
+            builtin_out() << "export " << *env << '\n';
         }
         last_exit_code = 0;
         return;
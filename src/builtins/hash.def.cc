@@ -8,7 +8,7 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
 {
     if (tokens.size() > 1 && (tokens[1] == "--help" || tokens[1] == "-h"))
     {
-        std::cout << "hash: hash [-lr] [-p pathname] [-dt] [name ...]\n"
+        builtin_out() << "hash: hash [-lr] [-p pathname] [-dt] [name ...]\n"
                   << "    Remember or display program locations.\n\n"
                   << "    Determine and remember the full pathname of each command NAME.  If\n"
                   << "    no arguments are given, information about remembered commands is displayed.\n\n"
@@ -110,9 +110,9 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
     if (forget_all)
     {
         if (verbose) {
-            std::cout << "hash: hash table emptied (" << binary_hash_loc.size() << " entries removed)" << std::endl;
+            builtin_out() << "hash: hash table emptied (" << binary_hash_loc.size() << " entries removed)\n";
         } else {
-            std::cout << "hash: hash table emptied" << std::endl;
+            builtin_out() << "hash: hash table emptied\n";
         }
         binary_hash_loc.clear();
         last_exit_code = 0;
@@ -136,10 +136,10 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
             if (it != binary_hash_loc.end())
             {
                 if (verbose) {
-                    std::cout << "hash: " << name << ": removed from hash table (was: " 
-                              << it->second.path << ")" << std::endl;
+                    builtin_out() << "hash: " << name << ": removed from hash table (was: " 
+                              << it->second.path << ")\n";
                 } else {
-                    std::cout << "hash: " << name << ": removed from hash table" << std::endl;
+                    builtin_out() << "hash: " << name << ": removed from hash table\n";
                 }
                 binary_hash_loc.erase(it);
             }
@@ -189,9 +189,9 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
         binary_hash_loc[names[0]] = {abs_path, names[0], 0};
         
         if (verbose) {
-            std::cout << "hash: added " << names[0] << " = " << abs_path << " (custom path)" << std::endl;
+            builtin_out() << "hash: added " << names[0] << " = " << abs_path << " (custom path)\n";
         } else {
-            std::cout << names[0] << " = " << abs_path << std::endl;
+            builtin_out() << names[0] << " = " << abs_path << '\n';
         }
         last_exit_code = 0;
         return;
@@ -202,7 +202,7 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
     {
         if (binary_hash_loc.empty())
         {
-            std::cout << "hash: hash table empty" << std::endl;
+            builtin_out() << "hash: hash table empty\n";
             last_exit_code = 0;
             return;
         }
@@ -211,20 +211,20 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
         {
             for (const auto &[cmd, info] : binary_hash_loc)
             {
-                std::cout << "hash -p " << info.path << " " << cmd << std::endl;
+                builtin_out() << "hash -p " << info.path << " " << cmd << '\n';
             }
         }
         else if (terse_format)
         {
             for (const auto &[cmd, info] : binary_hash_loc)
             {
-                std::cout << cmd << "\t" << info.path << std::endl;
+                builtin_out() << cmd << "\t" << info.path << '\n';
             }
         }
         else
         {
             // Format seperti bash
-            std::cout << "hits\tcommand" << std::endl;
+            builtin_out() << "hits\tcommand\n";
             
             std::vector<std::pair<std::string, binary_hash_info>> sorted_entries;
             for (const auto &entry : binary_hash_loc)
@@ -243,7 +243,7 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
             
             for (const auto &[cmd, info] : sorted_entries)
             {
-                std::cout << std::setw(4) << info.hits << "\t" << info.path << std::endl;
+                builtin_out() << std::setw(4) << info.hits << "\t" << info.path << '\n';
             }
         }
 
@@ -255,7 +255,7 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
             {
                 total_hits += info.hits;
             }
-            std::cout << binary_hash_loc.size() << " command(s), " << total_hits << " total hit(s)" << std::endl;
+            builtin_out() << binary_hash_loc.size() << " command(s), " << total_hits << " total hit(s)\n";
         }
 
         last_exit_code = 0;
@@ -275,12 +275,12 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
             found_count++;
             if (terse_format)
             {
-                std::cout << name << "\t" << it->second.path << std::endl;
+                builtin_out() << name << "\t" << it->second.path << '\n';
             }
             else if (verbose)
             {
-                std::cout << "hash: found " << name << " = " << it->second.path 
-                          << " (hits: " << it->second.hits << ")" << std::endl;
+                builtin_out() << "hash: found " << name << " = " << it->second.path 
+                          << " (hits: " << it->second.hits << ")\n";
             }
             continue;
         }
@@ -294,15 +294,15 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
             
             if (terse_format)
             {
-                std::cout << name << "\t" << binary_path << std::endl;
+                builtin_out() << name << "\t" << binary_path << '\n';
             }
             else if (verbose)
             {
-                std::cout << "hash: added " << name << " = " << binary_path << std::endl;
+                builtin_out() << "hash: added " << name << " = " << binary_path << '\n';
             }
             else
             {
-                std::cout << name << " = " << binary_path << std::endl;
+                builtin_out() << name << " = " << binary_path << '\n';
             }
         }
         else
@@ -316,10 +316,10 @@ void handle_builtin_hash(const std::vector<std::string> &tokens)
     if (verbose && !names.empty())
     {
         if (added_count > 0) {
-            std::cout << "hash: added " << added_count << " command(s) to hash table" << std::endl;
+            builtin_out() << "hash: added " << added_count << " command(s) to hash table\n";
         }
         if (found_count > 0) {
-            std::cout << "hash: found " << found_count << " command(s) already in hash table" << std::endl;
+            builtin_out() << "hash: found " << found_count << " command(s) already in hash table\n";
         }
     }
 
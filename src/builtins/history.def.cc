@@ -51,7 +51,7 @@ void handle_builtin_history(const std::vector<std::string> &tokens)
 {
     if (tokens.size() > 1 && (tokens[1] == "--help" || tokens[1] == "-h"))
     {
-        std::cout << "history: history [-c] [-d offset] [n] or history -anrw [filename] or history -ps arg [arg...]\n"
+        builtin_out() << "history: history [-c] [-d offset] [n] or history -anrw [filename] or history -ps arg [arg...]\n"
                   << "    Display or manipulate the history list.\n\n"
                   << "    Options:\n"
                   << "      -c        clear the history list by deleting all of the entries\n"
@@ -156,7 +156,7 @@ void handle_builtin_history(const std::vector<std::string> &tokens)
     if (clear_history)
     {
         clear_history_list();
-        std::cout << "History cleared" << std::endl;
+        builtin_out() << "History cleared\n";
     }
 
     if (delete_entry)
@@ -180,7 +180,7 @@ void handle_builtin_history(const std::vector<std::string> &tokens)
             {
                 free(entry->line);
                 free(entry);
-                std::cout << "Deleted history entry " << (actual_index + 1) << std::endl;
+                builtin_out() << "Deleted history entry " << (actual_index + 1) << '\n';
             }
         }
         else
@@ -227,11 +227,11 @@ void handle_builtin_history(const std::vector<std::string> &tokens)
             {
                 if (result)
                 {
-                    std::cout << expanded << std::endl;
+                    builtin_out() << expanded << '\n';
                 }
                 else
                 {
-                    std::cout << arg << std::endl;
+                    builtin_out() << arg << '\n';
                 }
                 free(expanded);
             }
@@ -285,7 +285,7 @@ void handle_builtin_history(const std::vector<std::string> &tokens)
             HIST_ENTRY *entry = history_get(i + history_base);
             if (entry)
             {
-                std::cout << " " << (i + 1) << "  " << entry->line << std::endl;
+                builtin_out() << " " << (i + 1) << "  " << entry->line << '\n';
             }
         }
         free(hist_state);
@@ -19,6 +19,14 @@
 
 #include "terminal.h"
 #include "execution.h" // validate_and_cleanup_jobs
+#include "events.h"
+#include "job_registry.h"
+#include "job_scheduler.h"
+#include "job_perf.h"
+#include "job_placement.h"
+#include "job_sampler.h"
+#include "job_output.h"
+#include "job_limits.h"
 
 namespace fs = std::filesystem;
 
@@ -34,6 +42,7 @@ struct DisplayJobInfo {
     struct timeval start_tv;
     bool is_current_session;
     std::string session_display_name;
+    std::vector<JobStage> stages; // hanya job session ini
 };
 
 /**
@@ -51,81 +60,20 @@ bool is_job_alive(pid_t pgid) {
  * @brief Memperbarui status job dari sistem process
  */
 void update_job_status_from_system(DisplayJobInfo& job) {
-    if (!is_job_alive(job.pgid)) {
-        job.status = JobStatus::DONE;
+    // Job milik session ini di-update oleh event loop (job_process_changed),
+    // status di job list sudah akurat
+    if (job.is_current_session) {
         return;
     }
 
-    // Periksa status process group dengan lebih akurat
-    int status;
-    pid_t result = waitpid(-job.pgid, &status, WNOHANG | WUNTRACED | WCONTINUED);
-    
-    if (result > 0) {
-        if (WIFEXITED(status)) {
-            job.status = (WEXITSTATUS(status) == 0) ? JobStatus::DONE : JobStatus::EXITED;
-            job.term_status = WEXITSTATUS(status);
-        } else if (WIFSIGNALED(status)) {
-            job.status = JobStatus::SIGNALED;
-            job.term_status = WTERMSIG(status);
-        } else if (WIFSTOPPED(status)) {
-            job.status = JobStatus::STOPPED;
-            job.term_status = WSTOPSIG(status);
-        } else if (WIFCONTINUED(status)) {
-            job.status = JobStatus::RUNNING;
-        }
-    } else if (result == 0) {
-        // Process masih berjalan - cek apakah realmente running atau stopped
-        // Untuk job yang di-stop, biasanya waitpid dengan WUNTRACED akan mengembalikan status stopped
-        if (job.status != JobStatus::STOPPED) {
-            job.status = JobStatus::RUNNING;
-        }
+    if (!is_job_alive(job.pgid)) {
+        job.status = JobStatus::DONE;
+        return;
     }
-}
 
-/**
- * @brief Membaca status job dari file kontrol.
- */
-DisplayJobInfo read_job_controle_file(const fs::path& file_path, int temp_job_id, pid_t current_shell_pid) {
-    DisplayJobInfo info = {};
-    info.job_id = temp_job_id;
-    info.status = JobStatus::UNKNOWN;
-    
-    std::ifstream ifs(file_path);
-    std::string line;
-    while (std::getline(ifs, line)) {
-        size_t eq_pos = line.find('=');
-        if (eq_pos == std::string::npos) continue;
-        
-        std::string key = line.substr(0, eq_pos);
-        std::string value = line.substr(eq_pos + 1);
-        
-        try {
-            if (key == "PGID") info.pgid = std::stoi(value);
-            else if (key == "SHELL_PID") {
-                info.shell_pid = std::stoi(value);
-                info.is_current_session = (info.shell_pid == current_shell_pid);
-            }
-            else if (key == "COMMAND") info.command = value;
-            else if (key == "STATUS") info.status = static_cast<JobStatus>(std::stoi(value));
-            else if (key == "TERM_STATUS") info.term_status = std::stoi(value);
-            else if (key == "RUTIME_SEC") info.usage.ru_utime.tv_sec = std::stoi(value);
-            else if (key == "RUTIME_USEC") info.usage.ru_utime.tv_usec = std::stoi(value);
-            else if (key == "RSTIME_SEC") info.usage.ru_stime.tv_sec = std::stoi(value);
-            else if (key == "RSTIME_USEC") info.usage.ru_stime.tv_usec = std::stoi(value);
-            else if (key == "START_TIME_SEC") info.start_tv.tv_sec = std::stoi(value);
-            else if (key == "START_TIME_USEC") info.start_tv.tv_usec = std::stoi(value);
-        } catch (const std::exception& e) {
-            std::cerr << "nsh: jobs: error parsing control file: " << e.what() << std::endl;
-        }
+    if (job.status != JobStatus::STOPPED) {
+        job.status = JobStatus::RUNNING;
     }
-    
-    if (info.is_current_session) {
-        info.session_display_name = "current";
-    } else {
-        info.session_display_name = std::to_string(info.shell_pid);
-    }
-
-    return info;
 }
 
 /**
@@ -171,6 +119,8 @@ std::vector<DisplayJobInfo> get_all_active_jobs(pid_t current_shell_pid) {
     std::unordered_set<pid_t> seen_pgids;
     int next_display_id = 1;
 
+    check_child_status();
+
     // 1. Process Local Jobs (from 'jobs' map)
     for (const auto& [id, job] : jobs) {
         if (seen_pgids.count(job.pgid)) {
@@ -189,30 +139,54 @@ std::vector<DisplayJobInfo> get_all_active_jobs(pid_t current_shell_pid) {
         info.start_tv = job.start_tv;
         info.is_current_session = true;
         info.session_display_name = "current";
+        info.stages = job.stages;
 
         update_job_status_from_system(info);
         
         all_jobs.push_back(info);
     }
 
-    // 2. Process External Jobs (from control files) - Cross Session
-    fs::path job_dir = ns_CONFIG_DIR / "jobs";
-    if (fs::exists(job_dir)) {
-        for (const auto& entry : fs::directory_iterator(job_dir)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".controle") {
-                DisplayJobInfo info = read_job_controle_file(entry.path(), next_display_id++, current_shell_pid);
-                
-                if (seen_pgids.count(info.pgid)) {
-                    continue;
-                }
-                seen_pgids.insert(info.pgid);
-                
-                update_job_status_from_system(info);
-                
-                if (info.status != JobStatus::DONE && info.status != JobStatus::EXITED && info.status != JobStatus::SIGNALED) {
-                    all_jobs.push_back(info);
-                }
-            }
+    // 1b. Job antrian scheduler: belum di-fork, belum punya PGID
+    for (const QueuedJobInfo& queued : scheduler_queued_jobs()) {
+        DisplayJobInfo info = {};
+        info.job_id = queued.job_id;
+        info.pgid = 0;
+        info.shell_pid = current_shell_pid;
+        info.command = queued.command;
+        info.status = JobStatus::QUEUED;
+        info.is_current_session = true;
+        info.session_display_name = "current";
+        all_jobs.push_back(info);
+    }
+
+    // 2. Process External Jobs (from the shared registry) - Cross Session.
+    //    Snapshot-nya hanya dibaca ulang jika watcher inotify melihat perubahan.
+    for (const RegistryJob& reg : registry_foreign_jobs_cached()) {
+        if (seen_pgids.count(reg.pgid)) {
+            continue;
+        }
+        seen_pgids.insert(reg.pgid);
+
+        DisplayJobInfo info = {};
+        info.job_id = next_display_id++;
+        info.pgid = reg.pgid;
+        info.shell_pid = reg.owner_pid;
+        info.command = reg.command;
+        info.status = reg.status;
+        info.term_status = reg.term_status;
+        info.usage = reg.usage;
+        info.start_tv = reg.start_tv;
+        info.is_current_session = false;
+        info.session_display_name = std::to_string(reg.owner_pid);
+
+        // Shell pemilik yang masih hidup selalu memperbarui slot-nya sendiri;
+        // hanya job yatim yang perlu dicek ke sistem
+        if (!reg.owner_alive) {
+            update_job_status_from_system(info);
+        }
+
+        if (info.status != JobStatus::DONE && info.status != JobStatus::EXITED && info.status != JobStatus::SIGNALED) {
+            all_jobs.push_back(info);
         }
     }
 
@@ -255,6 +229,7 @@ std::string get_ps_like_state(JobStatus status, int job_id) {
         case JobStatus::DONE: state = "Done"; break;
         case JobStatus::EXITED: state = "Exited"; break;
         case JobStatus::SIGNALED: state = "Signaled"; break;
+        case JobStatus::QUEUED: state = "Queued"; break;
         default: state = "Unknown"; break;
     }
     
@@ -292,13 +267,16 @@ std::string get_ps_short_state(JobStatus status, pid_t pgid) {
         case JobStatus::SIGNALED: 
             state = "K"; 
             break;
+        case JobStatus::QUEUED: 
+            state = "Q"; 
+            break;
         default: 
             state = "?"; 
             break;
     }
     
     // Tambahkan indikator foreground/background seperti ps
-    if (fg_pgid == pgid) {
+    if (pgid != 0 && fg_pgid == pgid) {
         state += "+";  // Foreground process group
     } else {
         state += " ";  // Background process group
@@ -349,6 +327,10 @@ int jobspec_to_pgid(const std::string& jobspec, pid_t& pgid_out) {
         int job_id = std::stoi(spec_value);
         for (const auto& job : all_jobs) {
             if (job.job_id == job_id) {
+                if (job.status == JobStatus::QUEUED) {
+                    std::cerr << "nsh: jobspec: " << jobspec << ": job is still queued" << std::endl;
+                    return 1;
+                }
                 pgid_out = job.pgid;
                 return 0;
             }
@@ -360,7 +342,7 @@ int jobspec_to_pgid(const std::string& jobspec, pid_t& pgid_out) {
     // Job Nama/Prefix (%string) - Cross Session
     std::vector<DisplayJobInfo> matching_jobs;
     for (const auto& job : all_jobs) {
-        if (job.command.find(spec_value) != std::string::npos) {
+        if (job.status != JobStatus::QUEUED && job.command.find(spec_value) != std::string::npos) {
             matching_jobs.push_back(job);
         }
     }
@@ -396,6 +378,7 @@ std::string job_status_to_string(JobStatus status, int term_status = 0) {
                 return sig_str;
             }
             return "Terminated";
+        case JobStatus::QUEUED: return "Queued";
         default: return "Unknown";
     }
 }
@@ -413,27 +396,255 @@ std::string format_cpu_time(const struct rusage& usage) {
 }
 
 void show_jobs_help() {
-    std::cout << "Usage: jobs [options]\n"
+    builtin_out() << "Usage: jobs [options]\n"
               << "Displays the status of jobs with navigation indicators.\n\n"
               << "Options:\n"
               << "  -l          Display process IDs and detailed information in ps-like format.\n"
+              << "              Pipelines also list each stage: PID, exit status, CPU time\n"
+              << "              and max RSS.\n"
               << "  -p          Display process IDs only.\n"
               << "  -r          Restrict output to running jobs.\n"
               << "  -s          Restrict output to stopped jobs.\n"
+              << "  -o JOBSPEC  Print the output captured for a background job\n"
+              << "              started with NSH_BG_CAPTURE=1 (last 1M by default).\n"
+              << "  -f JOBSPEC  Like -o, then follow new output until the job\n"
+              << "              closes it or Ctrl-C.\n"
+              << "  --top       Refresh a live view of CPU%, RSS, I/O throughput and\n"
+              << "              thread count per job, sampled from /proc, until Ctrl-C.\n"
+              << "  -d SECS     Seconds between --top refreshes (default 2).\n"
+              << "  -n COUNT    Stop --top after COUNT refreshes.\n"
               << "  --help      Show this help message.\n\n"
               << "Navigation indicators:\n"
               << "  +           Current job (referenced by %% or %%+)\n"
               << "  -           Previous job (referenced by %%-) \n";
 }
 
+// 12.3M, 512K, 0
+static std::string format_top_bytes(double bytes);
+
+/**
+ * @brief Baris per stage di bawah job pipeline pada `jobs -l`: PID, exit
+ *        status, CPU time dan max RSS proses stage itu sendiri.
+ *
+ * Stage yang masih berjalan dibaca dari /proc, stage yang sudah exit dari
+ * rusage wait4-nya. Builtin yang dijalankan di shell tidak punya PID.
+ */
+static void show_job_stages(const DisplayJobInfo& job) {
+    for (const JobStage& stage : job.stages) {
+        std::string state;
+        std::string cpu = "-";
+        std::string rss = "-";
+        struct rusage usage = {};
+        if (stage.finished) {
+            if (WIFSIGNALED(stage.status))
+                state = "signal " + std::to_string(WTERMSIG(stage.status));
+            else
+                state = "exit " + std::to_string(WIFEXITED(stage.status) ? WEXITSTATUS(stage.status) : 0);
+            if (stage.pid != 0) {
+                cpu = format_cpu_time(stage.usage);
+                rss = format_top_bytes(stage.usage.ru_maxrss * 1024.0);
+            }
+        } else if (stage.pid != 0 && sampler_process_usage(stage.pid, usage)) {
+            state = job.status == JobStatus::STOPPED ? "stopped" : "running";
+            cpu = format_cpu_time(usage);
+            rss = format_top_bytes(usage.ru_maxrss * 1024.0);
+        } else {
+            state = "-";
+        }
+        builtin_out() << std::left << std::setw(16) << ""
+                      << std::setw(10) << (stage.pid ? std::to_string(stage.pid) : "-")
+                      << std::setw(12) << state
+                      << std::setw(12) << cpu
+                      << std::setw(8) << rss
+                      << stage.command << '\n';
+    }
+}
+
+static std::string format_top_bytes(double bytes) {
+    const char *units = "KMGT";
+    if (bytes < 1024)
+        return std::to_string(static_cast<long>(bytes));
+    int unit = -1;
+    while (bytes >= 1024 && unit < 3) {
+        bytes /= 1024;
+        unit++;
+    }
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(bytes < 10 ? 1 : 0) << bytes << units[unit];
+    return ss.str();
+}
+
+/**
+ * @brief jobs --top: tampilan live per job, di-refresh di tempat.
+ *
+ * Sample diambil job_sampler (fd /proc tetap terbuka di antara sample);
+ * di antara refresh shell menunggu di event loop, jadi exit job tetap
+ * diproses. Biaya CPU sampler sendiri ditampilkan di header.
+ */
+static void show_jobs_top(double interval, long max_frames) {
+    bool refresh_in_place = isatty(STDOUT_FILENO) && !builtin_out_bound();
+    bool own_terminal = getpgrp() == shell_pgid;
+    if (own_terminal)
+        safe_set_cooked_mode();
+
+    auto tracked_jobs = []() {
+        std::vector<std::pair<int, Job>> list;
+        for (const auto& [id, job] : jobs) {
+            if (job.pgid != 0 && (job.status == JobStatus::RUNNING || job.status == JobStatus::STOPPED))
+                list.emplace_back(id, job);
+        }
+        return list;
+    };
+    auto sample_jobs = [](const std::vector<std::pair<int, Job>>& list, double& cpu_ms) {
+        std::vector<pid_t> pgids;
+        for (const auto& entry : list)
+            pgids.push_back(entry.second.pgid);
+        struct timespec before, after;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &before);
+        auto samples = sampler_sample(pgids);
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &after);
+        cpu_ms = (after.tv_sec - before.tv_sec) * 1e3 + (after.tv_nsec - before.tv_nsec) / 1e6;
+        return samples;
+    };
+
+    double cpu_ms = 0;
+    sample_jobs(tracked_jobs(), cpu_ms); // nilai awal untuk rate
+
+    for (long frame = 0; max_frames == 0 || frame < max_frames; ++frame) {
+        // Tunggu interval di event loop (exit job tetap diproses)
+        struct timespec start, now;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (!received_sigint) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double waited = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+            if (waited >= interval)
+                break;
+            event_loop_run_once(static_cast<int>((interval - waited) * 1000) + 1);
+        }
+        if (received_sigint)
+            break;
+
+        auto list = tracked_jobs();
+        auto samples = sample_jobs(list, cpu_ms);
+        size_t processes = 0;
+        for (const auto& sample : samples)
+            processes += sample.processes;
+
+        std::ostringstream frame_out;
+        if (refresh_in_place)
+            frame_out << "\033[H\033[2J";
+        frame_out << "jobs --top: " << list.size() << " jobs, " << processes << " processes, every "
+                  << std::fixed << std::setprecision(1) << interval << "s, sampler "
+                  << std::setprecision(2) << cpu_ms << " ms CPU ("
+                  << cpu_ms / (interval * 10) << "%)\n\n";
+        frame_out << std::left << std::setw(8) << "JOBID" << std::setw(6) << "STAT"
+                  << std::setw(10) << "PGID" << std::setw(7) << "PROCS" << std::setw(9) << "THREADS"
+                  << std::setw(8) << "CPU%" << std::setw(9) << "RSS" << std::setw(10) << "READ/s"
+                  << std::setw(10) << "WRITE/s" << "COMMAND\n";
+        for (size_t i = 0; i < list.size(); ++i) {
+            const Job& job = list[i].second;
+            const JobSample& sample = samples[i];
+            std::ostringstream cpu;
+            cpu << std::fixed << std::setprecision(1) << sample.cpu_percent;
+            frame_out << std::left << std::setw(8) << "[" + std::to_string(list[i].first) + "]"
+                      << std::setw(6) << get_ps_short_state(job.status, job.pgid)
+                      << std::setw(10) << job.pgid << std::setw(7) << sample.processes
+                      << std::setw(9) << sample.threads << std::setw(8) << cpu.str()
+                      << std::setw(9) << format_top_bytes(static_cast<double>(sample.rss_bytes))
+                      << std::setw(10) << (sample.io_available ? format_top_bytes(sample.read_rate) : "-")
+                      << std::setw(10) << (sample.io_available ? format_top_bytes(sample.write_rate) : "-")
+                      << job.command << '\n';
+        }
+        if (!refresh_in_place)
+            frame_out << '\n';
+        builtin_out() << frame_out.str() << std::flush;
+        // Pembaca sudah pergi (`jobs --top | head -3`, SIGPIPE diabaikan
+        // shell) atau write gagal: berhenti, state stream dipulihkan untuk
+        // output berikutnya
+        if (!builtin_out()) {
+            builtin_out().clear();
+            break;
+        }
+    }
+
+    sampler_reset();
+    if (own_terminal)
+        safe_set_raw_mode();
+}
+
+/**
+ * @brief jobs -o / jobs -f: tampilkan output job yang di-capture
+ *        (NSH_BG_CAPTURE), lalu untuk -f ikuti data baru sampai job menutup
+ *        outputnya atau Ctrl-C.
+ */
+static void show_job_output(const std::string& spec, bool follow) {
+    // Job yang sudah selesai tidak ada di job list, tapi buffernya masih
+    // disimpan sampai "Done" dilaporkan
+    pid_t pgid = 0;
+    if (spec.size() > 1 && spec[0] == '%' && is_string_numeric(spec.substr(1)) &&
+        jobs.count(std::stoi(spec.substr(1))) == 0)
+        pgid = finished_job_pgid(std::stoi(spec.substr(1)));
+    if (pgid == 0 && jobspec_to_pgid(spec, pgid) != 0) {
+        last_exit_code = 1;
+        return;
+    }
+
+    std::string contents;
+    uint64_t dropped = 0;
+    if (!output_capture_contents(pgid, contents, &dropped)) {
+        std::cerr << "nsh: jobs: " << spec << ": no captured output (see NSH_BG_CAPTURE)" << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+    if (dropped > 0)
+        std::cerr << "nsh: jobs: " << spec << ": " << dropped << " earlier bytes dropped" << std::endl;
+    builtin_out() << contents << std::flush;
+    if (!follow)
+        return;
+
+    bool own_terminal = getpgrp() == shell_pgid;
+    if (own_terminal)
+        safe_set_cooked_mode();
+    output_capture_follow(pgid, [](const char* data, size_t length) {
+        builtin_out().write(data, static_cast<std::streamsize>(length));
+        builtin_out().flush();
+    });
+    while (!received_sigint && output_capture_active(pgid))
+        event_loop_run_once(-1);
+    output_capture_follow(pgid, nullptr);
+    if (own_terminal)
+        safe_set_raw_mode();
+}
+
 void handle_builtin_jobs(const std::vector<std::string>& tokens) {
     bool list_details = false;
     bool list_pgid_only = false;
     bool running_only = false;
     bool stopped_only = false;
+    bool top = false;
+    double top_interval = 2.0;
+    long top_frames = 0;
 
     for (size_t i = 1; i < tokens.size(); ++i) {
-        if (tokens[i] == "-l") {
+        if (tokens[i] == "--top") {
+            top = true;
+        } else if ((tokens[i] == "-o" || tokens[i] == "-f") && i + 1 < tokens.size()) {
+            show_job_output(tokens[i + 1], tokens[i] == "-f");
+            return;
+        } else if ((tokens[i] == "-d" || tokens[i] == "-n") && i + 1 < tokens.size()) {
+            char *end = nullptr;
+            double value = strtod(tokens[i + 1].c_str(), &end);
+            if (*end != '\0' || value <= 0 || (tokens[i] == "-n" && value != static_cast<long>(value))) {
+                std::cerr << "nsh: jobs: " << tokens[i] << ": invalid value `" << tokens[i + 1] << "'" << std::endl;
+                last_exit_code = 1;
+                return;
+            }
+            if (tokens[i] == "-d")
+                top_interval = std::max(value, 0.1);
+            else
+                top_frames = static_cast<long>(value);
+            ++i;
+        } else if (tokens[i] == "-l") {
             list_details = true;
         } else if (tokens[i] == "-p") {
             list_pgid_only = true;
@@ -451,6 +662,11 @@ void handle_builtin_jobs(const std::vector<std::string>& tokens) {
         }
     }
 
+    if (top) {
+        show_jobs_top(top_interval, top_frames);
+        return;
+    }
+
     pid_t current_shell_pid = getpid();
     auto all_jobs = get_all_active_jobs(current_shell_pid);
 
@@ -472,20 +688,24 @@ void handle_builtin_jobs(const std::vector<std::string>& tokens) {
 
     if (list_pgid_only) {
         for (const auto& job : filtered_jobs) {
-            std::cout << job.pgid << std::endl;
+            if (job.status != JobStatus::QUEUED)
+                builtin_out() << job.pgid << '\n';
         }
         return;
     }
 
     // Format output ps-like untuk opsi -l
     if (list_details) {
-        std::cout << std::left << std::setw(8) << "JOBID" 
+        builtin_out() << std::left << std::setw(8) << "JOBID" 
                   << std::setw(8) << "STAT"
                   << std::setw(10) << "PGID"
                   << std::setw(12) << "SESSION"
                   << std::setw(12) << "CPU Time" 
                   << std::setw(8) << "CPU%"
-                  << "COMMAND" << std::endl;
+                  << std::setw(6) << "IPC"
+                  << std::setw(24) << "PLACEMENT"
+                  << std::setw(24) << "LIMITS"
+                  << "COMMAND\n";
         
         for (const auto& job : filtered_jobs) {
             std::string job_id_str = "[" + std::to_string(job.job_id) + "]";
@@ -495,18 +715,30 @@ void handle_builtin_jobs(const std::vector<std::string>& tokens) {
                 job_id_str += "-";
             }
             
-            std::cout << std::left << std::setw(8) << job_id_str;
-            std::cout << std::setw(8) << get_ps_short_state(job.status, job.pgid);
-            std::cout << std::setw(10) << job.pgid;
-            std::cout << std::setw(12) << job.session_display_name;
-            std::cout << std::setw(12) << format_cpu_time(job.usage);
+            builtin_out() << std::left << std::setw(8) << job_id_str;
+            builtin_out() << std::setw(8) << get_ps_short_state(job.status, job.pgid);
+            builtin_out() << std::setw(10) << (job.pgid ? std::to_string(job.pgid) : "-");
+            builtin_out() << std::setw(12) << job.session_display_name;
+            builtin_out() << std::setw(12) << format_cpu_time(job.usage);
             
             if (job.status == JobStatus::RUNNING) {
-                std::cout << std::setw(8) << format_cpu_percentage(job.usage, job.start_tv);
+                builtin_out() << std::setw(8) << format_cpu_percentage(job.usage, job.start_tv);
             } else {
-                std::cout << std::setw(8) << "0.0%";
+                builtin_out() << std::setw(8) << "0.0%";
             }
-            std::cout << job.command << std::endl;
+            // IPC dari counter perf job (NSH_PERF_COUNTERS=1), "-" tanpa PMU
+            builtin_out() << std::setw(6) << perf_ipc(job.pgid);
+            // Placement efektif pemimpin group, dibaca dari kernel
+            std::string placement = job.status == JobStatus::RUNNING || job.status == JobStatus::STOPPED
+                                        ? placement_describe(job.pgid) : "-";
+            builtin_out() << std::setw(24) << placement + " ";
+            // Resource limit (`limit ... -- cmd`) yang berbeda dari shell
+            std::string limits = job.status == JobStatus::RUNNING || job.status == JobStatus::STOPPED
+                                     ? limits_describe(job.pgid) : "-";
+            builtin_out() << std::setw(24) << limits + " ";
+            builtin_out() << job.command << '\n';
+            if (job.stages.size() > 1)
+                show_job_stages(job);
         }
         return;
     }
@@ -520,13 +752,13 @@ void handle_builtin_jobs(const std::vector<std::string>& tokens) {
             job_id_str += "-";
         }
         
-        std::cout << job_id_str
+        builtin_out() << job_id_str
                   << "\t" << job_status_to_string(job.status, job.term_status)
                   << "\t\t" << job.command;
         if (!job.is_current_session) {
-            std::cout << " (session: " << job.session_display_name << ")";
+            builtin_out() << " (session: " << job.session_display_name << ")";
         }
-        std::cout << std::endl;
+        builtin_out() << '\n';
     }
 }
 
@@ -705,6 +937,19 @@ void handle_builtin_kill(const std::vector<std::string> &tokens) {
         int kill_result = -1;
         pid_t pgid_to_kill = 0;
 
+        // Job antrian scheduler belum punya proses: sinyal apa pun membatalkannya
+        if (target[0] == '%' && is_string_numeric(target.substr(1)) &&
+            scheduler_cancel(std::stoi(target.substr(1)))) {
+            int queued_id = std::stoi(target.substr(1));
+            Job cancelled = {};
+            cancelled.command = target;
+            cancelled.status = JobStatus::SIGNALED;
+            cancelled.term_status = signal_num;
+            finished_jobs.emplace_back(queued_id, cancelled);
+            builtin_out() << "Job " << target << " removed from queue\n";
+            continue;
+        }
+
         if (target[0] == '%') {
             // --- EKSPANSI JOBSPEC ---
             if (jobspec_to_pgid(target, pgid_to_kill) == 0) {
@@ -793,6 +1038,13 @@ void handle_builtin_bg(const std::vector<std::string>& tokens) {
     std::string jobspec = (tokens.size() > 1) ? tokens[1] : "%+";
     pid_t pgid_out = 0;
 
+    // bg pada job antrian: jalankan sekarang tanpa menunggu slot scheduler
+    if (jobspec.size() > 1 && jobspec[0] == '%' && is_string_numeric(jobspec.substr(1)) &&
+        scheduler_start_now(std::stoi(jobspec.substr(1)))) {
+        last_exit_code = 0;
+        return;
+    }
+
     if (jobspec_to_pgid(jobspec, pgid_out) != 0) {
         // jobspec_to_pgid sudah menampilkan pesan error
         last_exit_code = 1;
@@ -826,13 +1078,7 @@ void handle_builtin_bg(const std::vector<std::string>& tokens) {
     }
 
     // Cari job di local jobs map untuk modifikasi
-    Job* job_ptr = nullptr;
-    for (auto& [id, job] : jobs) {
-        if (job.pgid == pgid_out) {
-            job_ptr = &job;
-            break;
-        }
-    }
+    Job* job_ptr = find_job_by_pgid(pgid_out);
 
     if (job_ptr) {
         if (job_ptr->status == JobStatus::RUNNING) {
@@ -847,6 +1093,7 @@ void handle_builtin_bg(const std::vector<std::string>& tokens) {
             last_exit_code = 1;
         } else {
             job_ptr->status = JobStatus::RUNNING;
+            mark_job_dirty(pgid_out);
             std::cout << "[" << job_info->job_id << "]+ " << job_ptr->command << " &" << std::endl;
             last_exit_code = 0;
         }
@@ -903,15 +1150,8 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
         return;
     }
 
-    Job* job_ptr = nullptr;
     int job_id = -1;
-    for (auto& [id, job] : jobs) {
-        if (job.pgid == pgid_out) {
-            job_ptr = &job;
-            job_id = id;
-            break;
-        }
-    }
+    Job* job_ptr = find_job_by_pgid(pgid_out, &job_id);
 
     if (!job_ptr) {
         std::cerr << "nsh: fg: job not found in current session: " << jobspec << std::endl;
@@ -940,12 +1180,6 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
     sigaddset(&mask, SIGTTIN);
     sigprocmask(SIG_BLOCK, &mask, &old_mask);
 
-    // Simpan juga mask SIGCHLD (dari V1)
-    sigset_t mask_sigchld;
-    sigemptyset(&mask_sigchld);
-    sigaddset(&mask_sigchld, SIGCHLD);
-    sigprocmask(SIG_BLOCK, &mask_sigchld, nullptr);
-
     // Simpan terminal mode global shell
     struct termios global_shell_tmodes = shell_tmodes;
 
@@ -958,6 +1192,7 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
             return;
         }
         job_ptr->status = JobStatus::RUNNING;
+        mark_job_dirty(job_ptr->pgid);
     }
 
     // Set foreground_pgid SEBELUM beri terminal
@@ -981,58 +1216,22 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
     // Restore terminal mode SETELAH tcsetpgrp
     restore_terminal_mode();
 
-    // Restore signal mask
+    // Restore signal mask (SIGCHLD tetap diblok, dibaca event loop)
     sigprocmask(SIG_SETMASK, &old_mask, NULL);
-    sigprocmask(SIG_UNBLOCK, &mask_sigchld, NULL);
 
     // === [V1: Wait loop dan handling status job] ===
 
-    int status;
-    pid_t w;
-    bool job_completed = false;
-    bool job_stopped = false;
+    // Tunggu di event loop sampai job stop atau semua prosesnya selesai
+    int status = event_loop_wait_group(job_ptr->pgid);
+    bool job_stopped = WIFSTOPPED(status);
+    bool job_completed = !job_stopped;
 
-    int wait_timeout = 0;
-    const int MAX_WAIT_RETRIES = 3;
-    
-    do {
-        w = waitpid(-job_ptr->pgid, &status, WUNTRACED | WCONTINUED);
-        
-        if (w == -1) {
-            if (errno == EINTR) {
-                if (received_sigint) {
-                    std::cout << std::endl;
-                    received_sigint = 0;
-                    break;
-                }
-                continue;
-            } else if (errno == ECHILD) {
-                job_completed = true;
-                break;
-            } else {
-                if (wait_timeout < MAX_WAIT_RETRIES) {
-                    wait_timeout++;
-                    usleep(100000);
-                    continue;
-                }
-                perror("nsh: fg: waitpid");
-                break;
-            }
-        }
-
-        if (WIFSTOPPED(status)) {
-            job_ptr->status = JobStatus::STOPPED;
-            job_ptr->term_status = WSTOPSIG(status);
-            job_stopped = true;
-            std::cout << "\n[" << job_id << "]+  Stopped\t\t" << job_ptr->command << std::endl;
-            break;
-        } else if (WIFCONTINUED(status)) {
-            job_ptr->status = JobStatus::RUNNING;
-        } else if (WIFEXITED(status) || WIFSIGNALED(status)) {
-            job_completed = true;
-            break;
-        }
-    } while (!job_completed && !job_stopped);
+    if (job_stopped) {
+        job_ptr->status = JobStatus::STOPPED;
+        job_ptr->term_status = WSTOPSIG(status);
+        mark_job_dirty(job_ptr->pgid);
+        std::cout << "\n[" << job_id << "]+  Stopped\t\t" << job_ptr->command << std::endl;
+    }
 
     // === [V2: Perbaikan terminal restore] ===
     foreground_pgid = 0;
@@ -1061,7 +1260,7 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
         last_exit_code = exit_code;
 
         if (job_completed) {
-            jobs.erase(job_id);
+            remove_job(job_id);
             if (current_job_id == job_id) {
                 current_job_id = previous_job_id;
             }
@@ -1074,7 +1273,7 @@ void handle_builtin_fg(const std::vector<std::string>& tokens) {
         std::cout << "\n[" << job_id << "]+  Terminated\t" 
                   << strsignal(WTERMSIG(status)) << "\t\t" << job_ptr->command << std::endl;
         
-        jobs.erase(job_id);
+        remove_job(job_id);
         if (current_job_id == job_id) {
             current_job_id = previous_job_id;
         }
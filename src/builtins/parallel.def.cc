@@ -0,0 +1,559 @@
+// builtins/parallel.def.cc
+
+#include "execution.h"
+#include "events.h"
+#include "globals.h"
+#include "parser.h"
+#include "terminal.h"
+#include "utils.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+static void show_parallel_help()
+{
+    builtin_out() << "parallel: parallel [-j N] [-g] [-k] COMMAND [::: ARG ...]\n"
+                  << "    Run COMMAND once per ARG, up to N at a time.\n\n"
+                  << "    COMMAND is parsed once; every `{}' in it is replaced by the ARG of\n"
+                  << "    that run (ARG is appended when COMMAND has no `{}'). ARG is put in\n"
+                  << "    after COMMAND has been expanded, so it is used literally: it is\n"
+                  << "    never expanded, split or globbed (`{}' inside <(...) and >(...) is\n"
+                  << "    left alone). Without `:::' the ARGs are read from standard input,\n"
+                  << "    one per line. Each run gets its own process group and standard\n"
+                  << "    input from /dev/null; a simple command is executed directly, a\n"
+                  << "    builtin, pipeline or list runs in a forked copy of the shell.\n\n"
+                  << "    Options:\n"
+                  << "      -j, --jobs N       run at most N commands at once (default: number\n"
+                  << "                         of CPUs, 0: no limit)\n"
+                  << "      -g, --group        print the output of a run in one piece when it\n"
+                  << "                         finishes, never interleaved with other runs\n"
+                  << "      -k, --keep-order   like --group, in the order of the ARGs\n\n"
+                  << "    The exit status of each run is stored in PARALLEL_STATUS (in ARG\n"
+                  << "    order, separated by spaces).\n\n"
+                  << "    Exit Status:\n"
+                  << "    The number of failed runs (at most 101); 130 if interrupted; 2 on\n"
+                  << "    usage error.\n";
+}
+
+// Satu run yang sedang berjalan
+struct ParallelWorker {
+    size_t index;       // posisi ARG
+    int out_fd = -1;    // read end output (mode group), -1 jika langsung ke stdout
+    bool exited = false;
+    int status = 0;
+};
+
+static void replace_placeholder(std::string &text, const std::string &item)
+{
+    size_t pos = 0;
+    while ((pos = text.find("{}", pos)) != std::string::npos)
+    {
+        text.replace(pos, 2, item);
+        pos += item.size();
+    }
+}
+
+static bool has_placeholder(const std::vector<ParsedCommand> &commands)
+{
+    for (const auto &group : commands)
+    {
+        for (const auto &cmd : group.pipeline)
+        {
+            for (size_t i = 0; i < cmd.tokens.size(); ++i)
+                if (!cmd.process_substitutions.count(i) && cmd.tokens[i].find("{}") != std::string::npos)
+                    return true;
+            for (const auto &redir : cmd.redirections)
+                if (!redir.process_substitution && redir.target_file.find("{}") != std::string::npos)
+                    return true;
+            for (const auto &[name, value] : cmd.env_vars)
+                if (value.find("{}") != std::string::npos)
+                    return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Masukkan ARG ke AST yang sudah di-expand (expand_command_group).
+ *
+ * ARG menggantikan setiap `{}' (token, target redirection, nilai variabel),
+ * atau ditambahkan sebagai argumen terakhir command terakhir. Expansion
+ * sudah selesai, jadi ARG tetap teks literal: `$(...)', `$VAR' dan `*' di
+ * dalam ARG tidak dijalankan. <(cmd)/>(cmd) berisi kode shell yang masih
+ * akan di-parse, jadi tidak disentuh.
+ */
+static void substitute_item(std::vector<ParsedCommand> &commands, const std::string &item, bool placeholder)
+{
+    if (!placeholder)
+    {
+        commands.back().pipeline.back().tokens.push_back(item);
+        return;
+    }
+    for (auto &group : commands)
+    {
+        for (auto &cmd : group.pipeline)
+        {
+            for (size_t i = 0; i < cmd.tokens.size(); ++i)
+                if (!cmd.process_substitutions.count(i))
+                    replace_placeholder(cmd.tokens[i], item);
+            for (auto &redir : cmd.redirections)
+                if (!redir.process_substitution)
+                    replace_placeholder(redir.target_file, item);
+            for (auto &[name, value] : cmd.env_vars)
+                replace_placeholder(value, item);
+        }
+    }
+}
+
+// Command eksternal tunggal: child run meng-exec-nya langsung tanpa
+// execute_job (yang akan fork sekali lagi)
+static bool runs_directly(const std::vector<ParsedCommand> &commands)
+{
+    if (commands.size() != 1 || commands[0].pipeline.size() != 1 || commands[0].background)
+        return false;
+    const SimpleCommand &cmd = commands[0].pipeline[0];
+    if (cmd.tokens.empty() || is_builtin(cmd.tokens[0]) || commands[0].timed || cmd.tokens[0] == "limit")
+        return false;
+    if (!cmd.process_substitutions.empty())
+        return false;
+    for (const auto &redir : cmd.redirections)
+        if (redir.process_substitution)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Gabungkan kata-kata COMMAND menjadi satu baris untuk Parser::parse.
+ *
+ * Satu kata dipakai apa adanya (`parallel 'gzip {} | wc -c'`); dari beberapa
+ * kata, kata yang berisi spasi atau karakter shell dikutip lagi supaya
+ * `sh -c 'exit {}'` tetap satu argumen setelah di-parse ulang.
+ */
+static std::string join_command_words(const std::vector<std::string> &tokens, size_t begin, size_t end)
+{
+    if (end - begin == 1)
+        return tokens[begin];
+
+    std::string text;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const std::string &word = tokens[i];
+        if (!text.empty())
+            text += ' ';
+        if (!word.empty() && word.find_first_of(" \t\n'\"\\|&;<>()$`*?[]#~") == std::string::npos)
+        {
+            text += word;
+            continue;
+        }
+        // Parser tidak mengenal escape di dalam kutipan: kata dengan ' dikutip "
+        char quote = word.find('\'') == std::string::npos ? '\'' : '"';
+        text += quote;
+        text += word;
+        text += quote;
+    }
+    return text;
+}
+
+// ARG dari stdin, satu per baris; dibaca langsung dari fd 0 (std::cin bisa
+// berisi sisa script milik shell)
+static std::vector<std::string> read_items_from_stdin()
+{
+    std::vector<std::string> items;
+    std::string data;
+    char buffer[8192];
+    while (true)
+    {
+        ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        data.append(buffer, n);
+    }
+
+    size_t start = 0;
+    while (start < data.size())
+    {
+        size_t end = data.find('\n', start);
+        if (end == std::string::npos)
+            end = data.size();
+        if (end > start)
+            items.push_back(data.substr(start, end - start));
+        start = end + 1;
+    }
+    return items;
+}
+
+/**
+ * @brief Fork satu run. Child meng-expand COMMAND, memasukkan ARG, lalu
+ *        meng-exec command sederhana langsung; builtin, pipeline dan list
+ *        dijalankan execute_command_list di child tanpa expansion ulang.
+ * @param item ARG run ini, nullptr jika tidak ada (every)
+ * @return PID child, -1 jika fork gagal.
+ */
+static pid_t spawn_parallel_run(const std::vector<ParsedCommand> &commands, const std::string *item,
+                                bool placeholder, bool capture, int &out_fd)
+{
+    int out_pipe[2] = {-1, -1};
+    out_fd = -1;
+    if (capture && pipe2(out_pipe, O_CLOEXEC) < 0)
+    {
+        std::cerr << "nsh: parallel: pipe: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    builtin_out().flush();
+    std::cout.flush();
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "nsh: parallel: fork: " << strerror(errno) << std::endl;
+        if (capture)
+        {
+            close(out_pipe[0]);
+            close(out_pipe[1]);
+        }
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        // Setiap run adalah group sendiri (Ctrl-C diteruskan shell lewat
+        // kill ke group); command di dalamnya tidak mengambil alih terminal
+        in_helper_child = true;
+        setpgid(0, 0);
+        for (int sig : {SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD, SIGPIPE})
+            signal(sig, SIG_DFL);
+
+        int null_fd = open("/dev/null", O_RDONLY);
+        if (null_fd >= 0)
+        {
+            dup2(null_fd, STDIN_FILENO);
+            close(null_fd);
+        }
+        if (capture)
+        {
+            dup2(out_pipe[1], STDOUT_FILENO);
+            close(out_pipe[0]);
+            close(out_pipe[1]);
+        }
+
+        std::vector<ParsedCommand> run = commands;
+        for (auto &group : run)
+            expand_command_group(group);
+        if (item)
+            substitute_item(run, *item, placeholder);
+
+        if (runs_directly(run))
+        {
+            SimpleCommand &cmd = run[0].pipeline[0];
+            std::string name = cmd.tokens[0];
+            std::string binary = name.find('/') != std::string::npos ? name : find_binary(name);
+            if (binary.empty())
+            {
+                std::cerr << "nsh: " << name << ": command not found" << std::endl;
+                _exit(127);
+            }
+            cmd.tokens[0] = binary;
+            launch_process(0, cmd, true, name); // exec, tidak kembali
+        }
+
+        int code = execute_command_list(run, true, true);
+        builtin_out().flush();
+        std::cout.flush();
+        // _exit, bukan exit(): lihat start_process_substitution
+        _exit(code);
+    }
+
+    setpgid(pid, pid);
+    event_loop_track_child(pid, pid, true);
+
+    if (capture)
+    {
+        close(out_pipe[1]);
+        out_fd = fcntl(out_pipe[0], F_DUPFD_CLOEXEC, 10);
+        if (out_fd < 0)
+            out_fd = out_pipe[0];
+        else
+            close(out_pipe[0]);
+        fcntl(out_fd, F_SETFL, O_NONBLOCK);
+    }
+    return pid;
+}
+
+/**
+ * @brief Builtin parallel: map COMMAND ke setiap ARG dengan worker pool.
+ *
+ * COMMAND di-parse sekali; setiap run menyalin AST, meng-expand-nya lalu
+ * mengganti `{}' dengan ARG sebagai teks literal.
+ * Paling banyak N run hidup bersamaan, run berikutnya dimulai dari event exit
+ * child di event loop shell (pidfd), output mode group dikumpulkan dari pipe
+ * di loop yang sama.
+ */
+void handle_builtin_parallel(const std::vector<std::string> &tokens)
+{
+    long max_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    bool group_output = false;
+    bool keep_order = false;
+
+    size_t i = 1;
+    for (; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (token == "--")
+        {
+            ++i;
+            break;
+        }
+        if (token.empty() || token[0] != '-' || token == "-")
+            break;
+        if (token == "--help" || token == "-h")
+        {
+            show_parallel_help();
+            last_exit_code = 0;
+            return;
+        }
+        if (token == "-g" || token == "--group")
+        {
+            group_output = true;
+        }
+        else if (token == "-k" || token == "--keep-order")
+        {
+            group_output = true;
+            keep_order = true;
+        }
+        else if (token == "-j" || token == "--jobs" || token.rfind("-j", 0) == 0 || token.rfind("--jobs=", 0) == 0)
+        {
+            std::string value;
+            if (token == "-j" || token == "--jobs")
+            {
+                if (i + 1 >= tokens.size())
+                {
+                    std::cerr << "nsh: parallel: " << token << ": option requires an argument" << std::endl;
+                    last_exit_code = 2;
+                    return;
+                }
+                value = tokens[++i];
+            }
+            else
+            {
+                value = token.substr(token[1] == 'j' ? 2 : 7);
+            }
+            if (!is_string_numeric(value))
+            {
+                std::cerr << "nsh: parallel: " << value << ": invalid number of jobs" << std::endl;
+                last_exit_code = 2;
+                return;
+            }
+            max_jobs = std::stol(value);
+        }
+        else
+        {
+            std::cerr << "nsh: parallel: " << token << ": invalid option" << std::endl;
+            std::cerr << "parallel: usage: parallel [-j N] [-g] [-k] COMMAND [::: ARG ...]" << std::endl;
+            last_exit_code = 2;
+            return;
+        }
+    }
+    if (max_jobs <= 0)
+        max_jobs = LONG_MAX;
+
+    size_t command_begin = i;
+    std::vector<std::string> items;
+    bool items_given = false;
+    for (; i < tokens.size(); ++i)
+    {
+        if (tokens[i] == ":::")
+        {
+            items.assign(tokens.begin() + i + 1, tokens.end());
+            items_given = true;
+            break;
+        }
+    }
+
+    if (i == command_begin)
+    {
+        std::cerr << "nsh: parallel: missing command" << std::endl;
+        std::cerr << "parallel: usage: parallel [-j N] [-g] [-k] COMMAND [::: ARG ...]" << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+
+    std::vector<ParsedCommand> commands;
+    try
+    {
+        Parser parser;
+        commands = parser.parse(join_command_words(tokens, command_begin, i));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "nsh: parallel: " << e.what() << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+    if (commands.empty() || commands.back().pipeline.empty())
+    {
+        std::cerr << "nsh: parallel: missing command" << std::endl;
+        last_exit_code = 2;
+        return;
+    }
+    bool placeholder = has_placeholder(commands);
+
+    if (!items_given)
+        items = read_items_from_stdin();
+
+    std::vector<int> statuses(items.size(), 0);
+    std::vector<std::string> outputs(keep_order ? items.size() : 0);
+    std::vector<bool> done(items.size(), false);
+    std::map<pid_t, ParallelWorker> workers;
+    size_t next_item = 0;
+    size_t next_output = 0; // keep-order: ARG berikutnya yang boleh dicetak
+    std::map<pid_t, std::string> captured; // output run yang belum selesai
+    bool interrupted = false;
+    bool spawn_failed = false;
+
+    // Kosongkan pipe output run; false setelah EOF
+    auto drain_output = [&](pid_t pid, ParallelWorker &worker) {
+        char buffer[8192];
+        while (worker.out_fd >= 0)
+        {
+            ssize_t n = read(worker.out_fd, buffer, sizeof(buffer));
+            if (n > 0)
+            {
+                captured[pid].append(buffer, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno == EAGAIN)
+                return;
+            event_loop_remove_fd(worker.out_fd);
+            close(worker.out_fd);
+            worker.out_fd = -1;
+        }
+    };
+
+    auto emit = [&](const std::string &text) {
+        if (!text.empty())
+            builtin_out() << text << std::flush;
+    };
+
+    // Run selesai: simpan status, cetak output sesuai mode
+    auto finish_worker = [&](pid_t pid, ParallelWorker &worker) {
+        size_t index = worker.index;
+        statuses[index] = WIFSIGNALED(worker.status) ? 128 + WTERMSIG(worker.status)
+                                                      : (WIFEXITED(worker.status) ? WEXITSTATUS(worker.status) : 0);
+        done[index] = true;
+        if (keep_order)
+        {
+            outputs[index] = std::move(captured[pid]);
+            while (next_output < items.size() && done[next_output])
+            {
+                emit(outputs[next_output]);
+                std::string().swap(outputs[next_output]);
+                next_output++;
+            }
+        }
+        else if (group_output)
+        {
+            emit(captured[pid]);
+        }
+        captured.erase(pid);
+    };
+
+    safe_set_cooked_mode();
+
+    while (true)
+    {
+        while (!interrupted && !spawn_failed && next_item < items.size() &&
+               workers.size() < static_cast<size_t>(max_jobs))
+        {
+            size_t index = next_item++;
+            int out_fd = -1;
+            pid_t pid = spawn_parallel_run(commands, &items[index], placeholder, group_output, out_fd);
+            if (pid < 0)
+            {
+                statuses[index] = 1;
+                done[index] = true;
+                spawn_failed = true;
+                break;
+            }
+            ParallelWorker &worker = workers[pid];
+            worker.index = index;
+            worker.out_fd = out_fd;
+            if (out_fd >= 0)
+            {
+                event_loop_add_fd(out_fd, EPOLLIN, [&, pid](uint32_t) {
+                    auto it = workers.find(pid);
+                    if (it != workers.end())
+                        drain_output(pid, it->second);
+                });
+            }
+        }
+
+        if (workers.empty())
+            break;
+
+        event_loop_run_once(-1);
+
+        if (received_sigint && !interrupted)
+        {
+            interrupted = true;
+            for (const auto &[pid, worker] : workers)
+                kill(-pid, SIGINT);
+        }
+
+        for (auto it = workers.begin(); it != workers.end();)
+        {
+            pid_t pid = it->first;
+            ParallelWorker &worker = it->second;
+            if (!worker.exited)
+                worker.exited = event_loop_child_exited(pid, &worker.status);
+            // Output masih bisa tersisa di pipe setelah exit
+            if (worker.exited && worker.out_fd >= 0)
+                drain_output(pid, worker);
+            if (!worker.exited || worker.out_fd >= 0)
+            {
+                ++it;
+                continue;
+            }
+            finish_worker(pid, worker);
+            it = workers.erase(it);
+        }
+    }
+
+    safe_set_raw_mode();
+
+    // keep-order: run yang gagal di-fork tidak menghentikan output berikutnya
+    for (; keep_order && next_output < items.size() && done[next_output]; ++next_output)
+        emit(outputs[next_output]);
+
+    std::string status_list;
+    size_t failed = 0;
+    for (size_t k = 0; k < next_item; ++k)
+    {
+        if (!status_list.empty())
+            status_list += ' ';
+        status_list += std::to_string(statuses[k]);
+        if (statuses[k] != 0)
+            failed++;
+    }
+    set_env_var("PARALLEL_STATUS", status_list, false);
+
+    if (interrupted)
+        last_exit_code = 130;
+    else
+        last_exit_code = static_cast<int>(std::min<size_t>(failed + (items.size() - next_item), 101));
+}
@@ -9,7 +9,7 @@ void handle_builtin_pwd(const std::vector<std::string> &tokens)
             physical = false;
         else if (tokens[i] == "--help")
         {
-            std::cout << "pwd: pwd [-L|-P]\n    Print the name of the current working directory.\n\n"
+            builtin_out() << "pwd: pwd [-L|-P]\n    Print the name of the current working directory.\n\n"
                       << "    -L    print the value of $PWD if it names the current working directory\n"
                       << "    -P    print the physical directory, without any symbolic links\n";
             last_exit_code = 0;
@@ -27,7 +27,7 @@ void handle_builtin_pwd(const std::vector<std::string> &tokens)
     {
         try
         {
-            safe_print(fs::current_path().string());
+            safe_print(fs::current_path().string(), builtin_out());
         }
         catch (const fs::filesystem_error &e)
         {
@@ -37,7 +37,7 @@ void handle_builtin_pwd(const std::vector<std::string> &tokens)
     }
     else
     {
-        safe_print(LOGICAL_PWD.string());
+        safe_print(LOGICAL_PWD.string(), builtin_out());
     }
     last_exit_code = 0;
 }
\ No newline at end of file
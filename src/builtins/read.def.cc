@@ -0,0 +1,188 @@
+#include "execution.h"
+#include "terminal.h"
+#include "globals.h"
+#include "utils.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <string>
+
+// Baca satu baris byte per byte: dari pipe/coproc tidak boleh membaca
+// melewati newline, sisa data milik pembaca berikutnya.
+// Return false jika EOF/error sebelum newline.
+static bool read_line_from_fd(int fd, bool raw, std::string &line)
+{
+    line.clear();
+    char c;
+    while (true)
+    {
+        ssize_t n = read(fd, &c, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        if (!raw && c == '\\')
+        {
+            ssize_t m;
+            do {
+                m = read(fd, &c, 1);
+            } while (m < 0 && errno == EINTR);
+            if (m <= 0)
+                return false;
+            if (c != '\n') // backslash-newline: lanjut ke baris berikutnya
+                line += c;
+            continue;
+        }
+        if (c == '\n')
+            return true;
+        line += c;
+    }
+}
+
+// Pecah baris berdasarkan IFS; field terakhir menerima sisa baris
+static std::vector<std::string> split_read_fields(const std::string &line, size_t count)
+{
+    const char *ifs_env = get_env_var("IFS");
+    std::string ifs = ifs_env ? ifs_env : " \t\n";
+    auto is_ifs_space = [&](char c) { return ifs.find(c) != std::string::npos && isspace(static_cast<unsigned char>(c)); };
+    auto is_ifs = [&](char c) { return ifs.find(c) != std::string::npos; };
+
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos < line.size() && is_ifs_space(line[pos]))
+        pos++;
+
+    while (pos < line.size() && fields.size() + 1 < count)
+    {
+        size_t end = pos;
+        while (end < line.size() && !is_ifs(line[end]))
+            end++;
+        fields.push_back(line.substr(pos, end - pos));
+
+        pos = end;
+        while (pos < line.size() && is_ifs_space(line[pos]))
+            pos++;
+        if (pos < line.size() && is_ifs(line[pos]) && !is_ifs_space(line[pos]))
+        {
+            pos++;
+            while (pos < line.size() && is_ifs_space(line[pos]))
+                pos++;
+        }
+    }
+
+    if (fields.size() < count)
+    {
+        std::string rest = pos < line.size() ? line.substr(pos) : "";
+        size_t last = rest.size();
+        while (last > 0 && is_ifs_space(rest[last - 1]))
+            last--;
+        fields.push_back(rest.substr(0, last));
+    }
+    return fields;
+}
+
+/**
+ * @brief Builtin read: baca satu baris dari stdin (atau -u FD) ke variabel.
+ */
+void handle_builtin_read(const std::vector<std::string> &tokens)
+{
+    bool raw = false;
+    int fd = STDIN_FILENO;
+    std::string prompt;
+    std::vector<std::string> names;
+
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (token == "--help" || token == "-h")
+        {
+            builtin_out() << "read: read [-r] [-u fd] [-p prompt] [name ...]\n"
+                          << "    Read a line from the standard input and split it into fields.\n\n"
+                          << "    The line is split into fields using the characters in IFS; the\n"
+                          << "    first field is assigned to the first NAME, the second to the second\n"
+                          << "    NAME, and so on, with the last NAME receiving the rest of the line.\n"
+                          << "    If no NAMEs are supplied, the line is stored in the REPLY variable.\n\n"
+                          << "    Options:\n"
+                          << "      -r        do not allow backslashes to escape any characters\n"
+                          << "      -u fd     read from file descriptor FD instead of the standard input\n"
+                          << "      -p prompt output the string PROMPT without a trailing newline before\n"
+                          << "                attempting to read\n\n"
+                          << "    Exit Status:\n"
+                          << "    The return code is zero, unless end-of-file is encountered or an\n"
+                          << "    invalid file descriptor is supplied as the argument to -u.\n";
+            last_exit_code = 0;
+            return;
+        }
+        if (token == "-r")
+        {
+            raw = true;
+        }
+        else if ((token == "-u" || token == "-p") && i + 1 < tokens.size())
+        {
+            if (token == "-p")
+            {
+                prompt = tokens[++i];
+            }
+            else if (is_string_numeric(tokens[i + 1]))
+            {
+                fd = std::stoi(tokens[++i]);
+            }
+            else
+            {
+                std::cerr << "nsh: read: " << tokens[i + 1] << ": invalid file descriptor specification" << std::endl;
+                last_exit_code = 1;
+                return;
+            }
+        }
+        else if (!token.empty() && token[0] == '-' && names.empty())
+        {
+            std::cerr << "nsh: read: " << token << ": invalid option" << std::endl;
+            std::cerr << "read: usage: read [-r] [-u fd] [-p prompt] [name ...]" << std::endl;
+            last_exit_code = 2;
+            return;
+        }
+        else
+        {
+            names.push_back(token);
+        }
+    }
+
+    if (fcntl(fd, F_GETFD) == -1)
+    {
+        std::cerr << "nsh: read: " << fd << ": invalid file descriptor: " << strerror(errno) << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+
+    bool from_terminal = isatty(fd);
+    if (from_terminal)
+    {
+        if (!prompt.empty())
+            std::cerr << prompt << std::flush;
+        safe_set_cooked_mode();
+    }
+
+    std::string line;
+    bool complete = read_line_from_fd(fd, raw, line);
+
+    if (from_terminal)
+        safe_set_raw_mode();
+
+    if (names.empty())
+        names.push_back("REPLY");
+
+    std::vector<std::string> fields = split_read_fields(line, names.size());
+    {
+        std::lock_guard<std::recursive_mutex> lock(builtin_state_mutex);
+        for (size_t i = 0; i < names.size(); ++i)
+            set_env_var(names[i], i < fields.size() ? fields[i] : "", false);
+    }
+
+    last_exit_code = complete ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+// builtins/timer.def.cc
+
+#include "execution.h"
+#include "events.h"
+#include "globals.h"
+#include "terminal.h"
+#include "utils.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Parse durasi gaya coreutils: angka (pecahan boleh) dengan suffix
+ *        opsional s, m, h atau d.
+ * @return false jika bukan durasi yang valid.
+ */
+static bool parse_duration(const std::string &text, double &seconds)
+{
+    if (text.empty())
+        return false;
+    char *end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || !std::isfinite(value) || value < 0)
+        return false;
+
+    std::string suffix(end);
+    if (suffix.empty() || suffix == "s")
+        seconds = value;
+    else if (suffix == "m")
+        seconds = value * 60;
+    else if (suffix == "h")
+        seconds = value * 60 * 60;
+    else if (suffix == "d")
+        seconds = value * 60 * 60 * 24;
+    else
+        return false;
+    return std::isfinite(seconds);
+}
+
+static struct timespec duration_to_timespec(double seconds)
+{
+    struct timespec ts;
+    double whole = std::floor(seconds);
+    ts.tv_sec = whole >= static_cast<double>(INT32_MAX) ? INT32_MAX : static_cast<time_t>(whole);
+    ts.tv_nsec = static_cast<long>((seconds - whole) * 1e9);
+    if (ts.tv_nsec >= 1000000000L)
+        ts.tv_nsec = 999999999L;
+    return ts;
+}
+
+// timerfd CLOCK_MONOTONIC untuk event loop, dipindah ke atas fd 10 supaya
+// tidak bentrok dengan fd redirection milik user
+static int create_timer_fd()
+{
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0)
+        return -1;
+    int high_fd = fcntl(timer_fd, F_DUPFD_CLOEXEC, 10);
+    if (high_fd >= 0)
+    {
+        close(timer_fd);
+        timer_fd = high_fd;
+    }
+    return timer_fd;
+}
+
+/**
+ * @brief Builtin sleep: tunggu DURASI tanpa fork+exec /bin/sleep.
+ *
+ * Deadline absolut CLOCK_MONOTONIC (timerfd) ditunggu di event loop shell,
+ * jadi sinyal yang memotong tidur tidak menggeser total waktunya, dan
+ * selama tidur child tetap di-reap, antrian NSH_MAX_BG_JOBS tetap berjalan
+ * dan pipe NSH_BG_CAPTURE tetap dikosongkan.
+ */
+void handle_builtin_sleep(const std::vector<std::string> &tokens)
+{
+    if (tokens.size() > 1 && (tokens[1] == "--help" || tokens[1] == "-h"))
+    {
+        builtin_out() << "sleep: sleep NUMBER[SUFFIX]...\n"
+                      << "    Pause for NUMBER seconds.\n\n"
+                      << "    SUFFIX may be 's' for seconds (the default), 'm' for minutes,\n"
+                      << "    'h' for hours or 'd' for days. NUMBER may be a fraction. Given\n"
+                      << "    two or more arguments, pause for the sum of their values.\n\n"
+                      << "    Exit Status:\n"
+                      << "    Returns success unless an argument is invalid (1) or the sleep\n"
+                      << "    is interrupted (130).\n";
+        last_exit_code = 0;
+        return;
+    }
+    if (tokens.size() < 2)
+    {
+        std::cerr << "nsh: sleep: missing operand" << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+
+    double total = 0;
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+        double seconds = 0;
+        if (!parse_duration(tokens[i], seconds))
+        {
+            std::cerr << "nsh: sleep: invalid time interval `" << tokens[i] << "'" << std::endl;
+            last_exit_code = 1;
+            return;
+        }
+        total += seconds;
+    }
+
+    struct timespec deadline;
+    struct timespec length = duration_to_timespec(total);
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += length.tv_sec;
+    deadline.tv_nsec += length.tv_nsec;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    int timer_fd = create_timer_fd();
+    if (timer_fd < 0)
+    {
+        std::cerr << "nsh: sleep: timerfd: " << strerror(errno) << std::endl;
+        last_exit_code = 1;
+        return;
+    }
+    struct itimerspec spec = {};
+    spec.it_value = deadline;
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    bool expired = false;
+    event_loop_add_fd(timer_fd, EPOLLIN, [&expired](uint32_t) { expired = true; });
+
+    // Hanya shell itu sendiri yang mengubah mode terminal (Ctrl-C harus jadi
+    // SIGINT); `sleep 5 &` di-fork ke group lain dan tidak menyentuhnya
+    bool own_terminal = getpgrp() == shell_pgid;
+    if (own_terminal)
+        safe_set_cooked_mode();
+
+    last_exit_code = 0;
+    while (!expired)
+    {
+        event_loop_run_once(-1);
+        if (received_sigint)
+        {
+            last_exit_code = 130;
+            break;
+        }
+    }
+
+    event_loop_remove_fd(timer_fd);
+    close(timer_fd);
+
+    if (own_terminal)
+        safe_set_raw_mode();
+}
+
+static void show_timeout_help()
+{
+    builtin_out() << "timeout: timeout [-s SIGNAL] [-k DURATION] [--preserve-status] DURATION COMMAND [ARG]...\n"
+                  << "    Run COMMAND, and kill it if still running after DURATION.\n\n"
+                  << "    COMMAND runs as a job in its own process group; when DURATION\n"
+                  << "    expires the signal is sent to the whole group, so children of\n"
+                  << "    COMMAND are stopped too. DURATION takes the same suffixes as sleep.\n\n"
+                  << "    Options:\n"
+                  << "      -s, --signal SIGNAL   signal to send on timeout (default TERM)\n"
+                  << "      -k, --kill-after DURATION\n"
+                  << "                            also send KILL if the group is still\n"
+                  << "                            running DURATION after the first signal\n"
+                  << "      --preserve-status     exit with the status of COMMAND even when\n"
+                  << "                            it timed out\n\n"
+                  << "    Exit Status:\n"
+                  << "    124 if COMMAND timed out (and --preserve-status was not given),\n"
+                  << "    125 if timeout itself failed, 126/127 if COMMAND could not be run,\n"
+                  << "    otherwise the exit status of COMMAND.\n";
+}
+
+// Kirim sinyal ke group job foreground; child helper (pipeline/subshell)
+// tidak punya group sendiri, kirim ke pemimpinnya saja
+static void signal_timed_job(pid_t pgid, int sig)
+{
+    if (pgid <= 0)
+        return;
+    if (kill(-pgid, sig) == -1 && errno == ESRCH)
+        kill(pgid, sig);
+    if (sig != SIGKILL && sig != SIGCONT)
+    {
+        if (kill(-pgid, SIGCONT) == -1 && errno == ESRCH)
+            kill(pgid, SIGCONT); // job yang di-stop juga harus menerima sinyalnya
+    }
+}
+
+/**
+ * @brief Builtin timeout: jalankan COMMAND lewat execute_job dengan batas waktu.
+ *
+ * Batas waktu adalah timerfd di event loop shell, jadi tidak ada proses
+ * pengawas tambahan: timer berbunyi saat execute_job menunggu job di loop
+ * yang sama, lalu sinyal dikirim ke seluruh process group job.
+ */
+void handle_builtin_timeout(const std::vector<std::string> &tokens)
+{
+    int signal_num = SIGTERM;
+    double kill_after = 0;
+    bool preserve_status = false;
+
+    size_t i = 1;
+    for (; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (token == "--")
+        {
+            ++i;
+            break;
+        }
+        if (token.size() < 2 || token[0] != '-')
+            break;
+        if (token == "--help" || token == "-h")
+        {
+            show_timeout_help();
+            last_exit_code = 0;
+            return;
+        }
+        if (token == "--preserve-status")
+        {
+            preserve_status = true;
+            continue;
+        }
+
+        std::string value;
+        bool is_signal = (token == "-s" || token == "--signal");
+        bool is_kill_after = (token == "-k" || token == "--kill-after");
+        if (is_signal || is_kill_after)
+        {
+            if (i + 1 >= tokens.size())
+            {
+                std::cerr << "nsh: timeout: " << token << ": option requires an argument" << std::endl;
+                last_exit_code = 125;
+                return;
+            }
+            value = tokens[++i];
+        }
+        else if (token.rfind("--signal=", 0) == 0 || token.rfind("--kill-after=", 0) == 0)
+        {
+            is_signal = token[2] == 's';
+            is_kill_after = !is_signal;
+            value = token.substr(token.find('=') + 1);
+        }
+        else
+        {
+            std::cerr << "nsh: timeout: " << token << ": invalid option" << std::endl;
+            last_exit_code = 125;
+            return;
+        }
+
+        if (is_signal)
+        {
+            if (is_string_numeric(value))
+            {
+                errno = 0;
+                long number = strtol(value.c_str(), nullptr, 10);
+                signal_num = errno == 0 && number < NSIG ? static_cast<int>(number) : -1;
+            }
+            else
+            {
+                signal_num = get_signal_by_name(value);
+            }
+            if (signal_num <= 0 || signal_num >= NSIG)
+            {
+                std::cerr << "nsh: timeout: " << value << ": invalid signal" << std::endl;
+                last_exit_code = 125;
+                return;
+            }
+        }
+        else if (!parse_duration(value, kill_after))
+        {
+            std::cerr << "nsh: timeout: invalid time interval `" << value << "'" << std::endl;
+            last_exit_code = 125;
+            return;
+        }
+    }
+
+    if (i + 1 >= tokens.size())
+    {
+        std::cerr << "nsh: timeout: missing operand" << std::endl;
+        std::cerr << "timeout: usage: timeout [-s SIGNAL] [-k DURATION] DURATION COMMAND [ARG]..." << std::endl;
+        last_exit_code = 125;
+        return;
+    }
+
+    double duration = 0;
+    if (!parse_duration(tokens[i], duration))
+    {
+        std::cerr << "nsh: timeout: invalid time interval `" << tokens[i] << "'" << std::endl;
+        last_exit_code = 125;
+        return;
+    }
+
+    SimpleCommand cmd;
+    cmd.tokens.assign(tokens.begin() + i + 1, tokens.end());
+
+    // COMMAND selalu proses sendiri (seperti coreutils timeout yang exec):
+    // builtin dengan program bernama sama (sleep) memakai program itu
+    if (is_builtin(cmd.tokens[0]))
+    {
+        std::string binary = find_binary(cmd.tokens[0]);
+        if (binary.empty())
+        {
+            std::cerr << "nsh: timeout: " << cmd.tokens[0] << ": shell builtin cannot be run with a time limit" << std::endl;
+            last_exit_code = 126;
+            return;
+        }
+        cmd.tokens[0] = binary;
+    }
+
+    ParsedCommand group;
+    group.pipeline.push_back(std::move(cmd));
+
+    int timer_fd = create_timer_fd();
+    if (timer_fd < 0)
+    {
+        std::cerr << "nsh: timeout: timerfd: " << strerror(errno) << std::endl;
+        last_exit_code = 125;
+        return;
+    }
+
+    // 0 = timer belum berbunyi, 1 = sinyal pertama terkirim, 2 = KILL terkirim
+    int stage = 0;
+    auto arm = [timer_fd](double seconds) {
+        struct itimerspec spec = {};
+        spec.it_value = duration_to_timespec(seconds);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            spec.it_value.tv_nsec = 1; // 0 berarti disarm
+        timerfd_settime(timer_fd, 0, &spec, nullptr);
+    };
+
+    event_loop_add_fd(timer_fd, EPOLLIN, [&, timer_fd](uint32_t) {
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return;
+        pid_t pgid = foreground_pgid;
+        if (stage == 0)
+        {
+            stage = 1;
+            signal_timed_job(pgid, signal_num);
+            if (kill_after > 0)
+                arm(kill_after);
+        }
+        else if (stage == 1)
+        {
+            stage = 2;
+            signal_timed_job(pgid, SIGKILL);
+        }
+    });
+
+    // Durasi 0: tanpa batas waktu (seperti coreutils)
+    if (duration > 0)
+        arm(duration);
+
+    int code = execute_job(group, true);
+
+    event_loop_remove_fd(timer_fd);
+    close(timer_fd);
+
+    if (stage == 2 && !preserve_status)
+        last_exit_code = 128 + SIGKILL;
+    else if (stage != 0 && !preserve_status)
+        last_exit_code = 124;
+    else
+        last_exit_code = code;
+}
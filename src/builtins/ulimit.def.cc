@@ -0,0 +1,167 @@
+// builtins/ulimit.def.cc
+
+#include "globals.h"
+#include "job_limits.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void show_ulimit_help()
+{
+    builtin_out() << "ulimit: ulimit [-SHa] [-cdefilmnqrstuvx [limit]]\n"
+                  << "    Modify shell resource limits.\n\n"
+                  << "    Provides control over the resources available to the shell and the\n"
+                  << "    processes it creates. Without a limit, prints the current value.\n\n"
+                  << "    Options:\n"
+                  << "      -S  use the soft resource limit\n"
+                  << "      -H  use the hard resource limit\n"
+                  << "      -a  all current limits are reported\n"
+                  << "      -c  the maximum size of core files created\n"
+                  << "      -d  the maximum size of a process's data segment\n"
+                  << "      -e  the maximum scheduling priority (`nice')\n"
+                  << "      -f  the maximum size of files written by the shell and its children\n"
+                  << "      -i  the maximum number of pending signals\n"
+                  << "      -l  the maximum size a process may lock into memory\n"
+                  << "      -m  the maximum resident set size (not enforced by Linux)\n"
+                  << "      -n  the maximum number of open file descriptors\n"
+                  << "      -q  the maximum number of bytes in POSIX message queues\n"
+                  << "      -r  the maximum real-time scheduling priority\n"
+                  << "      -s  the maximum stack size\n"
+                  << "      -t  the maximum amount of cpu time in seconds\n"
+                  << "      -u  the maximum number of user processes\n"
+                  << "      -v  the size of virtual memory\n"
+                  << "      -x  the maximum number of file locks\n\n"
+                  << "    If neither -S nor -H is given, both limits are set and the soft\n"
+                  << "    limit is printed. LIMIT is a number in the unit of the option\n"
+                  << "    (1024-byte blocks for sizes, except -q in bytes), a size with a\n"
+                  << "    suffix (256M, 2G), or `unlimited'. Without an option, -f is assumed.\n\n"
+                  << "    To limit a single command instead of the shell, use\n"
+                  << "    `limit [-c|-d|-f|-n|-s|-t|-u|-v LIMIT]... [--] COMMAND' (memory: -v).\n\n"
+                  << "    Exit Status:\n"
+                  << "    Returns success unless an invalid option is supplied or an error occurs.\n";
+}
+
+// Satu baris `ulimit -a`: "open files                          (-n) 1024"
+static void print_limit_line(const LimitSpec &spec, rlim_t value)
+{
+    std::string label = "(";
+    if (spec.unit)
+        label += std::string(spec.unit) + ", ";
+    label += "-" + std::string(1, spec.option) + ")";
+    builtin_out() << std::left << std::setw(static_cast<int>(40 - label.size())) << spec.description << label
+                  << ' ' << limit_format_value(spec, value) << '\n';
+}
+
+void handle_builtin_ulimit(const std::vector<std::string> &tokens)
+{
+    bool soft = false, hard = false, all = false;
+    // Opsi resource berurutan, dengan nilai baru jika ada
+    std::vector<std::pair<const LimitSpec *, std::string>> requests;
+
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+        const std::string &arg = tokens[i];
+        if (arg == "--help")
+        {
+            show_ulimit_help();
+            last_exit_code = 0;
+            return;
+        }
+        if (arg.size() < 2 || arg[0] != '-')
+        {
+            // `ulimit 4096` sama dengan `ulimit -f 4096`
+            if (!requests.empty() || i + 1 != tokens.size())
+            {
+                std::cerr << "nsh: ulimit: " << arg << ": invalid argument" << std::endl;
+                last_exit_code = 2;
+                return;
+            }
+            requests.emplace_back(limit_spec('f'), arg);
+            break;
+        }
+        for (size_t j = 1; j < arg.size(); ++j)
+        {
+            char option = arg[j];
+            if (option == 'S')
+                soft = true;
+            else if (option == 'H')
+                hard = true;
+            else if (option == 'a')
+                all = true;
+            else if (const LimitSpec *spec = limit_spec(option))
+                requests.emplace_back(spec, "");
+            else
+            {
+                std::cerr << "nsh: ulimit: -" << option << ": invalid option" << std::endl;
+                std::cerr << "ulimit: usage: ulimit [-SHa] [-cdefilmnqrstuvx [limit]]" << std::endl;
+                last_exit_code = 2;
+                return;
+            }
+        }
+        // Nilai mengikuti opsi resource terakhir
+        if (!requests.empty() && requests.back().second.empty() && i + 1 < tokens.size() &&
+            (tokens[i + 1].empty() || tokens[i + 1][0] != '-'))
+            requests.back().second = tokens[++i];
+    }
+
+    last_exit_code = 0;
+    if (all)
+    {
+        size_t count;
+        const LimitSpec *specs = limit_specs(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            struct rlimit limit;
+            if (getrlimit(static_cast<decltype(RLIMIT_CPU)>(specs[i].resource), &limit) == 0)
+                print_limit_line(specs[i], hard ? limit.rlim_max : limit.rlim_cur);
+        }
+        return;
+    }
+    if (requests.empty())
+        requests.emplace_back(limit_spec('f'), "");
+
+    for (const auto &[spec, text] : requests)
+    {
+        auto resource = static_cast<decltype(RLIMIT_CPU)>(spec->resource);
+        struct rlimit limit;
+        if (getrlimit(resource, &limit) != 0)
+        {
+            std::cerr << "nsh: ulimit: " << spec->description << ": cannot get limit: " << strerror(errno) << std::endl;
+            last_exit_code = 1;
+            continue;
+        }
+        if (text.empty())
+        {
+            rlim_t value = hard ? limit.rlim_max : limit.rlim_cur;
+            if (requests.size() > 1)
+                print_limit_line(*spec, value);
+            else
+                builtin_out() << limit_format_value(*spec, value) << '\n';
+            continue;
+        }
+
+        rlim_t value;
+        if (text == "hard" || text == "soft")
+            value = text == "hard" ? limit.rlim_max : limit.rlim_cur;
+        else if (!limit_parse_value(*spec, text, value))
+        {
+            std::cerr << "nsh: ulimit: " << text << ": invalid number" << std::endl;
+            last_exit_code = 1;
+            continue;
+        }
+        // Tanpa -S/-H keduanya diubah, seperti bash
+        if (hard || !soft)
+            limit.rlim_max = value;
+        if (soft || !hard)
+            limit.rlim_cur = value;
+        if (setrlimit(resource, &limit) != 0)
+        {
+            std::cerr << "nsh: ulimit: " << spec->description << ": cannot modify limit: " << strerror(errno) << std::endl;
+            last_exit_code = 1;
+        }
+    }
+}
@@ -15,7 +15,7 @@ void handle_builtin_unset(const std::vector<std::string> &tokens)
                   << "    Some variables cannot be unset:\n"
                   << "      BASHOPTS   IFS        PPID       SHELLOPTS  UID\n"
                   << "      EUID       OPTARG     SECONDS    TERM\n"
-                  << "      FUNCNAME   OPTIND     SHELL      TIMEFORMAT\n"
+                  << "      FUNCNAME   OPTIND     SHELL\n"
                   << "      GROUPS     OSTYPE     SHLVL      USER\n"
                   << "      HISTCMD    PIPESTATUS SUDO_GID   USERNAME\n"
                   << "      HOSTNAME   POSIXLY_CORRECT SUDO_UID\n"
@@ -35,7 +35,7 @@ void handle_builtin_unset(const std::vector<std::string> &tokens)
         "BASHOPTS", "EUID", "FUNCNAME", "GROUPS", "HISTCMD", "HOSTNAME",
         "IFS", "OPTARG", "OPTIND", "OSTYPE", "PIPESTATUS", "PPID",
         "POSIXLY_CORRECT", "SECONDS", "SHELL", "SHELLOPTS", "SHLVL",
-        "SUDO_GID", "SUDO_UID", "TERM", "TIMEFORMAT", "UID", "USER", "USERNAME"
+        "SUDO_GID", "SUDO_UID", "TERM", "UID", "USER", "USERNAME"
     };
 
     // Parse options
@@ -0,0 +1,344 @@
+// builtins/wait.def.cc
+
+#include "execution.h"
+#include "events.h"
+#include "globals.h"
+#include "job_scheduler.h"
+#include "terminal.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static void show_wait_help()
+{
+    builtin_out() << "wait: wait [-n] [--timeout SEC] [id ...]\n"
+                  << "    Wait for job completion and return exit status.\n\n"
+                  << "    Waits for each process or job identified by an ID, which may be a\n"
+                  << "    process ID or a job specification (%N, %+, %-, %name), and reports\n"
+                  << "    its termination status. If ID is not given, waits for all currently\n"
+                  << "    running background jobs, and the return status is zero.\n\n"
+                  << "    Options:\n"
+                  << "      -n            wait for the first of the IDs (or of all running\n"
+                  << "                    background jobs) to finish and return its status\n"
+                  << "      --timeout SEC give up after SEC seconds (fractions allowed)\n\n"
+                  << "    Exit Status:\n"
+                  << "    Returns the status of the last ID; 127 if an ID is not a child of\n"
+                  << "    this shell or -n finds no running job; 124 if the timeout expires;\n"
+                  << "    130 if interrupted.\n";
+}
+
+/**
+ * @brief Mengubah argumen wait (PID atau jobspec) menjadi PGID job lokal.
+ * @return false jika bukan child/job dari shell ini.
+ */
+static bool resolve_wait_target(const std::string &arg, pid_t &pgid)
+{
+    if (arg[0] == '%')
+    {
+        // %N langsung dari job list (atau job yang sudah selesai), tanpa
+        // membangun daftar tampilan
+        std::string spec = arg.substr(1);
+        if (is_string_numeric(spec))
+        {
+            int job_id = std::stoi(spec);
+            auto it = jobs.find(job_id);
+            if (it != jobs.end())
+            {
+                pgid = it->second.pgid;
+                return true;
+            }
+            if ((pgid = finished_job_pgid(job_id)) != 0)
+                return true;
+        }
+        if (jobspec_to_pgid(arg, pgid) != 0)
+            return false;
+        // Job session lain bukan child shell ini
+        if (!find_job_by_pgid(pgid) && !finished_job_exit_code(pgid, nullptr))
+        {
+            std::cerr << "nsh: wait: " << arg << ": job belongs to another session" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    if (!is_string_numeric(arg))
+    {
+        std::cerr << "nsh: wait: `" << arg << "': not a pid or valid job spec" << std::endl;
+        return false;
+    }
+
+    pid_t pid = std::stoi(arg);
+    if (find_job_by_pgid(pid) || finished_job_exit_code(pid, nullptr))
+    {
+        pgid = pid;
+        return true;
+    }
+    // PID stage lain di dalam job (bukan pemimpin group)
+    pid_t group = event_loop_group_of(pid);
+    if (group != 0 && find_job_by_pgid(group))
+    {
+        pgid = group;
+        return true;
+    }
+
+    std::cerr << "nsh: wait: pid " << pid << " is not a child of this shell" << std::endl;
+    return false;
+}
+
+/**
+ * @brief Builtin wait: tunggu job background selesai.
+ *
+ * Menunggu di event loop shell (pidfd per child di epoll); setiap job yang
+ * selesai dilaporkan lewat hook dari job_process_changed, jadi biaya menunggu
+ * ribuan job sebanding dengan jumlah event, bukan polling job list.
+ */
+void handle_builtin_wait(const std::vector<std::string> &tokens)
+{
+    bool wait_any = false;
+    double timeout_sec = -1;
+    std::vector<std::string> ids;
+
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (!ids.empty() || token.empty() || token[0] != '-' || token == "-")
+        {
+            ids.push_back(token);
+            continue;
+        }
+        if (token == "--help" || token == "-h")
+        {
+            show_wait_help();
+            last_exit_code = 0;
+            return;
+        }
+        if (token == "--")
+        {
+            ids.insert(ids.end(), tokens.begin() + i + 1, tokens.end());
+            break;
+        }
+        if (token == "-n")
+        {
+            wait_any = true;
+        }
+        else if (token == "--timeout" || token.rfind("--timeout=", 0) == 0)
+        {
+            std::string value;
+            if (token == "--timeout")
+            {
+                if (i + 1 >= tokens.size())
+                {
+                    std::cerr << "nsh: wait: --timeout: option requires an argument" << std::endl;
+                    last_exit_code = 2;
+                    return;
+                }
+                value = tokens[++i];
+            }
+            else
+            {
+                value = token.substr(10);
+            }
+            char *end = nullptr;
+            timeout_sec = strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || !std::isfinite(timeout_sec) || timeout_sec < 0)
+            {
+                std::cerr << "nsh: wait: " << value << ": invalid timeout" << std::endl;
+                last_exit_code = 2;
+                return;
+            }
+        }
+        else if (is_string_numeric(token.substr(1)))
+        {
+            ids.push_back(token); // `wait -123`: tetap dianggap id, ditolak di bawah
+        }
+        else
+        {
+            std::cerr << "nsh: wait: " << token << ": invalid option" << std::endl;
+            std::cerr << "wait: usage: wait [-n] [--timeout SEC] [id ...]" << std::endl;
+            last_exit_code = 2;
+            return;
+        }
+    }
+
+    check_child_status();
+
+    // pgid yang masih ditunggu dan hasil yang sudah diketahui
+    std::unordered_set<pid_t> pending;
+    std::unordered_map<pid_t, int> results;
+    std::vector<pid_t> targets; // urutan argumen; 0 = id tidak dikenal, -N = job antrian %N
+    std::unordered_set<int> queued_ids;
+    pid_t first_done = 0;
+
+    // Job list diwarisi apa adanya oleh child hasil fork (`wait | cat`,
+    // coproc, run parallel), tapi hanya shell yang mem-fork job itu yang
+    // bisa me-reap-nya: job yang tidak dicatat event loop proses ini tidak
+    // ditunggu, seperti wait di subshell bash
+    auto add_running_jobs = [&]() {
+        for (const auto &[id, job] : jobs)
+        {
+            if (job.status == JobStatus::RUNNING && !results.count(job.pgid) && event_loop_has_group(job.pgid))
+                pending.insert(job.pgid);
+        }
+    };
+    if (ids.empty())
+        add_running_jobs();
+
+    for (const std::string &id : ids)
+    {
+        pid_t pgid = 0;
+        // Job antrian scheduler belum punya PGID: ditunggu sampai dijalankan
+        if (id.size() > 1 && id[0] == '%' && is_string_numeric(id.substr(1)) &&
+            scheduler_is_queued(std::stoi(id.substr(1))))
+        {
+            queued_ids.insert(std::stoi(id.substr(1)));
+            targets.push_back(-std::stoi(id.substr(1)));
+            continue;
+        }
+        if (!resolve_wait_target(id, pgid))
+        {
+            targets.push_back(0);
+            continue;
+        }
+        targets.push_back(pgid);
+
+        int exit_code = 0;
+        Job *job = find_job_by_pgid(pgid);
+        if (job && job->status == JobStatus::RUNNING && !event_loop_has_group(pgid))
+        {
+            std::cerr << "nsh: wait: " << id << ": not a child of this shell" << std::endl;
+            targets.back() = 0;
+        }
+        else if (job && job->status == JobStatus::RUNNING)
+        {
+            pending.insert(pgid);
+        }
+        else if (job && job->status == JobStatus::STOPPED)
+        {
+            results[pgid] = 128 + job->term_status;
+            if (!first_done)
+                first_done = pgid;
+        }
+        else if (finished_job_exit_code(pgid, &exit_code))
+        {
+            results[pgid] = exit_code;
+            if (!first_done)
+                first_done = pgid;
+        }
+    }
+
+    // Job antrian yang sudah keluar dari antrian: tunggu PGID-nya seperti job biasa
+    size_t last_queued = scheduler_queued_count();
+    auto promote_queued = [&]() {
+        if (ids.empty() && scheduler_queued_count() != last_queued)
+        {
+            last_queued = scheduler_queued_count();
+            add_running_jobs();
+        }
+        for (auto it = queued_ids.begin(); it != queued_ids.end();)
+        {
+            int job_id = *it;
+            if (scheduler_is_queued(job_id))
+            {
+                ++it;
+                continue;
+            }
+            it = queued_ids.erase(it);
+            auto job = jobs.find(job_id);
+            pid_t pgid = job != jobs.end() ? job->second.pgid : finished_job_pgid(job_id);
+            int exit_code = 127; // dibatalkan (kill) atau gagal dijalankan
+            if (job != jobs.end() && job->second.status == JobStatus::RUNNING)
+            {
+                pending.insert(pgid);
+                continue;
+            }
+            if (job != jobs.end())
+                exit_code = 128 + job->second.term_status;
+            else if (pgid != 0)
+                finished_job_exit_code(pgid, &exit_code);
+            if (pgid == 0)
+                pgid = -job_id;
+            results[pgid] = exit_code;
+            if (!first_done)
+                first_done = pgid;
+        }
+    };
+
+    bool waiting_queue = !queued_ids.empty() || (ids.empty() && last_queued != 0);
+    if (wait_any && first_done == 0 && pending.empty() && !waiting_queue)
+    {
+        last_exit_code = 127;
+        return;
+    }
+
+    set_job_wait_hook([&](pid_t pgid, int exit_code) {
+        if (pending.erase(pgid) == 0)
+            return;
+        results[pgid] = exit_code;
+        if (!first_done)
+            first_done = pgid;
+    });
+
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                       std::chrono::duration<double>(timeout_sec < 0 ? 0 : timeout_sec));
+    bool timed_out = false;
+    bool interrupted = false;
+
+    // Terminal kembali ke mode normal selama menunggu supaya Ctrl-C jadi
+    // SIGINT (EINTR di epoll_wait), bukan byte di stdin
+    safe_set_cooked_mode();
+
+    while ((!pending.empty() || !queued_ids.empty() || (ids.empty() && scheduler_queued_count())) &&
+           !(wait_any && first_done))
+    {
+        int timeout_ms = -1;
+        if (timeout_sec >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+            if (left <= 0)
+            {
+                timed_out = true;
+                break;
+            }
+            timeout_ms = static_cast<int>(std::min<long long>(left, 1000 * 60 * 60));
+        }
+        event_loop_run_once(timeout_ms);
+        if (received_sigint)
+        {
+            interrupted = true;
+            break;
+        }
+        promote_queued();
+    }
+    set_job_wait_hook(nullptr);
+    safe_set_raw_mode();
+    flush_job_updates();
+
+    if (interrupted)
+        last_exit_code = 130;
+    else if (timed_out)
+        last_exit_code = 124;
+    else if (wait_any)
+        last_exit_code = results[first_done];
+    else if (targets.empty())
+        last_exit_code = 0;
+    else if (targets.back() == 0)
+        last_exit_code = 127;
+    else
+    {
+        pid_t last = targets.back();
+        if (last < 0)
+        {
+            // %N dari antrian: PGID baru diketahui setelah dijalankan
+            pid_t pgid = finished_job_pgid(-last);
+            last = (pgid != 0 && results.count(pgid)) ? pgid : last;
+        }
+        last_exit_code = results[last];
+    }
+}
@@ -0,0 +1,547 @@
+#include "events.h"
+#include "execution.h" // job_process_changed, job_stage_exited
+
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <readline/readline.h>
+
+namespace {
+
+struct ChildRecord {
+    pid_t pgid;
+    int pidfd = -1;
+    bool foreground = false;
+    bool exited = false;
+    bool pending = false;      // status belum diambil waiter foreground
+    int status = 0;
+    struct rusage usage = {};
+    struct timespec exited_at = {}; // CLOCK_MONOTONIC saat exit diterima (`time`)
+};
+
+struct ProcessGroup {
+    std::vector<pid_t> pids;   // child yang masih punya record
+    int live = 0;              // child yang belum exit
+    pid_t last_pid = 0;        // stage terakhir menentukan exit status job
+    int last_status = 0;
+    struct rusage usage = {};  // total rusage child yang sudah selesai
+};
+
+// Fd internal ditaruh di atas range yang biasa dipakai user (`exec 3>log`)
+constexpr int EVENT_MIN_FD = 10;
+constexpr int EVENT_BATCH = 16;
+
+int epoll_fd = -1;
+int signal_fd = -1;
+sigset_t initial_mask;
+bool initial_mask_saved = false;
+bool atfork_registered = false;
+
+// Kernel tanpa pidfd (< 5.3) atau pidfd_open gagal: exit child tersebut
+// di-reap dari notifikasi SIGCHLD dengan wait4(-1).
+bool pidfd_supported = true;
+int children_without_pidfd = 0;
+
+int input_fd = -1;
+bool input_ready = false;
+
+std::unordered_map<int, std::function<void(uint32_t)>> watchers;
+std::unordered_map<pid_t, ChildRecord> children;
+std::unordered_map<pid_t, ProcessGroup> groups;
+
+int move_high(int fd)
+{
+    if (fd < 0 || fd >= EVENT_MIN_FD)
+        return fd;
+    int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, EVENT_MIN_FD);
+    if (high_fd == -1)
+        return fd;
+    close(fd);
+    return high_fd;
+}
+
+int open_pidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    if (!pidfd_supported)
+        return -1;
+    int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (fd == -1 && errno == ENOSYS)
+        pidfd_supported = false;
+    return move_high(fd);
+#else
+    (void)pid;
+    pidfd_supported = false;
+    return -1;
+#endif
+}
+
+// Hapus record child yang sudah exit dan statusnya sudah dipakai
+void forget_child(pid_t pid)
+{
+    auto it = children.find(pid);
+    if (it == children.end())
+        return;
+    pid_t pgid = it->second.pgid;
+    children.erase(it);
+
+    auto git = groups.find(pgid);
+    if (git == groups.end())
+        return;
+    auto &pids = git->second.pids;
+    pids.erase(std::remove(pids.begin(), pids.end(), pid), pids.end());
+    if (pids.empty() && git->second.live == 0)
+        groups.erase(git);
+}
+
+void child_changed(pid_t pid, int status, const struct rusage *usage)
+{
+    auto it = children.find(pid);
+    if (it == children.end())
+        return; // bukan child yang dicatat (command substitution, system())
+
+    ChildRecord &record = it->second;
+    ProcessGroup &group = groups[record.pgid];
+    bool finished = WIFEXITED(status) || WIFSIGNALED(status);
+    record.status = status;
+
+    if (finished && !record.exited)
+    {
+        record.exited = true;
+        clock_gettime(CLOCK_MONOTONIC, &record.exited_at);
+        if (usage)
+        {
+            record.usage = *usage;
+            add_rusage(group.usage, *usage);
+        }
+        job_stage_exited(record.pgid, pid, status, record.usage);
+        if (record.pidfd >= 0)
+        {
+            event_loop_remove_fd(record.pidfd);
+            close(record.pidfd);
+            record.pidfd = -1;
+        }
+        else
+        {
+            children_without_pidfd--;
+        }
+        group.live--;
+        if (pid == group.last_pid)
+            group.last_status = status;
+    }
+
+    if (record.foreground)
+    {
+        record.pending = true;
+        return;
+    }
+
+    pid_t pgid = record.pgid;
+    bool group_done = (group.live == 0);
+    if (!finished)
+        job_process_changed(pgid, status, group.usage, false);
+    else if (group_done)
+        job_process_changed(pgid, group.last_status, group.usage, true);
+
+    if (finished)
+        forget_child(pid);
+}
+
+// pidfd readable: child ini sudah exit, reap langsung tanpa wait4(-1)
+void reap_exited(pid_t pid)
+{
+    int status = 0;
+    struct rusage usage;
+    pid_t result;
+    do {
+        result = wait4(pid, &status, WNOHANG, &usage);
+    } while (result == -1 && errno == EINTR);
+
+    if (result == pid)
+        child_changed(pid, status, &usage);
+    else if (result == -1 && errno == ECHILD)
+        child_changed(pid, 0, nullptr); // sudah di-reap pihak lain
+}
+
+// SIGCHLD: stop/continue selalu datang dari sini, exit hanya untuk child
+// tanpa pidfd
+void handle_sigchld(uint32_t)
+{
+    struct signalfd_siginfo info[8];
+    while (read(signal_fd, info, sizeof(info)) > 0)
+        ;
+
+    siginfo_t child;
+    while (true)
+    {
+        child.si_pid = 0;
+        if (waitid(P_ALL, 0, &child, WSTOPPED | WCONTINUED | WNOHANG) != 0 || child.si_pid == 0)
+            break;
+        int status = (child.si_code == CLD_CONTINUED) ? __W_CONTINUED : W_STOPCODE(child.si_status);
+        child_changed(child.si_pid, status, nullptr);
+    }
+
+    if (pidfd_supported && children_without_pidfd == 0)
+        return;
+
+    int status;
+    struct rusage usage;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0)
+        child_changed(pid, status, &usage);
+}
+
+// Setelah fork, epoll/signalfd/pidfd milik parent tidak boleh dipakai child:
+// epoll instance-nya dipakai bersama dan pidfd menunjuk child milik parent.
+void reset_after_fork()
+{
+    for (const auto &[pid, record] : children)
+    {
+        if (record.pidfd >= 0)
+            close(record.pidfd);
+    }
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+    if (signal_fd >= 0)
+        close(signal_fd);
+    epoll_fd = -1;
+    signal_fd = -1;
+    input_fd = -1;
+    children_without_pidfd = 0;
+    watchers.clear();
+    children.clear();
+    groups.clear();
+}
+
+void watch_input(int fd)
+{
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = fd;
+
+    if (input_fd == fd && epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0)
+        return;
+    if (input_fd >= 0 && input_fd != fd)
+        event_loop_remove_fd(input_fd);
+
+    input_fd = -1;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0)
+    {
+        input_fd = fd;
+        watchers[fd] = [](uint32_t) { input_ready = true; };
+    }
+}
+
+} // namespace
+
+void event_loop_init()
+{
+    if (epoll_fd >= 0)
+        return;
+
+    sigset_t chld_mask;
+    sigemptyset(&chld_mask);
+    sigaddset(&chld_mask, SIGCHLD);
+    if (!initial_mask_saved)
+    {
+        sigprocmask(SIG_BLOCK, &chld_mask, &initial_mask);
+        initial_mask_saved = true;
+    }
+    else
+    {
+        sigprocmask(SIG_BLOCK, &chld_mask, nullptr);
+    }
+
+    if (!atfork_registered)
+    {
+        pthread_atfork(nullptr, nullptr, reset_after_fork);
+        atfork_registered = true;
+    }
+
+    epoll_fd = move_high(epoll_create1(EPOLL_CLOEXEC));
+    signal_fd = move_high(signalfd(-1, &chld_mask, SFD_NONBLOCK | SFD_CLOEXEC));
+    if (epoll_fd >= 0 && signal_fd >= 0)
+        event_loop_add_fd(signal_fd, EPOLLIN, handle_sigchld);
+}
+
+void event_loop_prepare_exec()
+{
+    if (initial_mask_saved)
+        sigprocmask(SIG_SETMASK, &initial_mask, nullptr);
+}
+
+bool event_loop_add_fd(int fd, uint32_t events, std::function<void(uint32_t)> callback)
+{
+    if (epoll_fd < 0)
+        event_loop_init();
+
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        return false;
+    watchers[fd] = std::move(callback);
+    return true;
+}
+
+void event_loop_remove_fd(int fd)
+{
+    if (watchers.erase(fd) == 0)
+        return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    if (fd == input_fd)
+        input_fd = -1;
+}
+
+int event_loop_run_once(int timeout_ms)
+{
+    if (epoll_fd < 0)
+        event_loop_init();
+
+    struct epoll_event ready[EVENT_BATCH];
+    int count = epoll_wait(epoll_fd, ready, EVENT_BATCH, timeout_ms);
+    if (count <= 0)
+        return count;
+
+    for (int i = 0; i < count; ++i)
+    {
+        // Callback sebelumnya bisa menghapus watcher (pidfd yang di-reap)
+        auto it = watchers.find(ready[i].data.fd);
+        if (it == watchers.end())
+            continue;
+        auto callback = it->second;
+        callback(ready[i].events);
+    }
+    return count;
+}
+
+void add_rusage(struct rusage &total, const struct rusage &usage)
+{
+    timeradd(&total.ru_utime, &usage.ru_utime, &total.ru_utime);
+    timeradd(&total.ru_stime, &usage.ru_stime, &total.ru_stime);
+    total.ru_maxrss = std::max(total.ru_maxrss, usage.ru_maxrss);
+    total.ru_minflt += usage.ru_minflt;
+    total.ru_majflt += usage.ru_majflt;
+    total.ru_inblock += usage.ru_inblock;
+    total.ru_oublock += usage.ru_oublock;
+    total.ru_nvcsw += usage.ru_nvcsw;
+    total.ru_nivcsw += usage.ru_nivcsw;
+}
+
+void event_loop_track_child(pid_t pid, pid_t pgid, bool foreground)
+{
+    if (epoll_fd < 0)
+        event_loop_init();
+
+    ChildRecord &record = children[pid];
+    record.pgid = pgid;
+    record.foreground = foreground;
+
+    ProcessGroup &group = groups[pgid];
+    group.pids.push_back(pid);
+    group.live++;
+    group.last_pid = pid;
+
+    record.pidfd = open_pidfd(pid);
+    if (record.pidfd >= 0 && !event_loop_add_fd(record.pidfd, EPOLLIN, [pid](uint32_t) { reap_exited(pid); }))
+    {
+        close(record.pidfd);
+        record.pidfd = -1;
+    }
+    if (record.pidfd < 0)
+        children_without_pidfd++;
+}
+
+int event_loop_wait_child(pid_t pid, struct rusage *usage, struct timespec *exited_at)
+{
+    auto it = children.find(pid);
+    if (it == children.end())
+    {
+        // Tidak dicatat loop: tunggu langsung seperti dulu
+        int status = 0;
+        struct rusage ignored;
+        while (wait4(pid, &status, WUNTRACED, usage ? usage : &ignored) == -1 && errno == EINTR)
+            ;
+        if (exited_at)
+            clock_gettime(CLOCK_MONOTONIC, exited_at);
+        return status;
+    }
+
+    while (!it->second.pending)
+    {
+        event_loop_run_once(-1);
+        it = children.find(pid);
+    }
+
+    ChildRecord &record = it->second;
+    int status = record.status;
+    record.pending = false;
+    if (usage)
+        *usage = record.usage;
+    if (exited_at)
+        *exited_at = record.exited_at;
+    if (record.exited)
+        forget_child(pid);
+    return status;
+}
+
+bool event_loop_child_exited(pid_t pid, int *status, struct rusage *usage)
+{
+    auto it = children.find(pid);
+    if (it == children.end() || !it->second.exited)
+        return false;
+    *status = it->second.status;
+    if (usage)
+        *usage = it->second.usage;
+    forget_child(pid);
+    return true;
+}
+
+void event_loop_claim_group(pid_t pgid)
+{
+    auto git = groups.find(pgid);
+    if (git == groups.end())
+        return;
+    for (pid_t pid : git->second.pids)
+        children[pid].foreground = true;
+}
+
+void event_loop_release_group(pid_t pgid)
+{
+    auto git = groups.find(pgid);
+    if (git == groups.end())
+        return;
+
+    std::vector<pid_t> exited;
+    for (pid_t pid : git->second.pids)
+    {
+        ChildRecord &record = children[pid];
+        record.foreground = false;
+        record.pending = false;
+        if (record.exited)
+            exited.push_back(pid);
+    }
+
+    bool group_done = (git->second.live == 0);
+    if (group_done)
+        job_process_changed(pgid, git->second.last_status, git->second.usage, true);
+    for (pid_t pid : exited)
+        forget_child(pid);
+}
+
+int event_loop_wait_group(pid_t pgid)
+{
+    if (groups.find(pgid) == groups.end())
+    {
+        int status = 0;
+        while (waitpid(-pgid, &status, WUNTRACED) == -1 && errno == EINTR)
+            ;
+        return status;
+    }
+
+    event_loop_claim_group(pgid);
+    while (true)
+    {
+        ProcessGroup &group = groups[pgid];
+        for (pid_t pid : group.pids)
+        {
+            ChildRecord &record = children[pid];
+            if (record.pending && WIFSTOPPED(record.status))
+            {
+                int status = record.status;
+                event_loop_release_group(pgid);
+                return status;
+            }
+            record.pending = false;
+        }
+
+        if (group.live == 0)
+        {
+            int status = group.last_status;
+            std::vector<pid_t> pids = group.pids;
+            for (pid_t pid : pids)
+                forget_child(pid);
+            groups.erase(pgid);
+            return status;
+        }
+        event_loop_run_once(-1);
+    }
+}
+
+bool event_loop_has_group(pid_t pgid)
+{
+    auto git = groups.find(pgid);
+    return git != groups.end() && git->second.live > 0;
+}
+
+pid_t event_loop_group_of(pid_t pid)
+{
+    auto it = children.find(pid);
+    return it == children.end() ? 0 : it->second.pgid;
+}
+
+std::vector<pid_t> event_loop_group_pids(pid_t pgid)
+{
+    std::vector<pid_t> pids;
+    auto git = groups.find(pgid);
+    if (git == groups.end())
+        return pids;
+    for (pid_t pid : git->second.pids)
+    {
+        if (!children[pid].exited)
+            pids.push_back(pid);
+    }
+    return pids;
+}
+
+int event_loop_getc(FILE *stream)
+{
+    int fd = fileno(stream);
+    if (epoll_fd < 0)
+        event_loop_init();
+
+    input_ready = false;
+    watch_input(fd);
+    while (input_fd == fd && !input_ready)
+    {
+        if (event_loop_run_once(-1) < 0)
+        {
+            if (errno != EINTR)
+                break;
+            // SIGINT/SIGWINCH yang ditangkap readline diproses di sini
+            rl_check_signals();
+        }
+    }
+
+    unsigned char c;
+    while (true)
+    {
+        ssize_t n = read(fd, &c, 1);
+        if (n == 1)
+            return c;
+        if (n == 0)
+            return EOF;
+        if (errno == EINTR)
+        {
+            rl_check_signals();
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            int flags = fcntl(fd, F_GETFL);
+            if (flags != -1 && fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == 0)
+                continue;
+        }
+        return EOF;
+    }
+}
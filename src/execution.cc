@@ -10,65 +10,45 @@
 #include <cstring>
 #include <csignal>
 #include <cstdlib>
+#include <climits>
 #include <utils.h>
 #include <filesystem>
 #include <unistd.h>
 #include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <ctime>
 #include <sstream>
+#include <algorithm>
 #include <fstream>
 
 #include "input.h" // untuk PS0
+#include "redir_cache.h"
+#include "events.h"
+#include "job_registry.h"
+#include "job_scheduler.h"
+#include "job_perf.h"
+#include "job_placement.h"
+#include "job_timing.h"
+#include "job_output.h"
+#include "job_limits.h"
+#include "pipe_relay.h"
 
 namespace fs = std::filesystem;
 
 #include <sys/time.h>
 #include <sys/resource.h>
 
+#include <thread>
+#include <future>
+#include <mutex>
+#include <pthread.h>
 
+// Builtins can now run on pipeline threads while the shell thread runs
+// another builtin; every access to shell state goes through this lock.
+std::recursive_mutex builtin_state_mutex;
 
 
-// Fungsi pembantu untuk menulis status job ke file kontrol
-void write_job_controle_file(const Job& job) {
-    // Abaikan job yang sudah selesai dilaporkan (DONE, EXITED, SIGNALED)
-    if (job.status == JobStatus::DONE || job.status == JobStatus::EXITED || job.status == JobStatus::SIGNALED) {
-        // Hapus file kontrol jika job sudah selesai.
-        fs::path job_dir = ns_CONFIG_DIR / "jobs";
-        fs::path file_path = job_dir / ("jobs_" + std::to_string(job.pgid) + ".controle");
-        if (fs::exists(file_path)) {
-            fs::remove(file_path);
-        }
-        return;
-    }
-    
-    fs::path job_dir = ns_CONFIG_DIR / "jobs";
-    fs::create_directories(job_dir); // Pastikan direktori ada
-    fs::path file_path = job_dir / ("jobs_" + std::to_string(job.pgid) + ".controle");
-    
-    std::ofstream ofs(file_path);
-    if (!ofs.is_open()) {
-        std::cerr << "nsh: Error writing job controle file for PGID " << job.pgid << std::endl;
-        return;
-    }
-
-    // Format Key=Value untuk mempermudah pembacaan
-    ofs << "PGID=" << job.pgid << "\n";
-    ofs << "SHELL_PID=" << getpid() << "\n"; // Gunakan PID shell saat ini
-    ofs << "COMMAND=" << job.command << "\n";
-    ofs << "STATUS=" << static_cast<int>(job.status) << "\n";
-    ofs << "TERM_STATUS=" << job.term_status << "\n";
-    
-    // Resource Usage (CPU time)
-    ofs << "RUTIME_SEC=" << job.usage.ru_utime.tv_sec << "\n";
-    ofs << "RUTIME_USEC=" << job.usage.ru_utime.tv_usec << "\n";
-    ofs << "RSTIME_SEC=" << job.usage.ru_stime.tv_sec << "\n";
-    ofs << "RSTIME_USEC=" << job.usage.ru_stime.tv_usec << "\n";
-    
-    // Start Time (untuk perhitungan CPU %)
-    ofs << "START_TIME_SEC=" << job.start_tv.tv_sec << "\n";
-    ofs << "START_TIME_USEC=" << job.start_tv.tv_usec << "\n";
-    
-    ofs.close();
-}
 
 
 // This would normally be in a header file (like globals.h)
@@ -80,191 +60,308 @@ std::string job_status_to_string_simple(JobStatus status) { return status == Job
 
 std::vector<std::pair<int, Job>> finished_jobs;
 
+// Diinisialisasi sebelum main(), jadi di thread utama
+static const std::thread::id main_thread_id = std::this_thread::get_id();
+
 /**
  * @brief Checks for status changes in child processes without blocking.
  *
- * Uses wait4() to reap terminated children and gather resource usage.
- * Finished jobs are moved to a separate queue to be reported to the user
- * before the next prompt.
+ * Child events are delivered through the event loop (signalfd + pidfd), so
+ * this only dispatches whatever is already pending. Finished jobs are moved
+ * to a separate queue to be reported to the user before the next prompt.
+ * Only the main thread owns the event loop and the job table: called from a
+ * pipeline thread this does nothing.
  */
 void check_child_status()
 {
-    int status;
-    pid_t pid;
-    struct rusage usage;
+    if (std::this_thread::get_id() != main_thread_id)
+        return;
+    while (event_loop_run_once(0) > 0)
+        ;
+}
 
-    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0)
-    {
-        for (auto it = jobs.begin(); it != jobs.end(); )
-        {
-            if (it->second.pgid == pid || it->second.pgid == getpgid(pid))
-            {
-                it->second.usage = usage; // Update usage stats
+// Index pgid -> job id dan daftar job yang berubah sejak terakhir
+// dipublikasikan ke registry. Update job cukup O(1), publish O(job yang berubah).
+static std::unordered_map<pid_t, int> job_id_by_pgid;
+static std::unordered_set<pid_t> dirty_job_pgids;
 
-                if (WIFEXITED(status) || WIFSIGNALED(status))
-                {
-                    // Job has finished
-                    if (WIFEXITED(status)) {
-                        int exit_code = WEXITSTATUS(status);
-                        if (exit_code == 0) {
-                            it->second.status = JobStatus::DONE;
-                        } else {
-                            it->second.status = JobStatus::EXITED;
-                        }
-                        it->second.term_status = exit_code;
-                    } else { // WIFSIGNALED
-                        it->second.status = JobStatus::SIGNALED;
-                        it->second.term_status = WTERMSIG(status);
-                    }
-                    write_job_controle_file(it->second);
-                    finished_jobs.push_back(*it);
-                    it = jobs.erase(it);
-                }
-                else if (WIFSTOPPED(status))
-                {
-                    // Job has stopped - PERBAIKAN: Pastikan status STOPPED tercatat
-                    if (isatty(STDIN_FILENO))
-                        std::cout << "\n[" << it->first << "]+ Stopped\t" << it->second.command << std::endl;
-                    it->second.status = JobStatus::STOPPED;  // PASTIKAN INI
-                    it->second.term_status = WSTOPSIG(status);
-                    
-                    if (it->first != current_job_id) {
-                        previous_job_id = current_job_id;
-                        current_job_id = it->first;
-                    }
-                    
-                    write_job_controle_file(it->second);
-                    ++it;
-                }
-                else if (WIFCONTINUED(status))
-                {
-                    // Job has continued
-                    it->second.status = JobStatus::RUNNING;
-                    
-                    if (it->first != current_job_id) {
-                        previous_job_id = current_job_id;
-                        current_job_id = it->first;
-                    }
-                    
-                    write_job_controle_file(it->second);
-                    ++it;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
-            else
-            {
-                ++it;
-            }
-        }
+// Scan registry untuk slot yatim (shell crash) cukup sesekali
+constexpr time_t ORPHAN_SCAN_INTERVAL = 60;
+static time_t last_orphan_scan = 0;
+
+Job *find_job_by_pgid(pid_t pgid, int *job_id)
+{
+    auto it = job_id_by_pgid.find(pgid);
+    if (it == job_id_by_pgid.end())
+        return nullptr;
+    auto job_it = jobs.find(it->second);
+    if (job_it == jobs.end()) {
+        job_id_by_pgid.erase(it);
+        return nullptr;
     }
+    if (job_id)
+        *job_id = it->second;
+    return &job_it->second;
+}
+
+void mark_job_dirty(pid_t pgid)
+{
+    dirty_job_pgids.insert(pgid);
+}
+
+void remove_job(int job_id)
+{
+    auto it = jobs.find(job_id);
+    if (it == jobs.end())
+        return;
+    job_id_by_pgid.erase(it->second.pgid);
+    dirty_job_pgids.insert(it->second.pgid); // slot registry-nya ikut dihapus
+    perf_discard(it->second.pgid);
+    scheduler_job_gone(it->second.pgid);
+    jobs.erase(it);
 }
 
 /**
- * @brief Validates and cleans up stale jobs from both memory and control files.
+ * @brief Publishes the jobs that changed since the last flush to the
+ *        cross-session registry.
  *
- * This function actively queries the OS to determine the real status of each job's
- * process group. It updates the job status in memory, moves completed jobs to the
- * finished queue, and removes stale control files for non-existent processes.
+ * Jobs that are no longer in the list are removed from the registry.
  */
-void validate_and_cleanup_jobs() {
-    // --- Phase 1: Validate and update in-memory jobs (the 'jobs' map) ---
-    for (auto it = jobs.begin(); it != jobs.end(); ) {
-        Job& job = it->second;
-        pid_t pgid = job.pgid;
-
-        // The job is alive, let's update its status using a non-blocking waitpid.
-        int status;
-        pid_t result = waitpid(-pgid, &status, WNOHANG | WUNTRACED | WCONTINUED);
-
-        if (result > 0) { // A status change was detected
-            if (WIFEXITED(status)) {
-                job.status = (WEXITSTATUS(status) == 0) ? JobStatus::DONE : JobStatus::EXITED;
-                job.term_status = WEXITSTATUS(status);
-            } else if (WIFSIGNALED(status)) {
-                job.status = JobStatus::SIGNALED;
-                job.term_status = WTERMSIG(status);
-            } else if (WIFSTOPPED(status)) {
-                job.status = JobStatus::STOPPED;
-                job.term_status = WSTOPSIG(status);
-            } else if (WIFCONTINUED(status)) {
-                job.status = JobStatus::RUNNING;
-            }
-        } else if (result < 0 && errno == ECHILD) {
-            // waitpid failed because the process group doesn't exist anymore.
-            // Mark the job as DONE to ensure its control file is removed.
-            job.status = JobStatus::DONE;
+void flush_job_updates()
+{
+    for (pid_t pgid : dirty_job_pgids) {
+        int job_id = 0;
+        if (Job *job = find_job_by_pgid(pgid, &job_id))
+            registry_publish_job(job_id, *job);
+        else
+            registry_remove_job(pgid);
+    }
+    dirty_job_pgids.clear();
+    registry_notify();
+}
+
+// Exit code job background yang sudah selesai, supaya `wait PID|%job` tetap
+// dapat statusnya setelah job hilang dari job list. Dibatasi seperti CHILD_MAX
+// di bash: status tertua dibuang.
+constexpr size_t FINISHED_STATUS_MAX = 1024;
+static std::unordered_map<pid_t, int> finished_exit_codes;
+static std::unordered_map<int, pid_t> finished_job_pgids; // job id -> pgid
+static std::deque<std::pair<int, pid_t>> finished_exit_order;
+static std::function<void(pid_t, int)> job_wait_hook;
+
+static void record_finished_exit_code(int job_id, pid_t pgid, int exit_code)
+{
+    if (finished_exit_codes.count(pgid) == 0) {
+        finished_exit_order.emplace_back(job_id, pgid);
+        if (finished_exit_order.size() > FINISHED_STATUS_MAX) {
+            auto [old_id, old_pgid] = finished_exit_order.front();
+            finished_exit_codes.erase(old_pgid);
+            auto it = finished_job_pgids.find(old_id);
+            if (it != finished_job_pgids.end() && it->second == old_pgid)
+                finished_job_pgids.erase(it);
+            finished_exit_order.pop_front();
         }
-        
-        // After potential status update, check if the job is finished.
-        if (job.status == JobStatus::DONE || job.status == JobStatus::EXITED || job.status == JobStatus::SIGNALED) {
-            // Move to finished_jobs to be reported, then erase from active jobs.
-            finished_jobs.push_back(*it);
-            write_job_controle_file(job); // This will delete the control file for a finished job.
-            it = jobs.erase(it);
+    }
+    finished_exit_codes[pgid] = exit_code;
+    finished_job_pgids[job_id] = pgid;
+}
+
+void set_job_wait_hook(std::function<void(pid_t pgid, int exit_code)> hook)
+{
+    job_wait_hook = std::move(hook);
+}
+
+bool finished_job_exit_code(pid_t pgid, int *exit_code)
+{
+    auto it = finished_exit_codes.find(pgid);
+    if (it == finished_exit_codes.end())
+        return false;
+    if (exit_code)
+        *exit_code = it->second;
+    return true;
+}
+
+pid_t finished_job_pgid(int job_id)
+{
+    auto it = finished_job_pgids.find(job_id);
+    return it == finished_job_pgids.end() ? 0 : it->second;
+}
+
+// Job selesai: pindahkan ke antrian laporan dan keluarkan dari list
+static void finish_job(int job_id)
+{
+    auto it = jobs.find(job_id);
+    if (it == jobs.end())
+        return;
+    finished_jobs.push_back(*it);
+    remove_job(job_id);
+}
+
+/**
+ * @brief Applies a status change reported by the event loop to the job
+ *        owning process group `pgid`.
+ *
+ * @param status     waitpid-style status (last stage when group_done)
+ * @param usage      accumulated rusage of the processes that have exited
+ * @param group_done true once every process in the group has exited
+ */
+void job_process_changed(pid_t pgid, int status, const struct rusage &usage, bool group_done)
+{
+    int job_id = 0;
+    Job *job = find_job_by_pgid(pgid, &job_id);
+    if (!job)
+        return;
+
+    job->usage = usage;
+    if (group_done)
+    {
+        int exit_code;
+        if (WIFSIGNALED(status)) {
+            job->status = JobStatus::SIGNALED;
+            job->term_status = WTERMSIG(status);
+            exit_code = 128 + WTERMSIG(status);
         } else {
-            // The job is still active (Running or Stopped), so update its control file.
-            write_job_controle_file(job);
-            ++it;
+            exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+            job->status = (exit_code == 0) ? JobStatus::DONE : JobStatus::EXITED;
+            job->term_status = exit_code;
         }
-    }
-    
-    // --- Phase 2: Clean up orphaned control files ---
-    // This finds control files for jobs that are not in memory, possibly left from a crash.
-    fs::path job_dir = ns_CONFIG_DIR / "jobs";
-    if (fs::exists(job_dir) && fs::is_directory(job_dir)) {
-        for (const auto& entry : fs::directory_iterator(job_dir)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".controle") {
-                std::string filename = entry.path().filename().string();
-                if (filename.rfind("jobs_", 0) == 0) { // filename starts with "jobs_"
-                    try {
-                        std::string pgid_str = filename.substr(5, filename.find(".controle") - 5);
-                        pid_t pgid = std::stoi(pgid_str);
-                        
-                        // Check if the process group for this file still exists.
-                        if (kill(-pgid, 0) == -1 && errno == ESRCH) {
-                            // PGID does not exist, so the control file is an orphan. Remove it.
-                            fs::remove(entry.path());
-                        }
-                    } catch (const std::exception&) {
-                        // Malformed filename, remove it to be safe.
-                        fs::remove(entry.path());
-                    }
-                }
-            }
+        // Total counter dilaporkan bersama "Done" (shell interaktif) atau
+        // langsung di stderr
+        if (perf_is_counted(pgid)) {
+            job->perf_summary = perf_format(perf_finish(pgid, usage));
+            if (!isatty(STDIN_FILENO))
+                std::cerr << "[" << job_id << "] " << job->perf_summary << std::endl;
+        }
+        if (!job->pipe_meters.empty()) {
+            pipe_meter_settle(job->pipe_meters);
+            job->pipe_summary = pipe_meter_format(job->pipe_meters);
+            job->pipe_meters.clear();
+            if (!isatty(STDIN_FILENO))
+                std::cerr << "[" << job_id << "] pipes:\n" << job->pipe_summary << std::flush;
         }
+        finish_job(job_id);
+        coproc_job_finished(pgid);
+        record_finished_exit_code(job_id, pgid, exit_code);
+        if (job_wait_hook)
+            job_wait_hook(pgid, exit_code);
+    }
+    else if (WIFSTOPPED(status))
+    {
+        job->status = JobStatus::STOPPED;
+        job->term_status = WSTOPSIG(status);
+        mark_job_dirty(pgid);
+        scheduler_job_running(pgid, false);
+        if (job_wait_hook)
+            job_wait_hook(pgid, 128 + WSTOPSIG(status));
+    }
+    else if (WIFCONTINUED(status))
+    {
+        job->status = JobStatus::RUNNING;
+        mark_job_dirty(pgid);
+        scheduler_job_running(pgid, true);
     }
+
+    // Slot yang baru kosong langsung dipakai job antrian scheduler
+    scheduler_dispatch();
+
+    // Publish ke registry hanya tulis memori: langsung saja, supaya session
+    // lain melihat perubahan tanpa menunggu prompt berikutnya di sini
+    flush_job_updates();
+}
+
+/**
+ * @brief Records the exit of one pipeline stage in its job.
+ *
+ * Called by the event loop for every child that exits, before
+ * job_process_changed() sees the group finish. The stage keeps its own
+ * status and rusage; the job total grows by this process only.
+ */
+void job_stage_exited(pid_t pgid, pid_t pid, int status, const struct rusage &usage)
+{
+    Job *job = find_job_by_pgid(pgid);
+    if (!job)
+        return;
+    for (JobStage &stage : job->stages)
+    {
+        if (stage.pid != pid || stage.finished)
+            continue;
+        stage.finished = true;
+        stage.status = status;
+        stage.usage = usage;
+        add_rusage(job->usage, usage);
+        mark_job_dirty(pgid);
+        return;
+    }
+}
+
+/**
+ * @brief Frees registry slots left behind by shells that died without
+ *        cleaning up (the process group no longer exists).
+ *
+ * Runs at most once every ORPHAN_SCAN_INTERVAL seconds unless forced.
+ */
+void cleanup_orphan_jobs(bool force)
+{
+    time_t now = time(nullptr);
+    if (!force && last_orphan_scan != 0 && now - last_orphan_scan < ORPHAN_SCAN_INTERVAL)
+        return;
+    last_orphan_scan = now;
+
+    // Job lokal yang tidak dikenal event loop (tidak seharusnya terjadi)
+    // dan process group-nya sudah hilang
+    std::vector<int> gone;
+    for (const auto &[id, job] : jobs) {
+        if (!event_loop_has_group(job.pgid) && kill(-job.pgid, 0) == -1 && errno == ESRCH)
+            gone.push_back(id);
+    }
+    for (int id : gone) {
+        jobs[id].status = JobStatus::DONE;
+        finish_job(id);
+    }
+
+    registry_reap_stale();
+}
+
+/**
+ * @brief Brings the job list up to date before running a command line.
+ *
+ * Only jobs whose state actually changed are touched: the event loop updates
+ * them through job_process_changed(), and only they are republished to the
+ * registry. The scan for orphaned registry slots runs on a timer.
+ */
+void validate_and_cleanup_jobs() {
+    check_child_status();
+    scheduler_dispatch(); // batas NSH_MAX_BG_JOBS bisa saja baru dinaikkan
+    flush_job_updates();
+    cleanup_orphan_jobs(false);
 }
 
 
 /**
  * @brief Adds a job to the jobs list regardless of its type
  */
-int add_job_to_list(pid_t pgid, const std::string& command, JobStatus status, bool update_current) {
-    // First, validate and cleanup any stale jobs
-    validate_and_cleanup_jobs();
-    
+int add_job_to_list(pid_t pgid, const std::string& command, JobStatus status, bool update_current, int reserved_id) {
+    // Tidak memanggil validate_and_cleanup_jobs(): event loop tidak boleh
+    // men-dispatch exit child job ini sebelum job-nya tercatat.
+
     // Check if job already exists
-    for (const auto& [id, job] : jobs) {
-        if (job.pgid == pgid) {
-            // Update existing job
-            jobs[id].command = command;
-            jobs[id].status = status;
-            gettimeofday(&jobs[id].start_tv, nullptr);
-            write_job_controle_file(jobs[id]);
-            return id;
-        }
+    int existing_id = 0;
+    if (Job *existing = find_job_by_pgid(pgid, &existing_id)) {
+        existing->command = command;
+        existing->status = status;
+        gettimeofday(&existing->start_tv, nullptr);
+        mark_job_dirty(pgid);
+        return existing_id;
     }
     
     // Create new job
+    int job_id = reserved_id ? reserved_id : next_job_id++;
     if (update_current) {
         previous_job_id = current_job_id;
-        current_job_id = next_job_id;
+        current_job_id = job_id;
     }
     
-    Job& new_job = jobs[next_job_id];
+    Job& new_job = jobs[job_id];
     new_job.pgid = pgid;
     new_job.command = command;
     new_job.status = status;
@@ -272,14 +369,13 @@ int add_job_to_list(pid_t pgid, const std::string& command, JobStatus status, bo
     gettimeofday(&new_job.start_tv, nullptr);
     memset(&new_job.usage, 0, sizeof(new_job.usage));
     
-    int job_id = next_job_id;
-    next_job_id++;
+    job_id_by_pgid[pgid] = job_id;
     
     if (update_current) {
         last_launched_job_id = current_job_id;
     }
     
-    write_job_controle_file(new_job);
+    mark_job_dirty(pgid);
     
     return job_id;
 }
@@ -313,7 +409,16 @@ void handle_here_document(const std::string &delimiter)
     safe_set_raw_mode();
 }
 
-void handle_redirection(const SimpleCommand &cmd)
+// Error redirection di child mengakhiri proses; di shell sendiri (builtin,
+// `exec 3>file`) cukup dilaporkan supaya shell tidak ikut keluar.
+static bool redirection_failed(bool fatal)
+{
+    if (fatal)
+        exit_shell(1);
+    return false;
+}
+
+bool apply_redirections(const SimpleCommand &cmd, bool fatal)
 {
     // Urutan eksekusi redirection sangat penting. Loop ini memprosesnya sesuai urutan di command line.
     for (const auto& redir : cmd.redirections) {
@@ -332,16 +437,18 @@ void handle_redirection(const SimpleCommand &cmd)
                     file_to_open = "heredoc.tmp";
                 }
 
-                int fd_in = open(expand_tilde(file_to_open).c_str(), O_RDONLY);
+                int cached_fd = redir_cache_lookup(redir);
+                int fd_in = cached_fd != -1 ? cached_fd : open(expand_tilde(file_to_open).c_str(), O_RDONLY);
                 if (fd_in == -1) {
                     perror(("nsh: " + file_to_open).c_str());
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 if (dup2(fd_in, redir.source_fd) == -1) {
                     perror("nsh: dup2 failed for stdin");
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
-                close(fd_in);
+                if (fd_in != cached_fd)
+                    close(fd_in);
                 if (redir.type == RedirectionType::HERE_DOC) {
                     unlink(file_to_open.c_str());
                 }
@@ -353,14 +460,14 @@ void handle_redirection(const SimpleCommand &cmd)
                 int pipe_fd[2];
                 if (pipe(pipe_fd) == -1) {
                     perror("nsh: pipe for here-string failed");
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 write(pipe_fd[1], redir.content.c_str(), redir.content.length());
                 write(pipe_fd[1], "\n", 1);
                 close(pipe_fd[1]);
                 if (dup2(pipe_fd[0], redir.source_fd) == -1) {
                     perror("nsh: dup2 failed for here-string");
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 close(pipe_fd[0]);
                 break;
@@ -376,17 +483,19 @@ void handle_redirection(const SimpleCommand &cmd)
                     flags |= O_TRUNC;
                 }
 
-                int fd_out = open(expand_tilde(redir.target_file).c_str(), flags, 0666);
+                int cached_fd = redir_cache_lookup(redir);
+                int fd_out = cached_fd != -1 ? cached_fd : open(expand_tilde(redir.target_file).c_str(), flags, 0666);
                 if (fd_out == -1) {
                     perror(("nsh: " + redir.target_file).c_str());
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 
                 if (dup2(fd_out, redir.source_fd) == -1) {
                     perror("nsh: dup2 failed for stdout/stderr");
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
-                close(fd_out);
+                if (fd_out != cached_fd)
+                    close(fd_out);
                 break;
             }
 
@@ -400,22 +509,32 @@ void handle_redirection(const SimpleCommand &cmd)
                     flags |= O_TRUNC;
                 }
 
-                int fd_out = open(expand_tilde(redir.target_file).c_str(), flags, 0666);
+                int cached_fd = redir_cache_lookup(redir);
+                int fd_out = cached_fd != -1 ? cached_fd : open(expand_tilde(redir.target_file).c_str(), flags, 0666);
                 if (fd_out == -1) {
                     perror(("nsh: " + redir.target_file).c_str());
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 
                 // &> dan &>>
-                if (dup2(fd_out, 1) == -1) { perror("nsh: dup2 failed for stdout"); exit_shell(1); }
-                if (dup2(fd_out, 2) == -1) { perror("nsh: dup2 failed for stderr"); exit_shell(1); }
-                close(fd_out);
+                if (dup2(fd_out, 1) == -1) { perror("nsh: dup2 failed for stdout"); return redirection_failed(fatal); }
+                if (dup2(fd_out, 2) == -1) { perror("nsh: dup2 failed for stderr"); return redirection_failed(fatal); }
+                if (fd_out != cached_fd)
+                    close(fd_out);
                 break;
             }
             
             case RedirectionType::DUPLICATE_OUT: // >&fd
             case RedirectionType::DUPLICATE_IN:  // <&fd
             {
+                if (redir.target_fd < 0) {
+                    // Angka di luar jangkauan fd (`>&99999999999`)
+                    if (is_string_numeric(redir.target_file))
+                        std::cerr << "nsh: " << redir.target_file << ": bad file descriptor" << std::endl;
+                    else
+                        std::cerr << "nsh: " << redir.target_file << ": ambiguous redirect" << std::endl;
+                    return redirection_failed(fatal);
+                }
                 if (dup2(redir.target_fd, redir.source_fd) == -1) {
                     // Cek jika target_fd valid
                     if (fcntl(redir.target_fd, F_GETFL) == -1 && errno == EBADF) {
@@ -423,7 +542,7 @@ void handle_redirection(const SimpleCommand &cmd)
                     } else {
                         perror("nsh: dup2 failed for fd duplication");
                     }
-                    exit_shell(1);
+                    return redirection_failed(fatal);
                 }
                 break;
             }
@@ -438,6 +557,13 @@ void handle_redirection(const SimpleCommand &cmd)
                 break;
         }
     }
+
+    return true;
+}
+
+void handle_redirection(const SimpleCommand &cmd)
+{
+    apply_redirections(cmd, true);
 }
 
 
@@ -553,7 +679,7 @@ std::vector<char*> build_envp() {
     return envp;
 }
 
-void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const std::string &original_cmd_name = "", bool use_env = true)
+void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const std::string &original_cmd_name, bool use_env)
 {
     // Check if this is a builtin command in a child process
     if (!cmd.tokens.empty() && is_builtin(cmd.tokens[0]))
@@ -564,13 +690,17 @@ void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const
         exit_shell(exit_code);
     }
 
-    pid_t pid = getpid();
-    if (pgid == 0)
-        pgid = pid;
-    setpgid(pid, pgid);
+    // Di dalam child helper, process group dan terminal milik job induk
+    if (!in_helper_child)
+    {
+        pid_t pid = getpid();
+        if (pgid == 0)
+            pgid = pid;
+        setpgid(pid, pgid);
 
-    if (foreground)
-        tcsetpgrp(STDIN_FILENO, pgid);
+        if (foreground)
+            tcsetpgrp(STDIN_FILENO, pgid);
+    }
 
     restore_terminal_mode();
 
@@ -588,6 +718,17 @@ void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const
     signal(SIGTTOU, SIG_DFL);
     signal(SIGCHLD, SIG_DFL);
 
+    // NSH_BG_CPUS/NICE/SCHED/IOPRIO untuk job background
+    if (!foreground)
+        placement_apply(cmd);
+
+    // `limit ... -- cmd`: gagal memasang limit berarti command tidak jalan
+    if (!limits_apply(cmd))
+        _exit(125);
+
+    // NSH_PERF_COUNTERS/`time --perf`: tunggu counter dipasang parent
+    perf_child_ready();
+
     handle_redirection(cmd);
 
     char **argv = static_cast<char **>(safe_malloc((cmd.tokens.size() + 1) * sizeof(char *)));
@@ -657,6 +798,7 @@ void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const
           std::cout << PS0_display << "\n";
         }
         // Eksekusi dengan path absolut
+        event_loop_prepare_exec();
         execve(cmd.tokens[0].c_str(), argv, envp.data());
         
         // Safe memory, cleanup
@@ -721,10 +863,64 @@ bool is_builtin(const std::string &command)
 {
     static const std::set<std::string> builtins = {
         "exit", "cd", "alias", "unalias", "history", "pwd",
-        "jobs", "fg", "bg", "kill", "export", "bookmark", "exec", "unset", "hash", "type"};
+        "jobs", "fg", "bg", "kill", "export", "bookmark", "exec", "unset", "hash", "type",
+        "coproc", "read", "wait", "parallel", "sleep", "timeout", "every", "ulimit"};
     return builtins.count(command);
 }
 
+/**
+ * @brief Cek apakah builtin boleh dijalankan di thread pipeline (bukan fork).
+ *
+ * Hanya builtin yang sekadar menampilkan state shell (tanpa mengubahnya dan
+ * tanpa redirection sendiri) yang memenuhi syarat, sehingga semantik
+ * "pipeline berjalan di subshell" tetap terjaga, e.g. `alias x=y | cat`
+ * tetap tidak mengubah alias milik shell.
+ */
+bool is_thread_safe_builtin(const SimpleCommand &cmd)
+{
+    if (cmd.tokens.empty() || !cmd.redirections.empty() || !cmd.env_vars.empty())
+        return false;
+
+    const std::string &name = cmd.tokens[0];
+    // jobs tidak termasuk: job list diubah event loop di thread utama
+    // selama pipeline berjalan
+    if (name == "pwd" || name == "type")
+        return true;
+
+    if (name == "history")
+    {
+        // history -c/-d/-w/-r/-a... mengubah history list atau file
+        for (size_t i = 1; i < cmd.tokens.size(); ++i)
+        {
+            if (!cmd.tokens[i].empty() && cmd.tokens[i][0] == '-')
+                return false;
+        }
+        return true;
+    }
+    if (name == "hash")
+    {
+        // Hanya `hash` (list), `hash -l` dan `hash -t name...`
+        if (cmd.tokens.size() == 1)
+            return true;
+        return cmd.tokens[1] == "-l" || cmd.tokens[1] == "-t";
+    }
+    if (name == "alias")
+    {
+        // `alias` atau `alias name...` (tanpa definisi baru)
+        for (size_t i = 1; i < cmd.tokens.size(); ++i)
+        {
+            if (cmd.tokens[i].find('=') != std::string::npos)
+                return false;
+        }
+        return true;
+    }
+    if (name == "export")
+    {
+        return cmd.tokens.size() == 1 || (cmd.tokens.size() == 2 && cmd.tokens[1] == "-p");
+    }
+    return false;
+}
+
 void handle_builtin_type(const std::vector<std::string>& tokens) {
     if (tokens.size() < 2) {
         std::cerr << "nsh: type: usage: type [-a] name [name ...]" << std::endl;
@@ -761,14 +957,19 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
         // 1. Cek sebagai alias
         auto alias_it = aliases.find(name);
         if (alias_it != aliases.end()) {
-            std::cout << name << " is aliased to `" << alias_it->second << "`" << std::endl;
+            builtin_out() << name << " is aliased to `" << alias_it->second << "`\n";
             found = true;
             if (!find_all) continue;
         }
 
-        // 2. Cek sebagai builtin
+        // 2. Cek sebagai keyword atau builtin
+        if (name == "time" || name == "limit") {
+            builtin_out() << name << " is a shell keyword\n";
+            found = true;
+            if (!find_all) continue;
+        }
         if (is_builtin(name)) {
-            std::cout << name << " is a shell builtin" << std::endl;
+            builtin_out() << name << " is a shell builtin\n";
             found = true;
             if (!find_all) continue;
         }
@@ -779,13 +980,13 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
             const auto& var_info = env_it->second;
             
             if (var_info.is_default && var_info.is_exported) {
-                std::cout << name << " is a default and exported variable" << std::endl;
+                builtin_out() << name << " is a default and exported variable\n";
             } else if (var_info.is_default) {
-                std::cout << name << " is a default variable" << std::endl;
+                builtin_out() << name << " is a default variable\n";
             } else if (var_info.is_exported) {
-                std::cout << name << " is an exported variable" << std::endl;
+                builtin_out() << name << " is an exported variable\n";
             } else {
-                std::cout << name << " is a session variable" << std::endl;
+                builtin_out() << name << " is a session variable\n";
             }
             found = true;
             if (!find_all) continue;
@@ -802,7 +1003,7 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
                     std::string bookmark_path = line.substr(space_pos + 1);
                     
                     if (bookmark_name == name) {
-                        std::cout << name << " is a bookmark to `" << bookmark_path << "`" << std::endl;
+                        builtin_out() << name << " is a bookmark to `" << bookmark_path << "`\n";
                         found = true;
                         bookmark_file.close();
                         if (!find_all) break;
@@ -821,7 +1022,7 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
         // Periksa apakah sudah ada di hash table
         auto hash_it = binary_hash_loc.find(name);
         if (hash_it != binary_hash_loc.end()) {
-            std::cout << name << " is hashed (" << hash_it->second.path << ")" << std::endl;
+            builtin_out() << name << " is hashed (" << hash_it->second.path << ")\n";
             found = true;
             if (!find_all) continue;
         } else {
@@ -837,7 +1038,7 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
                     
                     fs::path binary_path = fs::path(path_dir) / name;
                     if (fs::exists(binary_path) && fs::is_regular_file(binary_path)) {
-                        std::cout << name << " is " << binary_path.string() << std::endl;
+                        builtin_out() << name << " is " << binary_path.string() << '\n';
                         found = true;
                         path_found = true;
                         if (!find_all) break;
@@ -858,6 +1059,7 @@ void handle_builtin_type(const std::vector<std::string>& tokens) {
 
 int execute_builtin(const SimpleCommand &cmd)
 {
+    std::unique_lock<std::recursive_mutex> state_lock(builtin_state_mutex);
     std::map<std::string, std::string> original_env;
 
     for (const auto &[var_name, value] : cmd.env_vars)
@@ -879,6 +1081,13 @@ int execute_builtin(const SimpleCommand &cmd)
     if (tokens.empty())
         return 0;
 
+    // Output builtin ditulis lewat buffer fd 1 (bukan std::cout + std::endl);
+    // thread stage sudah punya scope sendiri
+    std::cout.flush();
+    std::unique_ptr<BuiltinOutputScope> out_scope;
+    if (!builtin_out_bound())
+        out_scope.reset(new BuiltinOutputScope(STDOUT_FILENO));
+
     if (tokens[0] == "exit")
     {
         exit_shell(tokens.size() > 1 ? std::stoi(tokens[1]) : 0);
@@ -929,7 +1138,14 @@ int execute_builtin(const SimpleCommand &cmd)
     }
     else if (tokens[0] == "jobs")
     {
+       // jobs --top dan -f berjalan sampai Ctrl-C: lepaskan lock seperti read
+       bool top = std::find(tokens.begin(), tokens.end(), "--top") != tokens.end() ||
+                  std::find(tokens.begin(), tokens.end(), "-f") != tokens.end();
+       if (top)
+           state_lock.unlock();
        handle_builtin_jobs(tokens);
+       if (top)
+           state_lock.lock();
     }
     else if (tokens[0] == "kill")
     {
@@ -943,6 +1159,51 @@ int execute_builtin(const SimpleCommand &cmd)
     {
        handle_builtin_fg(tokens);
     }
+    else if (tokens[0] == "coproc")
+    {
+       handle_builtin_coproc(tokens);
+    }
+    else if (tokens[0] == "read")
+    {
+       // read bisa menunggu lama (pipe, coproc, terminal); jangan tahan lock
+       // selama itu, builtin di thread pipeline (`pwd | read dir`) butuh lock
+       state_lock.unlock();
+       handle_builtin_read(tokens);
+       state_lock.lock();
+    }
+    else if (tokens[0] == "wait")
+    {
+       handle_builtin_wait(tokens);
+    }
+    else if (tokens[0] == "parallel")
+    {
+       // Worker pool bisa berjalan lama: lepaskan lock seperti read
+       state_lock.unlock();
+       handle_builtin_parallel(tokens);
+       state_lock.lock();
+    }
+    else if (tokens[0] == "sleep")
+    {
+       state_lock.unlock();
+       handle_builtin_sleep(tokens);
+       state_lock.lock();
+    }
+    else if (tokens[0] == "timeout")
+    {
+       state_lock.unlock();
+       handle_builtin_timeout(tokens);
+       state_lock.lock();
+    }
+    else if (tokens[0] == "every")
+    {
+       state_lock.unlock();
+       handle_builtin_every(tokens);
+       state_lock.lock();
+    }
+    else if (tokens[0] == "ulimit")
+    {
+       handle_builtin_ulimit(tokens);
+    }
     
     for (const auto &[var_name, value] : cmd.env_vars)
     {
@@ -959,47 +1220,619 @@ int execute_builtin(const SimpleCommand &cmd)
     return last_exit_code;
 }
 
-int execute_job(const ParsedCommand &cmd_group, bool use_env)
+// Simpan semua fd yang akan disentuh redirection builtin di shell,
+// supaya `pwd 2>/dev/null` atau `jobs 3>x` tidak bocor ke shell.
+// backup -1 berarti fd tersebut sebelumnya tertutup.
+static std::vector<std::pair<int, int>> save_redirected_fds(const SimpleCommand &cmd)
+{
+    std::vector<int> fds = {STDIN_FILENO, STDOUT_FILENO};
+    for (const auto &redir : cmd.redirections)
+    {
+        fds.push_back(redir.source_fd);
+        if (redir.type == RedirectionType::REDIR_OUT_ERR ||
+            redir.type == RedirectionType::REDIR_OUT_ERR_APPEND)
+        {
+            fds.push_back(STDOUT_FILENO);
+            fds.push_back(STDERR_FILENO);
+        }
+    }
+
+    std::vector<std::pair<int, int>> saved;
+    for (int fd : fds)
+    {
+        if (fd < 0)
+            continue;
+        bool seen = false;
+        for (const auto &entry : saved)
+            seen = seen || entry.first == fd;
+        if (!seen)
+            saved.push_back({fd, fcntl(fd, F_DUPFD_CLOEXEC, 10)});
+    }
+    return saved;
+}
+
+static void restore_redirected_fds(const std::vector<std::pair<int, int>> &saved)
+{
+    for (const auto &[fd, backup] : saved)
+    {
+        if (backup >= 0)
+        {
+            dup2(backup, fd);
+            close(backup);
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+}
+
+// Process substitution yang sedang berjalan untuk satu job.
+// consumer_fds[i] berisi ujung pipe milik stage ke-i (/dev/fd/N).
+struct ProcessSubstitutions
+{
+    pid_t pgid = 0;
+    std::vector<pid_t> pids;
+    std::vector<std::vector<int>> consumer_fds;
+
+    ~ProcessSubstitutions()
+    {
+        // Ujung yang belum ditutup (stage di shell, error sebelum fork)
+        for (auto &fds : consumer_fds)
+        {
+            for (int fd : fds)
+                close(fd);
+        }
+        // Producer tidak ditunggu (seperti bash); exit-nya di-reap oleh
+        // event loop lewat pidfd
+    }
+
+    void close_stage(size_t stage)
+    {
+        for (int fd : consumer_fds[stage])
+            close(fd);
+        consumer_fds[stage].clear();
+    }
+};
+
+// Teks satu stage untuk JobStage ("grep -v x")
+static std::string stage_command_string(const SimpleCommand &cmd)
+{
+    std::string command_str;
+    for (const auto &token : cmd.tokens)
+    {
+        if (!command_str.empty())
+            command_str += ' ';
+        command_str += token;
+    }
+    return command_str;
+}
+
+// Pipe satu job. Fan-out `producer |{ c1 ; c2 }` dan fan-in
+// `{ p1 & p2 } |merge consumer` membagi stage job menjadi segmen (producer,
+// cabang, consumer) yang dihubungkan relay (pipe_relay.h), bukan pipe
+// langsung; `a |buf 256M| b` menyisipkan relay buffer di satu sambungan,
+// NSH_PIPE_METER relay meter di setiap sambungan (pipe_meter.h).
+// Ujung milik relay dipegang shell sampai relay dimulai; child menutup yang
+// bukan miliknya, kalau tidak consumer tidak akan pernah melihat EOF.
+struct JobPipes
 {
-    if (cmd_group.pipeline.empty())
+    struct BufferEdge {
+        int read_fd;  // output stage penulis
+        int write_fd; // stdin stage berikutnya
+        size_t limit; // 0: hanya meter
+        std::shared_ptr<PipeMeter> meter;
+    };
+
+    const ParsedCommand &group;
+    size_t pipe_size = 0;            // NSH_PIPE_SIZE, 0: default kernel
+    bool pipe_size_failed = false;   // dilaporkan sekali per job
+    int fanout_read = -1;            // output producer fan-out, dibaca relay
+    int fanout_write = -1;           // stdout stage terakhir producer
+    std::vector<int> branch_read;    // stdin stage pertama setiap cabang
+    std::vector<int> branch_write;   // ditulis relay fan-out
+    std::vector<int> producer_read;  // dibaca relay merge
+    std::vector<int> producer_write; // stdout stage terakhir setiap producer
+    int merge_read = -1;             // stdin consumer merge
+    int merge_write = -1;            // ditulis relay merge
+    std::vector<BufferEdge> buffers; // `|buf SIZE|` dan meter, dibaca/ditulis relay
+    bool metered = false;            // NSH_PIPE_METER / `time --pipes`
+    PipeMeters meters;               // satu per sambungan, urut kiri ke kanan
+
+    JobPipes(const ParsedCommand &cmd_group, size_t size, bool meter)
+        : group(cmd_group), pipe_size(size), metered(meter) {}
+
+    ~JobPipes()
+    {
+        close_all();
+    }
+
+    // pipe2 O_CLOEXEC dengan kapasitas NSH_PIPE_SIZE. Gagal memperbesar
+    // (di atas /proc/sys/fs/pipe-max-size tanpa CAP_SYS_RESOURCE) tidak
+    // fatal: pipe tetap dipakai dengan ukuran default
+    bool make_pipe(int fds[2])
+    {
+        if (pipe2(fds, O_CLOEXEC) < 0)
+            return false;
+        if (pipe_size > 0 && fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(pipe_size)) < 0 && !pipe_size_failed)
+        {
+            std::cerr << "nsh: NSH_PIPE_SIZE: " << format_byte_size(pipe_size) << ": " << strerror(errno) << std::endl;
+            pipe_size_failed = true;
+        }
+        return true;
+    }
+
+    bool open()
+    {
+        int fds[2];
+        if (!group.fanout_branches.empty())
+        {
+            if (!make_pipe(fds))
+                return false;
+            fanout_read = fds[0];
+            fanout_write = fds[1];
+            for (size_t i = 0; i < group.fanout_branches.size(); ++i)
+            {
+                if (!make_pipe(fds))
+                    return false;
+                branch_read.push_back(fds[0]);
+                branch_write.push_back(fds[1]);
+            }
+        }
+        if (!group.merge_producers.empty())
+        {
+            if (!make_pipe(fds))
+                return false;
+            merge_read = fds[0];
+            merge_write = fds[1];
+            for (size_t i = 0; i < group.merge_producers.size(); ++i)
+            {
+                if (!make_pipe(fds))
+                    return false;
+                producer_read.push_back(fds[0]);
+                producer_write.push_back(fds[1]);
+            }
+        }
+        return true;
+    }
+
+    // Stage i adalah awal segmen selain yang pertama
+    bool starts_segment(size_t i) const
+    {
+        const auto &branches = group.fanout_branches;
+        const auto &producers = group.merge_producers;
+        if (std::find(branches.begin(), branches.end(), i) != branches.end())
+            return true;
+        if (producers.empty())
+            return false;
+        return i == group.merge_consumer || (i > 0 && std::find(producers.begin(), producers.end(), i) != producers.end());
+    }
+
+    // stdin dari relay untuk stage pertama cabang atau consumer merge;
+    // ujungnya diserahkan ke pemanggil. -1 jika stage membaca pipe biasa.
+    int take_input(size_t i)
+    {
+        const auto &branches = group.fanout_branches;
+        auto branch = std::find(branches.begin(), branches.end(), i);
+        if (branch != branches.end())
+            return take(branch_read[branch - branches.begin()]);
+        if (!group.merge_producers.empty() && i == group.merge_consumer)
+            return take(merge_read);
+        return -1;
+    }
+
+    // stdout ke relay untuk stage terakhir producer; -1 jika tidak ada
+    int output(size_t i) const
+    {
+        if (!group.fanout_branches.empty() && i + 1 == group.fanout_branches[0])
+            return fanout_write;
+        const auto &producers = group.merge_producers;
+        for (size_t k = 0; k < producers.size(); ++k)
+        {
+            size_t end = k + 1 < producers.size() ? producers[k + 1] : group.merge_consumer;
+            if (i + 1 == end)
+                return producer_write[k];
+        }
+        return -1;
+    }
+
+    // `a |buf SIZE| b` atau meter: read end output stage i diserahkan ke
+    // relay, stage berikutnya membaca dari pipe baru. Return stdin stage
+    // berikutnya.
+    int relay_edge(size_t i, int read_fd)
+    {
+        size_t limit = group.pipeline[i].pipe_buffer;
+        if (limit == 0 && !metered)
+            return read_fd;
+        int fds[2];
+        if (!make_pipe(fds))
+        {
+            perror(limit ? "nsh: buf: pipe" : "nsh: pipe meter: pipe"); // tetap jalan, tanpa relay
+            return read_fd;
+        }
+        std::shared_ptr<PipeMeter> meter;
+        if (metered)
+        {
+            meter = std::make_shared<PipeMeter>();
+            meter->producer = i;
+            meter->command = stage_command_string(group.pipeline[i]) +
+                             (limit ? " |buf " + format_byte_size(limit) + "| " : " | ") +
+                             stage_command_string(group.pipeline[i + 1]);
+            meters.push_back(meter);
+        }
+        buffers.push_back({read_fd, fds[1], limit, meter});
+        return fds[0];
+    }
+
+    // Setelah stage yang memakai output(i) di-fork
+    void output_forked(int fd)
+    {
+        if (fanout_write == fd)
+            close(take(fanout_write));
+        for (int &owned : producer_write)
+        {
+            if (owned == fd)
+                close(take(owned));
+        }
+    }
+
+    // Semua stage sudah di-fork: serahkan ujung sisanya ke relay
+    void start()
+    {
+        if (fanout_read >= 0)
+            relay_start_fanout(take(fanout_read), branch_write);
+        branch_write.clear();
+        if (merge_write >= 0)
+            relay_start_merge(producer_read, take(merge_write), group.merge_buffer, group.merge_tagged);
+        producer_read.clear();
+        for (const BufferEdge &edge : buffers)
+            relay_start_buffer(edge.read_fd, edge.write_fd, edge.limit, edge.meter);
+        buffers.clear();
+    }
+
+    static int take(int &fd)
+    {
+        int taken = fd;
+        fd = -1;
+        return taken;
+    }
+
+    void close_all()
+    {
+        for (int *fd : {&fanout_read, &fanout_write, &merge_read, &merge_write})
+        {
+            if (*fd >= 0)
+                close(*fd);
+            *fd = -1;
+        }
+        for (auto *fds : {&branch_read, &branch_write, &producer_read, &producer_write})
+        {
+            for (int fd : *fds)
+            {
+                if (fd >= 0)
+                    close(fd);
+            }
+            fds->clear();
+        }
+        for (const BufferEdge &edge : buffers)
+        {
+            close(edge.read_fd);
+            close(edge.write_fd);
+        }
+        buffers.clear();
+    }
+};
+
+// NSH_PIPE_SIZE: kapasitas pipe antar stage (F_SETPIPE_SZ), per shell atau
+// per command (`NSH_PIPE_SIZE=1M producer | consumer`); 0 jika tidak diset
+static size_t pipe_size_setting(const ParsedCommand &group)
+{
+    const char *value = nullptr;
+    if (!group.pipeline.empty())
+    {
+        auto it = group.pipeline[0].env_vars.find("NSH_PIPE_SIZE");
+        if (it != group.pipeline[0].env_vars.end())
+            value = it->second.c_str();
+    }
+    if (!value)
+        value = get_env_var("NSH_PIPE_SIZE");
+    if (!value || !*value)
         return 0;
 
+    unsigned long long bytes = 0;
+    if (!parse_byte_size(value, bytes) || bytes == 0 || bytes > static_cast<unsigned long long>(INT_MAX))
+    {
+        std::cerr << "nsh: NSH_PIPE_SIZE: " << value << ": invalid size" << std::endl;
+        return 0;
+    }
+    return static_cast<size_t>(bytes);
+}
+
+static bool has_process_substitution(const ParsedCommand &cmd_group)
+{
+    for (const auto &simple_cmd : cmd_group.pipeline)
+    {
+        if (!simple_cmd.process_substitutions.empty())
+            return true;
+        for (const auto &redir : simple_cmd.redirections)
+        {
+            if (redir.process_substitution)
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Jalankan producer untuk satu `<(cmd)` / `>(cmd)` dan kembalikan
+ *        path /dev/fd/N yang menggantikan token tersebut.
+ *
+ * Producer masuk ke process group job, jadi ikut terlihat di `jobs` dan
+ * ikut menerima Ctrl-C/Ctrl-Z bersama consumer-nya.
+ */
+static std::string start_process_substitution(const std::string &token, size_t stage,
+                                              ProcessSubstitutions &subs)
+{
+    bool producer_writes = (token[0] == '<');
+    std::string body = token.substr(2, token.size() - 3);
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) < 0)
+    {
+        perror("nsh: process substitution: pipe");
+        return "";
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("nsh: process substitution: fork");
+        close(fds[0]);
+        close(fds[1]);
+        return "";
+    }
+
+    if (pid == 0)
+    {
+        in_helper_child = true;
+        setpgid(0, subs.pgid);
+        for (int sig : {SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD, SIGPIPE})
+            signal(sig, SIG_DFL);
+
+        // Ujung pipe milik substitution lain tidak boleh ikut tertahan di sini
+        for (auto &other : subs.consumer_fds)
+        {
+            for (int fd : other)
+                close(fd);
+        }
+
+        if (producer_writes)
+            dup2(fds[1], STDOUT_FILENO);
+        else
+            dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+
+        int code = execute_subshell_direct(body);
+        std::cout.flush();
+        // _exit: exit() akan mengembalikan offset stdin (file script) milik
+        // shell ke posisi buffer child, sehingga shell membaca ulang baris
+        _exit(code);
+    }
+
+    if (subs.pgid == 0)
+        subs.pgid = pid;
+    setpgid(pid, subs.pgid);
+    subs.pids.push_back(pid);
+    event_loop_track_child(pid, subs.pgid, false);
+
+    int consumer_fd = producer_writes ? fds[0] : fds[1];
+    close(producer_writes ? fds[1] : fds[0]);
+    subs.consumer_fds[stage].push_back(consumer_fd);
+    return "/dev/fd/" + std::to_string(consumer_fd);
+}
+
+static bool start_process_substitutions(ParsedCommand &cmd_group, ProcessSubstitutions &subs)
+{
+    subs.consumer_fds.resize(cmd_group.pipeline.size());
+    for (size_t i = 0; i < cmd_group.pipeline.size(); ++i)
+    {
+        auto &simple_cmd = cmd_group.pipeline[i];
+        for (size_t index : simple_cmd.process_substitutions)
+        {
+            std::string &token = simple_cmd.tokens[index];
+            token = start_process_substitution(token, i, subs);
+            if (token.empty())
+                return false;
+        }
+        simple_cmd.process_substitutions.clear();
+        for (auto &redir : simple_cmd.redirections)
+        {
+            if (!redir.process_substitution)
+                continue;
+            redir.target_file = start_process_substitution(redir.target_file, i, subs);
+            redir.process_substitution = false;
+            if (redir.target_file.empty())
+                return false;
+        }
+    }
+    return true;
+}
+
+// Teks command job untuk job list ("cmd arg | cmd2 ", fan-out
+// "cmd |{ cmd2 ; cmd3 } ", merge "{ cmd & cmd2 } |merge cmd3 ", buffer
+// "cmd |buf 256M| cmd2 ")
+static std::string job_command_string(const ParsedCommand &group)
+{
+    const auto &branches = group.fanout_branches;
+    const auto &producers = group.merge_producers;
+    std::string command_str;
+    for (size_t i = 0; i < group.pipeline.size(); ++i)
+    {
+        if (!producers.empty() && i == 0)
+            command_str += "{ ";
+        else if (std::find(producers.begin(), producers.end(), i) != producers.end())
+            command_str += "& ";
+        else if (!producers.empty() && i == group.merge_consumer)
+            command_str += group.merge_tagged ? "} |merge -t " : "} |merge ";
+
+        if (!branches.empty() && i == branches[0])
+            command_str += "|{ ";
+        else if (std::find(branches.begin(), branches.end(), i) != branches.end())
+            command_str += "; ";
+        for (const auto &token : group.pipeline[i].tokens)
+             command_str += token + " ";
+        if (group.pipeline[i].pipe_buffer > 0)
+            command_str += "|buf " + format_byte_size(group.pipeline[i].pipe_buffer) + "| ";
+    }
+    if (!branches.empty())
+        command_str += "} ";
+    return command_str;
+}
+
+// Exit code gaya $? dari status waitpid satu stage
+static int stage_exit_code(int status)
+{
+    if (WIFSIGNALED(status))
+        return 128 + WTERMSIG(status);
+    if (WIFSTOPPED(status))
+        return 128 + WSTOPSIG(status);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+}
+
+// $PIPESTATUS: exit code setiap stage pipeline foreground terakhir, dipisah
+// spasi ("0 1 0") karena nsh belum punya array
+static void set_pipestatus(const std::vector<int> &codes)
+{
+    std::string value;
+    for (int code : codes)
+    {
+        if (!value.empty())
+            value += ' ';
+        value += std::to_string(code);
+    }
+    set_env_var("PIPESTATUS", value, 0);
+}
+
+// Builtin yang hanya menunggu (sleep, timeout, parallel, every): dengan `&`
+// di-fork seperti stage pipeline supaya shell tidak ikut menunggu
+static bool forks_in_background(const SimpleCommand &cmd)
+{
+    if (cmd.tokens.empty())
+        return false;
+    const std::string &name = cmd.tokens[0];
+    return name == "sleep" || name == "timeout" || name == "parallel" || name == "every";
+}
+
+int execute_job(const ParsedCommand &input_group, bool use_env, JobTiming *timing)
+{
+    if (input_group.pipeline.empty())
+        return 0;
+
+    // `limit -n 4096 -- cmd`: prefix dibuang, limit dipasang di child
+    // (launch_process) sebelum exec
+    ParsedCommand limited_group;
+    bool has_limits = limits_has_prefix(input_group);
+    if (has_limits)
+    {
+        limited_group = input_group;
+        for (auto &simple_cmd : limited_group.pipeline)
+        {
+            if (!simple_cmd.tokens.empty() && simple_cmd.tokens[0] == "limit" && !limits_strip_prefix(simple_cmd))
+                return 2;
+        }
+    }
+    const ParsedCommand &original_group = has_limits ? limited_group : input_group;
+
+    // Job background bisa diantrikan scheduler (NSH_MAX_BG_JOBS); builtin
+    // tunggal tetap dijalankan langsung di shell
+    bool single_builtin = original_group.pipeline.size() == 1 &&
+                          !original_group.pipeline[0].tokens.empty() &&
+                          is_builtin(original_group.pipeline[0].tokens[0]) &&
+                          !(original_group.background && forks_in_background(original_group.pipeline[0]));
+    if (original_group.background && !single_builtin &&
+        scheduler_enqueue_if_limited(original_group, use_env, job_command_string(original_group)))
+        return 0;
+
+    // <(cmd) dan >(cmd): producer dijalankan lebih dulu, token diganti
+    // /dev/fd/N. Data mengalir lewat pipe, tanpa file sementara.
+    ProcessSubstitutions subs;
+    ParsedCommand rewritten_group;
+    bool has_subs = has_process_substitution(original_group);
+    if (has_subs)
+    {
+        rewritten_group = original_group;
+        if (!start_process_substitutions(rewritten_group, subs))
+            return 1;
+    }
+    const ParsedCommand &cmd_group = has_subs ? rewritten_group : original_group;
+
+    redir_cache_prepare(cmd_group.pipeline);
+
     // Handle builtin commands in pipeline
-    if (cmd_group.pipeline.size() == 1 &&
-        !cmd_group.pipeline[0].tokens.empty() &&
-        is_builtin(cmd_group.pipeline[0].tokens[0]))
+    if (single_builtin)
     {
 
         const auto &simple_cmd = cmd_group.pipeline[0];
 
+        // `exec 3>>log`, `exec 3>&-`: tanpa command, redirection berlaku
+        // permanen di shell dan tidak di-restore
+        if (simple_cmd.tokens.size() == 1 && simple_cmd.tokens[0] == "exec" &&
+            !simple_cmd.redirections.empty())
+        {
+            for (const auto &redir : simple_cmd.redirections)
+                redir_cache_forget_fd(redir.source_fd);
+            return apply_redirections(simple_cmd, false) ? 0 : 1;
+        }
+
         // Save original file descriptors
-        int stdin_backup = dup(STDIN_FILENO);
-        int stdout_backup = dup(STDOUT_FILENO);
+        auto saved_fds = save_redirected_fds(simple_cmd);
 
         // Apply redirection for the builtin
-        handle_redirection(simple_cmd);
+        if (!apply_redirections(simple_cmd, false))
+        {
+            restore_redirected_fds(saved_fds);
+            return 1;
+        }
 
-        // Execute the builtin
+        // Execute the builtin (`time timeout ...`: child yang di-reap ikut dihitung)
+        if (timing)
+            timing_stage_start(timing->stages[0], 0, true);
         int code = execute_builtin(simple_cmd);
+        if (timing)
+            timing_stage_builtin_done(timing->stages[0], code);
 
         // Restore original file descriptors
-        dup2(stdin_backup, STDIN_FILENO);
-        dup2(stdout_backup, STDOUT_FILENO);
-        close(stdin_backup);
-        close(stdout_backup);
+        restore_redirected_fds(saved_fds);
 
+        set_pipestatus({code});
         return code;
     }
 
+    // Counter perf_event_open per proses job (lihat job_perf.h)
+    bool count_perf = (timing && timing->perf_requested) || perf_counters_requested(cmd_group);
+    struct rusage job_usage = {};
+
+    // Status dan rusage per stage: disimpan di Job (jobs -l) dan $PIPESTATUS
+    std::vector<JobStage> stages(cmd_group.pipeline.size());
+    for (size_t i = 0; i < stages.size(); ++i)
+        stages[i].command = stage_command_string(cmd_group.pipeline[i]);
+
     int in_fd = STDIN_FILENO, pipe_fd[2];
-    pid_t pgid = 0;
+    pid_t pgid = subs.pgid;
     std::vector<pid_t> pids;
+    std::vector<size_t> pid_stages; // index stage pipeline untuk setiap pids[i]
 
     // Salin pipeline agar bisa dimodifikasi dan simpan nama command asli
     std::vector<SimpleCommand> pipeline_with_paths = cmd_group.pipeline;
     std::vector<std::string> original_cmd_names;
 
     // Lakukan path resolution di parent untuk memberikan error yang lebih baik
+    auto resolve_failed = [&](int code) {
+        if (!cmd_group.background)
+            set_pipestatus({code});
+        return code;
+    };
     for (auto &simple_cmd : pipeline_with_paths)
     {
         if (simple_cmd.tokens.empty() || is_builtin(simple_cmd.tokens[0]))
@@ -1018,13 +1851,13 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
             if (stat(original_name.c_str(), &path_stat) != 0)
             {
                 std::cerr << "nsh: " << original_name << ": " << strerror(errno) << std::endl;
-                return (errno == ENOENT) ? 127 : 126;
+                return resolve_failed((errno == ENOENT) ? 127 : 126);
             }
 
             if (S_ISDIR(path_stat.st_mode))
             {
                 std::cerr << "nsh: " << original_name << ": Is a directory" << std::endl;
-                return 126;
+                return resolve_failed(126);
             }
 
             if (access(original_name.c_str(), X_OK) != 0)
@@ -1033,7 +1866,7 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
                     std::cerr << "nsh: " << original_name << ": Too many levels of symbolic links" << std::endl;
                 else
                     std::cerr << "nsh: " << original_name << ": Permission denied" << std::endl;
-                return 126;
+                return resolve_failed(126);
             }
             binary_path = fs::absolute(original_name).string();
         }
@@ -1045,26 +1878,79 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
             if (binary_path.empty())
             {
                 std::cerr << "nsh: " << original_name << ": command not found" << std::endl;
-                return 127;
+                return resolve_failed(127);
             }
         }
         simple_cmd.tokens[0] = binary_path;
         original_cmd_names.push_back(original_name);
     }
 
+    // Builtin di posisi tengah/awal pipeline foreground berjalan di thread
+    // yang menulis langsung ke pipe, builtin di posisi terakhir berjalan di
+    // shell itu sendiri. Sisanya tetap di-fork seperti biasa.
+    struct ThreadStage {
+        const SimpleCommand *cmd;
+        int in_fd;
+        int out_fd;
+        size_t index;
+    };
+    std::vector<ThreadStage> thread_stages;
+    bool run_last_in_shell = false;
+    int last_in_fd = STDIN_FILENO;
+
+    // NSH_BG_CAPTURE: output job background ke ring buffer (job_output.h)
+    int capture_fd = cmd_group.background ? output_capture_prepare(cmd_group) : -1;
+
+    // Fan-out dan merge: segmen job dihubungkan lewat relay; meter di
+    // setiap sambungan untuk NSH_PIPE_METER / `time --pipes`
+    bool meter_pipes = (timing && timing->pipes_requested) || pipe_meter_requested(cmd_group);
+    JobPipes relays(cmd_group, pipe_size_setting(cmd_group), meter_pipes);
+    if (!relays.open())
+    {
+        perror("nsh: pipe");
+        output_capture_abort();
+        return 1;
+    }
+
     for (size_t i = 0; i < pipeline_with_paths.size(); ++i)
     {
         const auto &simple_cmd = pipeline_with_paths[i];
         const std::string &original_name = original_cmd_names[i];
         bool is_last = (i == pipeline_with_paths.size() - 1);
+        bool stage_is_builtin = !simple_cmd.tokens.empty() && is_builtin(simple_cmd.tokens[0]);
+
+        // Stage terakhir producer, cabang fan-out atau producer merge tidak
+        // punya pipe ke stage berikutnya
+        int segment_in = relays.take_input(i);
+        if (segment_in >= 0)
+            in_fd = segment_in;
+        bool ends_segment = is_last || relays.starts_segment(i + 1);
+        int segment_out = relays.output(i);
+
+        if (is_last && stage_is_builtin && !cmd_group.background)
+        {
+            run_last_in_shell = true;
+            last_in_fd = in_fd;
+            in_fd = STDIN_FILENO;
+            break;
+        }
 
-        if (!is_last) {
-          if (pipe(pipe_fd) < 0) {
+        if (!ends_segment) {
+          // O_CLOEXEC: fd milik thread stage tidak boleh bocor ke proses
+          // yang di-exec, kalau tidak reader tidak akan pernah melihat EOF
+          if (!relays.make_pipe(pipe_fd)) {
             // Cleanup resources sebelum return
             if (in_fd != STDIN_FILENO) close(in_fd);
               for (pid_t existing_pid : pids) {
               kill(existing_pid, SIGKILL);  // Cleanup any already forked processes
               }
+              if (pgid != 0)
+                event_loop_release_group(pgid); // di-reap event loop
+              output_capture_abort();
+              for (const auto &stage : thread_stages) {
+                if (stage.in_fd != STDIN_FILENO) close(stage.in_fd);
+                close(stage.out_fd);
+              }
         
             switch (errno) {
               case EPIPE:
@@ -1089,36 +1975,94 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
           }
         }
 
+        if (!ends_segment && !cmd_group.background && is_thread_safe_builtin(simple_cmd))
+        {
+            thread_stages.push_back({&simple_cmd, in_fd, pipe_fd[1], i});
+            in_fd = relays.relay_edge(i, pipe_fd[0]);
+            continue;
+        }
+
+        if (count_perf)
+            perf_before_fork();
         pid_t pid = fork();
         if (pid < 0)
         {
+            if (count_perf)
+                perf_fork_failed();
             if (errno == EAGAIN)
                 std::cerr << "nsh: fork: Resource temporarily unavailable" << std::endl;
             else if (errno == ENOMEM)
                 std::cerr << "nsh: fork: Cannot allocate memory" << std::endl;
             else
                 perror("nsh: fork");
+            if (pgid != 0)
+                event_loop_release_group(pgid);
+            output_capture_abort();
             return 1;
         }
 
         if (pid == 0)
         {
+            // /dev/fd/N milik stage ini harus tetap terbuka setelah exec
+            if (has_subs)
+            {
+                for (int fd : subs.consumer_fds[i])
+                    fcntl(fd, F_SETFD, 0);
+            }
             if (in_fd != STDIN_FILENO)
             {
                 dup2(in_fd, STDIN_FILENO);
                 close(in_fd);
             }
-            if (!is_last)
+            if (!ends_segment)
             {
                 close(pipe_fd[0]);
                 dup2(pipe_fd[1], STDOUT_FILENO);
                 close(pipe_fd[1]);
             }
+            else if (segment_out >= 0)
+            {
+                dup2(segment_out, STDOUT_FILENO);
+            }
+            relays.close_all();
+            // Pipe milik thread stage: O_CLOEXEC tidak cukup untuk builtin
+            // yang di-fork tanpa exec (timeout, parallel), writer yang
+            // tertinggal membuat reader tidak pernah melihat EOF
+            for (const auto &stage : thread_stages)
+            {
+                if (stage.in_fd != STDIN_FILENO)
+                    close(stage.in_fd);
+                close(stage.out_fd);
+            }
+            if (capture_fd >= 0)
+            {
+                // Redirection milik command tetap menang (diterapkan setelah ini)
+                if (ends_segment && segment_out < 0)
+                    dup2(capture_fd, STDOUT_FILENO);
+                dup2(capture_fd, STDERR_FILENO);
+                close(capture_fd);
+            }
 
             if (!simple_cmd.tokens.empty() && is_builtin(simple_cmd.tokens[0]))
             {
+                // `sleep 5 &` atau builtin di pipeline: _exit, lihat
+                // start_process_substitution (exit_shell juga menutup
+                // session milik shell)
+                if (cmd_group.background)
+                {
+                    // Bukan shell lagi: `kill %N` tidak boleh menjalankan
+                    // handler SIGTERM/SIGHUP shell, dan job yang di-fork
+                    // builtin (timeout, parallel) tetap di group ini dan
+                    // tidak mengambil terminal
+                    in_helper_child = true;
+                    for (int sig : {SIGINT, SIGQUIT, SIGTERM, SIGHUP, SIGTSTP, SIGTTIN, SIGTTOU, SIGPIPE})
+                        signal(sig, SIG_DFL);
+                    placement_apply(simple_cmd);
+                }
+                perf_child_ready();
                 int exit_code = execute_builtin(simple_cmd);
-                exit_shell(exit_code);
+                std::cout.flush();
+                _exit(exit_code);
             }
             else
             {
@@ -1128,15 +2072,30 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
         else
         {
             pids.push_back(pid);
+            pid_stages.push_back(i);
+            stages[i].pid = pid;
+            if (timing)
+                timing_stage_start(timing->stages[i], pid);
             if (pgid == 0)
                 pgid = pid;
-            setpgid(pid, pgid);
+            if (count_perf)
+                perf_attach(pid, pgid);
+            if (!in_helper_child)
+                setpgid(pid, pgid);
+            event_loop_track_child(pid, pgid, !cmd_group.background);
+            if (has_subs)
+                subs.close_stage(i);
             if (in_fd != STDIN_FILENO)
+            {
                 close(in_fd);
-            if (!is_last)
+                in_fd = STDIN_FILENO;
+            }
+            if (segment_out >= 0)
+                relays.output_forked(segment_out);
+            if (!ends_segment)
             {
                 close(pipe_fd[1]);
-                in_fd = pipe_fd[0];
+                in_fd = relays.relay_edge(i, pipe_fd[0]);
             }
         }
     }
@@ -1144,13 +2103,55 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
     if (in_fd != STDIN_FILENO)
         close(in_fd);
 
-    // MODIFIKASI: Track job untuk SEMUA jenis proses (background dan foreground)
-    std::string command_str;
-    for (const auto &sc : cmd_group.pipeline)
+    // Relay memegang ujung fan-out/merge/buf sejak semua stage di-fork
+    relays.start();
+
+    // Thread baru dijalankan setelah semua fork selesai, supaya tidak ada
+    // fork() yang terjadi saat thread lain sedang memegang lock.
+    std::vector<std::thread> builtin_threads;
+    std::vector<std::future<void>> builtins_done; // execute_builtin sudah kembali
+    for (const auto &stage : thread_stages)
     {
-        for (const auto &token : sc.tokens)
-             command_str += token + " ";
+        StageTiming *stage_timing = timing ? &timing->stages[stage.index] : nullptr;
+        JobStage *stage_record = &stages[stage.index];
+        std::promise<void> done;
+        builtins_done.push_back(done.get_future());
+        builtin_threads.emplace_back([stage, stage_timing, stage_record, done = std::move(done)]() mutable {
+            sigset_t all;
+            sigfillset(&all);
+            pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+            // Builtin tidak membaca stdin; tutup segera agar writer di hulu
+            // mendapat EPIPE seperti pada subshell biasa
+            if (stage.in_fd != STDIN_FILENO)
+                close(stage.in_fd);
+
+            // Output langsung ke pipe. Selama builtin memegang lock state
+            // shell, pipe yang penuh tidak ditunggu (sisanya ditahan FdOutBuf)
+            // supaya builtin di shell (`history | read x`, `fg` setelah
+            // Ctrl-Z) tidak ikut tertahan; sisa itu ditulis setelah lock lepas
+            FdOutBuf out(stage.out_fd, true);
+            std::ostream out_stream(&out);
+            if (stage_timing)
+                timing_stage_start(*stage_timing, 0);
+            int code;
+            {
+                BuiltinOutputScope scope(out_stream);
+                code = execute_builtin(*stage.cmd);
+            }
+            if (stage_timing)
+                timing_stage_builtin_done(*stage_timing, code);
+            stage_record->finished = true;
+            stage_record->status = W_EXITCODE(code, 0);
+            // Setelah ini thread tidak menyentuh state job/timing lagi
+            done.set_value();
+            out.drain();
+            close(stage.out_fd);
+        });
     }
+
+    // MODIFIKASI: Track job untuk SEMUA jenis proses (background dan foreground)
+    std::string command_str = job_command_string(cmd_group);
     
     bool should_track_job = cmd_group.background;
     
@@ -1160,8 +2161,16 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
     
     int job_id = 0;
     if (should_track_job) {
-        job_id = add_job_to_list(pgid, command_str, JobStatus::RUNNING, true);
-        std::cout << "[" << job_id << "] " << pgid << std::endl;
+        // Job dari antrian scheduler memakai id yang dipesan saat diantrikan
+        int reserved_id = scheduler_launching_job_id();
+        job_id = add_job_to_list(pgid, command_str, JobStatus::RUNNING, true, reserved_id);
+        // Exit stage dicatat event loop lewat job_stage_exited()
+        find_job_by_pgid(pgid)->stages = std::move(stages);
+        find_job_by_pgid(pgid)->pipe_meters = relays.meters;
+        output_capture_attach(pgid);
+        scheduler_job_started(pgid, cmd_group);
+        if (reserved_id == 0)
+            std::cout << "[" << job_id << "] " << pgid << std::endl;
     }
     
     if (cmd_group.background) {
@@ -1171,31 +2180,113 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
         foreground_pgid = pgid;
         
         // Foreground job processing - TANPA job tracking untuk job sederhana
-        if (isatty(STDIN_FILENO)) {
+        // (pgid 0 berarti semua stage adalah builtin, tidak ada yang di-fork)
+        if (pgid != 0 && !in_helper_child && isatty(STDIN_FILENO)) {
             tcsetpgrp(STDIN_FILENO, pgid);
         }
 
+        int builtin_code = 0;
+        if (run_last_in_shell) {
+            const auto &last_cmd = pipeline_with_paths.back();
+
+            auto saved_fds = save_redirected_fds(last_cmd);
+            if (last_in_fd != STDIN_FILENO) {
+                dup2(last_in_fd, STDIN_FILENO);
+                close(last_in_fd);
+            }
+
+            StageTiming *stage_timing = timing ? &timing->stages.back() : nullptr;
+            if (stage_timing)
+                timing_stage_start(*stage_timing, 0);
+            if (apply_redirections(last_cmd, false))
+                builtin_code = execute_builtin(last_cmd);
+            else
+                builtin_code = 1;
+            if (stage_timing)
+                timing_stage_builtin_done(*stage_timing, builtin_code);
+            stages.back().finished = true;
+            stages.back().status = W_EXITCODE(builtin_code, 0);
+            std::cout.flush();
+
+            // Restore juga menutup read end pipe, writer di hulu dapat EPIPE
+            restore_redirected_fds(saved_fds);
+        }
+
         int status = 0;
+        bool stopped = false;
         for (size_t i = 0; i < pids.size(); ++i) {
-            int current_status;
-            waitpid(pids[i], &current_status, WUNTRACED);
+            struct rusage usage = {};
+            struct timespec exited_at = {};
+            int current_status = event_loop_wait_child(pids[i], &usage, &exited_at);
+            if (timing)
+                timing_stage_process_done(timing->stages[pid_stages[i]], current_status, usage, exited_at);
+            JobStage &stage = stages[pid_stages[i]];
+            stage.status = current_status;
+            if (WIFSTOPPED(current_status)) {
+                stopped = true;
+            } else {
+                stage.finished = true;
+                stage.usage = usage;
+                add_rusage(job_usage, usage);
+            }
             if (i == pids.size() - 1)
                 status = current_status;
         }
+
+        // Job yang di-stop (`history | less`, Ctrl-Z): thread yang masih
+        // menunggu reader dilepas dan selesai sendiri saat job dilanjutkan
+        // atau reader-nya mati, shell tidak ikut menunggu
+        for (auto &done : builtins_done)
+            done.wait();
+        for (auto &t : builtin_threads) {
+            if (stopped)
+                t.detach();
+            else
+                t.join();
+        }
+
+        std::vector<int> stage_codes;
+        for (const JobStage &stage : stages)
+            stage_codes.push_back(stage_exit_code(stage.status));
+        set_pipestatus(stage_codes);
         
         // HANYA jika job di-stop, baru kita track sebagai job
-        if (WIFSTOPPED(status)) {
+        if (stopped) {
             job_id = add_job_to_list(pgid, command_str, JobStatus::STOPPED, true);
+            // Stage yang sudah exit sebelum Ctrl-Z tetap tercatat di job,
+            // sisanya diisi job_stage_exited() saat exit
+            Job *job = find_job_by_pgid(pgid);
+            job->stages = std::move(stages);
+            job->usage = job_usage;
+            job->pipe_meters = relays.meters; // dilaporkan bersama "Done"
+            // Event berikutnya dari group ini diteruskan ke job list
+            event_loop_release_group(pgid);
             std::cout << "\n[" << job_id << "]+ Stopped\t" << command_str << std::endl;
         }
+        else if (count_perf && pgid != 0) {
+            PerfTotals totals = perf_finish(pgid, job_usage);
+            if (timing)
+                timing->perf = totals;
+            else
+                std::cerr << perf_format(totals) << std::endl;
+        }
+        if (!stopped && !relays.meters.empty()) {
+            pipe_meter_settle(relays.meters);
+            if (timing)
+                timing->pipes = relays.meters;
+            else
+                std::cerr << pipe_meter_format(relays.meters);
+        }
         
-        if (isatty(STDIN_FILENO)) {
+        if (pgid != 0 && !in_helper_child && isatty(STDIN_FILENO)) {
             tcsetpgrp(STDIN_FILENO, shell_pgid);
         }
         
         // reset! shit
         foreground_pgid = 0;
         
+        if (run_last_in_shell)
+            return builtin_code;
         if (WIFEXITED(status))
             return WEXITSTATUS(status);
         if (WIFSIGNALED(status))
@@ -1205,7 +2296,40 @@ int execute_job(const ParsedCommand &cmd_group, bool use_env)
 }
 
 
-int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_env) 
+void erase_leading_tokens(SimpleCommand &cmd, size_t count)
+{
+    cmd.tokens.erase(cmd.tokens.begin(), cmd.tokens.begin() + count);
+    std::set<size_t> shifted;
+    for (size_t index : cmd.process_substitutions)
+    {
+        if (index >= count)
+            shifted.insert(index - count);
+    }
+    cmd.process_substitutions = shifted;
+}
+
+void expand_command_group(ParsedCommand &group)
+{
+    for (auto &simple_cmd : group.pipeline)
+    {
+      // Body coproc di-expand oleh subshell coproc itu sendiri
+      if (simple_cmd.tokens.empty() || simple_cmd.tokens[0] != "coproc")
+        apply_expansions_and_wildcards(simple_cmd.tokens, &simple_cmd.process_substitutions);
+
+      // Target redirection juga di-expand (`> $LOG`, `>&$COPROC_1`)
+      for (auto &redir : simple_cmd.redirections)
+      {
+        if (redir.target_file.empty() || redir.process_substitution)
+          continue;
+        redir.target_file = expand_argument(expand_tilde(redir.target_file));
+        if ((redir.type == RedirectionType::DUPLICATE_OUT || redir.type == RedirectionType::DUPLICATE_IN) &&
+            redir.target_fd < 0)
+          parse_fd_number(redir.target_file, redir.target_fd);
+      }
+    }
+}
+
+int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_env, bool expanded) 
 {
     validate_and_cleanup_jobs();
     if (commands.empty())
@@ -1252,8 +2376,8 @@ int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_en
                 continue;
         }
         
-        for (auto &simple_cmd : expanded_cmd.pipeline)
-          apply_expansions_and_wildcards(simple_cmd.tokens);
+        if (!expanded)
+            expand_command_group(expanded_cmd);
         
         if (cmd_group.pipeline.empty())
             continue;
@@ -1265,7 +2389,10 @@ int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_en
             continue;
         }
         
-        current_exit_code = execute_job(expanded_cmd, use_env);
+        if (is_timed_job(expanded_cmd))
+            current_exit_code = execute_timed_job(expanded_cmd, use_env);
+        else
+            current_exit_code = execute_job(expanded_cmd, use_env);
         last_exit_code = current_exit_code;
         
         // Check for interrupt after executing each command
@@ -786,12 +786,40 @@ std::string expand_argument(const std::string &token)
 
 // ... (kode setelahnya tetap sama) ...
 
-void apply_expansions_and_wildcards(std::vector<std::string> &tokens)
+// `*'/`?' dari kutipan ('a*', "a?") adalah teks biasa; wildcard hanya dari
+// teks tanpa kutip atau dari hasil expansion tanpa kutip ($VAR, $(cmd))
+static bool may_glob(const std::string &token)
+{
+    char quote = 0;
+    for (size_t i = 0; i < token.size(); ++i)
+    {
+        char c = token[i];
+        if (c == '\\' && quote != '\'')
+        {
+            i++;
+            continue;
+        }
+        if (quote)
+        {
+            if (c == quote)
+                quote = 0;
+            continue;
+        }
+        if (c == '\'' || c == '"')
+            quote = c;
+        else if (c == '*' || c == '?' || c == '$' || c == '`')
+            return true;
+    }
+    return false;
+}
+
+void apply_expansions_and_wildcards(std::vector<std::string> &tokens, std::set<size_t> *verbatim)
 {
     if (tokens.empty())
         return;
     
     std::vector<std::string> new_tokens;
+    std::set<size_t> new_verbatim;
     
     for (size_t i = 0; i < tokens.size(); ++i)
     {
@@ -808,10 +836,18 @@ void apply_expansions_and_wildcards(std::vector<std::string> &tokens)
             continue;
         }
 
+        // <(cmd) / >(cmd) dijalankan apa adanya oleh execute_job
+        if (verbatim && verbatim->count(i))
+        {
+            new_verbatim.insert(new_tokens.size());
+            new_tokens.push_back(token);
+            continue;
+        }
+
         std::string expanded_arg = expand_argument(expand_tilde(token));
 
         if (expanded_arg.find_first_of("*?") != std::string::npos && 
-            !is_env_assignment(expanded_arg))
+            !is_env_assignment(expanded_arg) && may_glob(token))
         {
             std::vector<std::string> expanded_wildcard = expand_wildcard(expanded_arg);
             new_tokens.insert(new_tokens.end(), expanded_wildcard.begin(), expanded_wildcard.end());
@@ -823,6 +859,8 @@ void apply_expansions_and_wildcards(std::vector<std::string> &tokens)
     }
     
     tokens = new_tokens;
+    if (verbatim)
+        *verbatim = new_verbatim;
 }
 
 bool is_env_assignment(const std::string &token)
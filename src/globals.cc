@@ -39,9 +39,10 @@ std::map<std::string, std::string> aliases;
 std::vector<std::string> command_history;
 size_t history_index = 0;
 int last_exit_code = 0;
-char **environ = nullptr;
+// environ is provided by libc (declared in unistd.h / globals.h)
 volatile sig_atomic_t received_sigint = 0;
 volatile int dont_execute_first = 0; // dont execute command if == 1;
+bool in_helper_child = false; // child helper (process substitution, ...): tanpa job control sendiri
 std::unordered_map<std::string, binary_hash_info> binary_hash_loc;
 // globals.cc - Tambahkan definisi
 fs::path ns_SESSION_FILE;
@@ -156,7 +157,7 @@ bool is_job_active(int job_id) {
     // Check if process group still exists
     if (kill(-it->second.pgid, 0) == -1 && errno == ESRCH) {
         // Process group doesn't exist, remove the job
-        jobs.erase(it);
+        remove_job(job_id);
         return false;
     }
     
@@ -16,6 +16,7 @@
 
 // Project headers
 #include "builtins.h"
+#include "builtin_io.h"
 #include "command.h"
 #include "execution.h"
 #include "expansion.h"
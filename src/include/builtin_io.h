@@ -0,0 +1,81 @@
+#ifndef BUILTIN_IO_H
+#define BUILTIN_IO_H
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Stream buffer that writes straight into a file descriptor instead of
+// going through the global std::cout. Output is kept in a large buffer
+// and written when it fills up or when the builtin finishes; only a TTY
+// gets line-by-line flushing.
+//
+// With never_block the fd is switched to O_NONBLOCK: whatever does not fit
+// into a full pipe is kept aside instead of waiting for the reader, and
+// drain() writes it out (blocking) later. Pipeline builtins on a thread use
+// this so they never wait on the pipe while holding builtin_state_mutex.
+class FdOutBuf : public std::streambuf {
+public:
+    explicit FdOutBuf(int fd, bool never_block = false);
+    ~FdOutBuf() override;
+
+    int fd() const { return out_fd; }
+
+    // Write everything still pending, waiting for the reader if needed.
+    // Returns false when the reader went away.
+    bool drain();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    bool flush_buffer();
+    bool write_some(const char *&data, size_t &len); // never_block: stops at EAGAIN
+    bool write_pending();
+
+    int out_fd;
+    bool line_buffered; // fd adalah TTY: flush di setiap newline
+    bool never_block;
+    bool broken = false; // reader went away (EPIPE) or fatal write error
+    std::vector<char> buffer;
+    std::string pending; // never_block: data yang belum muat di pipe
+};
+
+/**
+ * @brief Binds builtin_out() of the calling thread to a file descriptor
+ *        (or to an existing stream, e.g. an std::ostringstream capture).
+ *
+ * Output is flushed and the previous binding restored when the scope ends.
+ */
+class BuiltinOutputScope {
+public:
+    explicit BuiltinOutputScope(int fd);
+    explicit BuiltinOutputScope(std::ostream &target);
+    ~BuiltinOutputScope();
+
+    BuiltinOutputScope(const BuiltinOutputScope &) = delete;
+    BuiltinOutputScope &operator=(const BuiltinOutputScope &) = delete;
+
+private:
+    std::unique_ptr<FdOutBuf> buf;
+    std::unique_ptr<std::ostream> owned_stream;
+    std::ostream *stream;
+    std::ostream *previous;
+};
+
+// Output stream for the builtin running on the calling thread.
+// Falls back to std::cout when no BuiltinOutputScope is active.
+std::ostream &builtin_out();
+
+// True when a BuiltinOutputScope is active on the calling thread.
+bool builtin_out_bound();
+
+// Writes the whole buffer to fd, retrying on EINTR and short writes.
+// Returns false when the reader went away (EPIPE) or on any other error.
+bool write_all(int fd, const char *data, size_t len);
+
+#endif // BUILTIN_IO_H
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <sys/types.h>
 
 void handle_builtin_hash(const std::vector<std::string> &tokens);
 void handle_builtin_cd(const std::vector<std::string> &t);
@@ -18,5 +19,16 @@ void handle_builtin_jobs(const std::vector<std::string>& tokens);
 void handle_builtin_kill(const std::vector<std::string> &tokens);
 void handle_builtin_bg(const std::vector<std::string> &tokens);
 void handle_builtin_fg(const std::vector<std::string> &tokens);
+void handle_builtin_coproc(const std::vector<std::string> &tokens);
+void handle_builtin_read(const std::vector<std::string> &tokens);
+void handle_builtin_wait(const std::vector<std::string> &tokens);
+void handle_builtin_parallel(const std::vector<std::string> &tokens);
+void handle_builtin_sleep(const std::vector<std::string> &tokens);
+void handle_builtin_timeout(const std::vector<std::string> &tokens);
+void handle_builtin_every(const std::vector<std::string> &tokens);
+void handle_builtin_ulimit(const std::vector<std::string> &tokens);
+
+// Job coproc selesai: tutup fd-nya di shell dan unset NAME_0/NAME_1/NAME_PID
+void coproc_job_finished(pid_t pgid);
 
 #endif // BUILTINS_H
@@ -5,6 +5,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <sys/resource.h>
 
 // Definisikan tipe-tipe redirection yang mungkin
 enum class RedirectionType {
@@ -29,12 +30,22 @@ struct Redirection {
     std::string delimiter;    // Untuk here-doc
     std::string content;      // Untuk here-string
     int target_fd = -1;       // FD target untuk duplikasi
+    bool process_substitution = false; // target_file adalah `<(cmd)` / `>(cmd)`
+};
+
+// Batas resource dari builtin `limit`, dipasang di child sebelum exec
+struct ResourceLimit {
+    int resource;   // RLIMIT_*
+    rlim_t value;   // soft dan hard, RLIM_INFINITY untuk unlimited
 };
 
 // Struktur untuk menyimpan satu perintah sederhana (misalnya, `ls -l`)
 struct SimpleCommand
 {
     std::vector<std::string> tokens;
+    // Index token `<(cmd)` / `>(cmd)` yang ditandai tokenizer; teks serupa
+    // dari kutipan atau hasil expansion tetap argumen biasa
+    std::set<size_t> process_substitutions;
     std::string stdin_file;
     std::string stdout_file;
     bool append_stdout = false;
@@ -43,6 +54,8 @@ struct SimpleCommand
     std::map<std::string, std::string> env_vars;
     std::set<std::string> exported_vars;
     std::vector<Redirection> redirections;
+    std::vector<ResourceLimit> limits;
+    size_t pipe_buffer = 0; // `|buf SIZE|` ke stage berikutnya, 0: pipe biasa
 };
 
 // Struktur untuk menyimpan satu baris perintah lengkap, yang bisa berupa pipeline
@@ -59,6 +72,19 @@ struct ParsedCommand
     };
     Operator next_operator = Operator::NONE;
     bool background = false;
+    // Diawali keyword `time` (kata tanpa kutip, ditandai parser); token
+    // "time" dan opsinya tetap di stage pertama untuk execute_timed_job
+    bool timed = false;
+    // Fan-out `producer |{ c1 ; c2 }`: stage cabang consumer disimpan di
+    // pipeline setelah stage producer, ini index stage pertama tiap cabang
+    std::vector<size_t> fanout_branches;
+    // Fan-in `{ p1 & p2 } |merge consumer`: index stage pertama setiap
+    // producer, consumer mulai di merge_consumer. Baris utuh diteruskan
+    // relay, opsional diberi tag "[N] " (-t); merge_buffer 0: default.
+    std::vector<size_t> merge_producers;
+    size_t merge_consumer = 0;
+    bool merge_tagged = false;
+    size_t merge_buffer = 0;
 };
 
 #endif // COMMAND_H
@@ -0,0 +1,72 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <vector>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Event loop tunggal shell berbasis epoll. SIGCHLD diblok dan dibaca lewat
+// signalfd, exit setiap child dibaca lewat pidfd, jadi reaping dan update
+// job list selalu terjadi di thread utama, tidak pernah di signal handler.
+// Readline (event_loop_getc) dan execute_job menunggu di loop yang sama.
+
+// Blok SIGCHLD dan buat epoll + signalfd. Dipanggil dari setup_signals();
+// child hasil fork otomatis membuat loop baru saat pertama dipakai.
+void event_loop_init();
+
+// Kembalikan signal mask awal sebelum execve() (SIGCHLD tidak boleh
+// tetap terblok di program yang dijalankan).
+void event_loop_prepare_exec();
+
+// Fd tambahan di loop; callback menerima event epoll.
+bool event_loop_add_fd(int fd, uint32_t events, std::function<void(uint32_t)> callback);
+void event_loop_remove_fd(int fd);
+
+// Jalankan callback untuk event yang siap, tunggu paling lama timeout_ms
+// (-1: tanpa batas). Return jumlah event, -1 jika epoll_wait gagal (EINTR).
+int event_loop_run_once(int timeout_ms);
+
+// Catat child hasil fork. Status child foreground disimpan untuk
+// event_loop_wait_child()/event_loop_wait_group(); status child background
+// langsung diteruskan ke job list lewat job_process_changed().
+void event_loop_track_child(pid_t pid, pid_t pgid, bool foreground);
+
+// Tunggu sampai child foreground exit atau stop. Return status gaya waitpid;
+// rusage dan waktu exit (CLOCK_MONOTONIC) child opsional.
+int event_loop_wait_child(pid_t pid, struct rusage *usage = nullptr, struct timespec *exited_at = nullptr);
+
+// Tanpa menunggu: true jika child foreground sudah exit (status gaya
+// waitpid di *status, record dilepas). Untuk builtin yang mengelola banyak
+// child sekaligus dari event_loop_run_once (parallel).
+bool event_loop_child_exited(pid_t pid, int *status, struct rusage *usage = nullptr);
+
+// Jadikan seluruh process group foreground (fg) atau kembalikan ke
+// background (job yang di-stop masuk job list).
+void event_loop_claim_group(pid_t pgid);
+void event_loop_release_group(pid_t pgid);
+
+// Tunggu sampai salah satu proses di group stop, atau semuanya selesai.
+// Return status stage terakhir (exit) atau status stop.
+int event_loop_wait_group(pid_t pgid);
+
+// Apakah loop masih punya proses hidup untuk group ini
+bool event_loop_has_group(pid_t pgid);
+
+// Process group dari child yang dicatat loop, 0 jika tidak dikenal
+pid_t event_loop_group_of(pid_t pid);
+
+// Child group ini yang dicatat loop dan belum exit
+std::vector<pid_t> event_loop_group_pids(pid_t pgid);
+
+// Tambahkan rusage satu proses ke total job: waktu dan counter dijumlah,
+// max RSS diambil yang terbesar (proses pipeline berjalan bersamaan)
+void add_rusage(struct rusage &total, const struct rusage &usage);
+
+// rl_getc_function: readline menunggu input sambil melayani event child
+int event_loop_getc(FILE *stream);
+
+#endif // EVENTS_H
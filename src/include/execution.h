@@ -5,19 +5,52 @@
 #include "globals.h"
 #include <string>
 #include <vector>
+#include <mutex>
+#include <functional>
 
 // Tell the compiler that this global variable is defined in another file.
 extern std::vector<std::pair<int, Job>> finished_jobs;
+// Lock untuk state shell yang dipakai builtin (lihat execute_builtin)
+extern std::recursive_mutex builtin_state_mutex;
 std::vector<char*> build_envp(); // important for global child environment 
 bool is_builtin(const std::string &command);
+bool is_thread_safe_builtin(const SimpleCommand &cmd);
 int execute_builtin(const SimpleCommand &cmd);
+bool apply_redirections(const SimpleCommand &cmd, bool fatal);
+void handle_redirection(const SimpleCommand &cmd);
 std::string find_binary(const std::string &cmd);
-int execute_job(const ParsedCommand &cmd_group, bool use_env);
-int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_env = true);
+struct JobTiming;
+// timing: diisi per stage untuk keyword `time` (lihat job_timing.h)
+int execute_job(const ParsedCommand &cmd_group, bool use_env, JobTiming *timing = nullptr);
+// Child: exec cmd (tokens[0] sudah path absolut), builtin dijalankan lalu exit
+void launch_process(pid_t pgid, const SimpleCommand &cmd, bool foreground, const std::string &original_cmd_name = "", bool use_env = true);
+// Expansion variabel, substitution dan wildcard untuk token dan target
+// redirection setiap stage (dilakukan execute_command_list per group)
+void expand_command_group(ParsedCommand &group);
+// Buang COUNT token pertama (prefix `time`/`limit`) beserta geser index
+// process substitution-nya
+void erase_leading_tokens(SimpleCommand &cmd, size_t count);
+// expanded: command sudah di-expand oleh pemanggil (run parallel/every)
+int execute_command_list(const std::vector<ParsedCommand> &commands, bool use_env = true, bool expanded = false);
+int execute_subshell_direct(const std::string& command);
 void check_child_status();
-void write_job_controle_file(const Job& job);
+void job_process_changed(pid_t pgid, int status, const struct rusage &usage, bool group_done);
+void job_stage_exited(pid_t pgid, pid_t pid, int status, const struct rusage &usage);
 void validate_and_cleanup_jobs();
-int add_job_to_list(pid_t pgid, const std::string& command, JobStatus status, bool update_current = true);
+// Job list: lookup O(1) lewat pgid, hanya job yang ditandai dirty yang
+// dipublikasikan ke registry (lihat flush_job_updates)
+Job *find_job_by_pgid(pid_t pgid, int *job_id = nullptr);
+void mark_job_dirty(pid_t pgid);
+void remove_job(int job_id);
+void flush_job_updates();
+void cleanup_orphan_jobs(bool force);
+// reserved_id: job id yang sudah dipesan saat job masuk antrian scheduler
+int add_job_to_list(pid_t pgid, const std::string& command, JobStatus status, bool update_current = true, int reserved_id = 0);
+// Builtin wait: hook dipanggil event loop setiap job background selesai atau
+// stop (exit code gaya $?); exit code job yang sudah selesai disimpan per pgid
+void set_job_wait_hook(std::function<void(pid_t pgid, int exit_code)> hook);
+bool finished_job_exit_code(pid_t pgid, int *exit_code);
+pid_t finished_job_pgid(int job_id);
 
 std::string find_binary(const std::string &cmd);
 
@@ -1,6 +1,7 @@
 #ifndef EXPANSION_H
 #define EXPANSION_H
 
+#include <set>
 #include <string>
 #include <vector>
 #include <utility>
@@ -10,6 +11,8 @@ std::pair<std::string, std::string> parse_env_assignment(const std::string &toke
 std::string expand_tilde(const std::string &path);
 std::string expand_argument(const std::string &token);
 std::string execute_subshell_command(const std::string &cmd);
-void apply_expansions_and_wildcards(std::vector<std::string> &tokens);
+// Token dengan index di VERBATIM (<(cmd)/>(cmd) dari tokenizer) tidak
+// di-expand; index-nya disesuaikan dengan posisi baru setelah expansion
+void apply_expansions_and_wildcards(std::vector<std::string> &tokens, std::set<size_t> *verbatim = nullptr);
 
 #endif // EXPANSION_H
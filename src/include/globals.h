@@ -2,6 +2,7 @@
 #define GLOBALS_H
 
 #include "platform.h"
+#include "pipe_meter.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -58,6 +59,7 @@ extern int last_exit_code;
 extern char **environ;
 extern volatile sig_atomic_t received_sigint;
 extern volatile int dont_execute_first;
+extern bool in_helper_child;
 struct binary_hash_info {
     std::string path;
     std::string command_name;
@@ -87,10 +89,21 @@ enum class JobStatus {
     DONE,           // Job selesai dengan kode keluar 0
     EXITED,         // Job selesai dengan kode keluar non-0
     SIGNALED,       // Job diakhiri oleh sinyal
-    UNKNOWN         // Status tidak diketahui
+    UNKNOWN,        // Status tidak diketahui
+    QUEUED          // Job background menunggu slot scheduler (NSH_MAX_BG_JOBS)
 };
 
 
+// Satu stage pipeline job: status dan rusage proses itu sendiri (wait4),
+// bukan total group
+struct JobStage {
+    pid_t pid = 0;
+    std::string command;
+    bool finished = false;
+    int status = 0;              // status gaya waitpid, valid jika finished
+    struct rusage usage = {};
+};
+
 struct Job {
     pid_t pgid;
     std::string command;
@@ -99,6 +112,10 @@ struct Job {
     int term_status; // Holds exit code or signal number
     pid_t shell_pid = 0;        // PID dari shell pemilik job (Session ID)
     struct timeval start_tv = {}; // Waktu mulai job (untuk CPU %)
+    std::string perf_summary;     // Total counter perf saat job selesai (NSH_PERF_COUNTERS)
+    PipeMeters pipe_meters;       // Relay meter yang masih berjalan (NSH_PIPE_METER)
+    std::string pipe_summary;     // Laporan meter saat job selesai
+    std::vector<JobStage> stages; // Per stage pipeline, urut kiri ke kanan
 };
 
 
@@ -0,0 +1,54 @@
+#ifndef JOB_LIMITS_H
+#define JOB_LIMITS_H
+
+#include "command.h"
+#include <string>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Resource limit (setrlimit) untuk builtin `ulimit` (limit shell, diwarisi
+// semua command berikutnya) dan `limit` (hanya satu command):
+//   ulimit [-SHa] [-c|-d|-e|-f|-i|-l|-m|-n|-q|-r|-s|-t|-u|-v|-x [VALUE]]...
+//   limit [-c|-d|-f|-n|-s|-t|-u|-v VALUE]... [--] COMMAND [ARG]...
+// Opsi dan satuannya mengikuti ulimit bash: ukuran dalam KB (-c -d -f -l
+// -m -s -v), -q dalam byte, -t dalam detik. Ukuran juga boleh ditulis
+// dengan akhiran (256M, 2G). `limit` memasang soft dan hard limit di child
+// sebelum exec dan menolak -m: Linux tidak menegakkan RLIMIT_RSS, memori
+// dibatasi dengan -v (RLIMIT_AS).
+
+struct LimitSpec {
+    char option;
+    int resource;
+    const char *description; // ulimit -a
+    const char *unit;        // "kbytes", "blocks", "seconds" atau nullptr
+    rlim_t scale;            // byte per satuan untuk ukuran, selain itu 1
+    const char *name;        // jobs -l
+};
+
+// Spec untuk opsi ulimit, nullptr jika tidak dikenal; limit_specs() untuk
+// ulimit -a (count diisi jumlahnya)
+const LimitSpec *limit_spec(char option);
+const LimitSpec *limit_specs(size_t &count);
+
+// "unlimited", angka dalam satuan spec, atau ukuran berakhiran (ukuran saja)
+bool limit_parse_value(const LimitSpec &spec, const std::string &text, rlim_t &value);
+// Nilai dalam satuan spec untuk ulimit, "unlimited" untuk RLIM_INFINITY
+std::string limit_format_value(const LimitSpec &spec, rlim_t value);
+
+// `limit` di awal salah satu stage pipeline
+bool limits_has_prefix(const ParsedCommand &group);
+
+// `limit OPTS [--] COMMAND...` -> COMMAND dengan cmd.limits terisi. Builtin
+// diganti program bernama sama (seperti timeout). false jika tidak valid
+// (sudah dilaporkan).
+bool limits_strip_prefix(SimpleCommand &cmd);
+
+// Dipanggil launch_process di child: pasang cmd.limits. false jika salah
+// satu gagal (sudah dilaporkan), command tidak boleh dijalankan.
+bool limits_apply(const SimpleCommand &cmd);
+
+// Limit proses pid yang berbeda dari limit shell (dibaca dengan prlimit),
+// e.g. "as=2G nofile=4096"; "-" jika sama semua
+std::string limits_describe(pid_t pid);
+
+#endif // JOB_LIMITS_H
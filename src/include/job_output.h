@@ -0,0 +1,44 @@
+#ifndef JOB_OUTPUT_H
+#define JOB_OUTPUT_H
+
+#include "command.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+// Capture output job background ke ring buffer milik shell, bukan ke
+// terminal atau file sementara. Opt-in, per shell atau per command
+// (`NSH_BG_CAPTURE=1 make -j8 &`):
+//   NSH_BG_CAPTURE      1 (1M per job), ukuran per job (256K, 4M), 0: mati
+//   NSH_BG_CAPTURE_MAX  total memori semua buffer (default 64M)
+// stdout stage terakhir dan stderr semua stage masuk ke satu pipe; event
+// loop menguras pipe itu ke buffer job. Jika buffer penuh, byte tertua
+// ditimpa. Buffer job yang sudah selesai dibuang saat "Done" dilaporkan,
+// atau lebih dulu jika batas total memori tercapai.
+//
+// `jobs -o %N` menampilkan isi buffer, `jobs -f %N` mengikutinya.
+
+// Di parent sebelum fork stage job background: write end pipe capture
+// (CLOEXEC, >= 10) untuk di-dup2 child, -1 jika capture tidak diminta
+int output_capture_prepare(const ParsedCommand &group);
+
+// Setelah semua stage di-fork: tutup write end dan mulai kuras pipe ke
+// buffer job pgid. output_capture_abort() jika job gagal dijalankan.
+void output_capture_attach(pid_t pgid);
+void output_capture_abort();
+
+// Isi buffer job (byte tertua dulu); false jika job tidak di-capture.
+// dropped: byte yang sudah ditimpa karena buffer penuh.
+bool output_capture_contents(pid_t pgid, std::string &contents, uint64_t *dropped = nullptr);
+
+// Callback untuk setiap data baru (jobs -f); nullptr untuk berhenti
+void output_capture_follow(pid_t pgid, std::function<void(const char *, size_t)> callback);
+
+// Pipe job masih terbuka (masih ada proses yang bisa menulis)
+bool output_capture_active(pid_t pgid);
+
+// Job sudah dilaporkan selesai: bebaskan buffer dan tutup pipe
+void output_capture_release(pid_t pgid);
+
+#endif // JOB_OUTPUT_H
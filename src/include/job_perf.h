@@ -0,0 +1,63 @@
+#ifndef JOB_PERF_H
+#define JOB_PERF_H
+
+#include "command.h"
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Counter perf_event_open per job: `time --perf PIPELINE` atau
+// NSH_PERF_COUNTERS=1 (per shell atau per command, juga untuk job `&`).
+// Parent memasang counter (inherit, jadi turunan proses ikut dihitung saat
+// exit) ke setiap proses job sebelum proses itu exec; child menunggu di pipe
+// sinkronisasi sampai counter terpasang.
+//
+// Hardware: cycles, instructions, cache-misses, branch-misses. Software:
+// page-faults, task-clock, context-switches. Tanpa PMU (VM, container) hanya
+// counter software yang dibuka; tanpa perf_event_open sama sekali (paranoid
+// 3, seccomp) totalnya diambil dari rusage job.
+
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_PAGE_FAULTS,
+    PERF_TASK_CLOCK,      // nanodetik
+    PERF_CONTEXT_SWITCHES,
+    PERF_EVENT_COUNT
+};
+
+struct PerfTotals {
+    bool counted = false;                  // job ini memang dihitung
+    const char *source = "rusage";         // "hardware", "software" atau "rusage"
+    bool have[PERF_EVENT_COUNT] = {};
+    uint64_t values[PERF_EVENT_COUNT] = {};
+};
+
+// NSH_PERF_COUNTERS=1 di command pertama job atau di shell
+bool perf_counters_requested(const ParsedCommand &group);
+
+// Sekitar fork stage job: perf_before_fork() di parent sebelum fork,
+// perf_child_ready() di child (launch_process) sebelum exec, perf_attach()
+// di parent setelah fork (melepas child), perf_fork_failed() jika fork gagal
+void perf_before_fork();
+void perf_child_ready();
+void perf_attach(pid_t pid, pid_t pgid);
+void perf_fork_failed();
+
+// Job selesai: baca total semua proses di group lalu tutup counter-nya.
+// usage dipakai jika perf_event_open tidak tersedia.
+bool perf_is_counted(pid_t pgid);
+PerfTotals perf_finish(pid_t pgid, const struct rusage &usage);
+void perf_discard(pid_t pgid);
+
+// "perf (software): 1532 page-faults, ..." dan nama event untuk JSON
+std::string perf_format(const PerfTotals &totals);
+const char *perf_event_name(int event);
+
+// IPC job yang masih berjalan (jobs -l), "-" jika tidak ada counter hardware
+std::string perf_ipc(pid_t pgid);
+
+#endif // JOB_PERF_H
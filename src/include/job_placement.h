@@ -0,0 +1,26 @@
+#ifndef JOB_PLACEMENT_H
+#define JOB_PLACEMENT_H
+
+#include "command.h"
+#include <string>
+#include <sys/types.h>
+
+// Placement job background: CPU affinity, nice, scheduling class dan I/O
+// priority diterapkan di child sebelum exec (tanpa taskset/nice/ionice).
+//
+// Variabel, per shell atau per command (`NSH_BG_NICE=19 make &`):
+//   NSH_BG_CPUS    daftar CPU, e.g. 4-15 atau 0,2,8-11   (sched_setaffinity)
+//   NSH_BG_NICE    nilai nice -20..19                     (setpriority)
+//   NSH_BG_SCHED   other, batch, idle, fifo:PRIO, rr:PRIO (sched_setscheduler)
+//   NSH_BG_IOPRIO  idle, be[:0-7], rt[:0-7] atau 0-7      (ioprio_set)
+// Hanya berlaku untuk job background; job foreground tidak disentuh.
+
+// Dipanggil launch_process di child: terapkan placement dari variabel di
+// atas (nilai yang tidak valid dilaporkan dan dilewati)
+void placement_apply(const SimpleCommand &cmd);
+
+// Placement efektif proses pid (dibaca dari kernel), e.g.
+// "cpus=4-15 nice=10 batch io=idle"; "-" jika semuanya default
+std::string placement_describe(pid_t pid);
+
+#endif // JOB_PLACEMENT_H
@@ -0,0 +1,64 @@
+#ifndef JOB_REGISTRY_H
+#define JOB_REGISTRY_H
+
+#include "globals.h"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// Registry lintas session: satu file ~/.nshprofile/jobs/registry-v2.map yang
+// di-mmap semua shell. Isinya slot ukuran tetap untuk session dan job.
+// - Update slot memakai seqlock (hanya shell pemilik yang menulis slotnya),
+//   pembaca mengulang baca jika sequence berubah di tengah jalan.
+// - Klaim/reuse slot dilakukan di bawah flock() pada file registry.
+// - Setiap session memegang OFD lock (fcntl) pada byte slot-nya; kernel
+//   melepasnya otomatis saat shell mati, jadi slot yatim bisa dikenali
+//   tanpa menebak dari pid.
+// - Setiap shell memantau direktori registry dengan inotify lewat event loop;
+//   snapshot job session lain hanya dibaca ulang setelah ada perubahan dari
+//   session lain (generation di header), bukan setelah publish sendiri.
+
+struct RegistryJob {
+    pid_t owner_pid;
+    pid_t pgid;
+    int job_id;
+    JobStatus status;
+    int term_status;
+    struct rusage usage;
+    struct timeval start_tv;
+    std::string command;
+    bool owner_alive;
+};
+
+// Buka (atau buat) registry dan daftarkan session ini.
+// Return nomor session (jumlah session hidup termasuk session ini), 0 jika gagal.
+int registry_open();
+
+// Lepas slot session dan semua slot job milik shell ini.
+void registry_close();
+
+// Tulis state job ke slot miliknya (klaim slot baru jika belum ada).
+void registry_publish_job(int job_id, const Job &job);
+void registry_remove_job(pid_t pgid);
+
+// Beri tahu session lain bahwa slot berubah (sekali per batch publish/remove)
+void registry_notify();
+
+// Salinan konsisten semua slot job milik session lain.
+std::vector<RegistryJob> registry_foreign_jobs();
+
+// Snapshot registry_foreign_jobs() yang di-cache sampai watcher melihat perubahan
+const std::vector<RegistryJob> &registry_foreign_jobs_cached();
+
+// Job session lain yang selesai sejak panggilan terakhir (untuk laporan di prompt)
+std::vector<RegistryJob> registry_take_foreign_finished();
+
+// Bebaskan slot job yang pemiliknya sudah mati dan process group-nya hilang.
+void registry_reap_stale();
+
+// Path file registry
+std::string registry_path();
+
+#endif // JOB_REGISTRY_H
@@ -0,0 +1,36 @@
+#ifndef JOB_SAMPLER_H
+#define JOB_SAMPLER_H
+
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Sampler /proc untuk `jobs --top`. Setiap proses di process group job
+// dibaca dari /proc/<pid>/stat (CPU, thread, RSS) dan /proc/<pid>/io
+// (throughput baca/tulis). Fd kedua file itu tetap terbuka di antara sample
+// dan dibaca ulang dengan pread, jadi satu sample hanya dua syscall per
+// proses. Proses anggota group dicari dari record event loop dan
+// /proc/<pid>/task/<pid>/children, diulang setiap beberapa sample saja.
+
+struct JobSample {
+    pid_t pgid = 0;
+    size_t processes = 0;
+    long threads = 0;
+    double cpu_percent = 0;  // 100% = satu CPU penuh
+    uint64_t rss_bytes = 0;
+    double read_rate = 0;    // byte/detik (rchar: termasuk pipe dan cache)
+    double write_rate = 0;
+    bool io_available = false;
+};
+
+// Ambil sample semua job (pgid); rate dihitung terhadap sample sebelumnya
+std::vector<JobSample> sampler_sample(const std::vector<pid_t> &pgids);
+
+// CPU time dan peak RSS satu proses yang masih berjalan (jobs -l)
+bool sampler_process_usage(pid_t pid, struct rusage &usage);
+
+// Tutup semua fd yang disimpan sampler
+void sampler_reset();
+
+#endif // JOB_SAMPLER_H
@@ -0,0 +1,56 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include "command.h"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Scheduler job background (opsional). Jika batas job berjalan tercapai,
+// `cmd &` masuk antrian shell (status Queued di `jobs`) dan baru di-fork saat
+// slot kosong; dijalankan dari event exit child, tanpa polling.
+//
+// Konfigurasi lewat variabel, dibaca setiap kali dipakai:
+//   NSH_MAX_BG_JOBS          batas total job background berjalan (kosong/0: tanpa batas)
+//   NSH_MAX_BG_JOBS_<QUEUE>  batas per antrian, e.g. NSH_MAX_BG_JOBS_io=2
+//   NSH_BG_QUEUE             nama antrian job (default "default")
+//   NSH_BG_PRIORITY          prioritas job, lebih besar jalan lebih dulu (default 0)
+// NSH_BG_QUEUE/NSH_BG_PRIORITY bisa diberikan per command:
+//   NSH_BG_QUEUE=io NSH_BG_PRIORITY=5 rsync a b &
+
+struct QueuedJobInfo {
+    int job_id;
+    std::string command;
+    std::string queue;
+    int priority;
+};
+
+// Masukkan job background ke antrian jika ada batas yang tercapai (atau
+// antrian belum kosong). Return true jika job diantrikan.
+bool scheduler_enqueue_if_limited(const ParsedCommand &group, bool use_env, const std::string &command);
+
+// Job id yang sedang dijalankan dari antrian (dipakai execute_job), 0 jika bukan
+int scheduler_launching_job_id();
+
+// Pembukuan job background berjalan; dipanggil dari execute_job dan job list
+void scheduler_job_started(pid_t pgid, const ParsedCommand &group);
+void scheduler_job_running(pid_t pgid, bool running);
+void scheduler_job_gone(pid_t pgid);
+
+// Jalankan job antrian selama masih ada slot
+void scheduler_dispatch();
+
+// Job antrian: daftar, cek, batalkan (kill) atau jalankan sekarang (bg)
+std::vector<QueuedJobInfo> scheduler_queued_jobs();
+bool scheduler_is_queued(int job_id);
+bool scheduler_cancel(int job_id);
+bool scheduler_start_now(int job_id);
+
+size_t scheduler_queued_count();
+size_t scheduler_running_count();
+
+// Shell non-interaktif: tunggu sampai semua job antrian sudah dijalankan
+// sebelum keluar
+void scheduler_drain();
+
+#endif // JOB_SCHEDULER_H
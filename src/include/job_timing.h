@@ -0,0 +1,69 @@
+#ifndef JOB_TIMING_H
+#define JOB_TIMING_H
+
+#include "command.h"
+#include "job_perf.h"
+#include "pipe_meter.h"
+#include <string>
+#include <vector>
+#include <ctime>
+#include <sys/types.h>
+#include <sys/resource.h>
+
+// Keyword `time` di awal pipeline foreground:
+//   time [-p] [-v] [--json] [--perf] [--pipes] [-o FILE] PIPELINE
+// Wall clock diukur dengan CLOCK_MONOTONIC, rusage diambil per proses dari
+// wait4 di event loop (bukan getrusage(RUSAGE_CHILDREN) yang ikut menghitung
+// job lain). Builtin yang berjalan di shell/thread memakai RUSAGE_THREAD.
+//
+// Format laporan:
+//   default       real/user/sys + max RSS, major fault, context switch;
+//                 tabel per stage untuk pipeline > 1 stage (atau -v)
+//   TIMEFORMAT    seperti bash (%[p][l]R %[p][l]U %[p][l]S %P %%), plus
+//                 %M max RSS (KB), %F major fault, %w/%c context switch
+//                 voluntary/involuntary
+//   -p            format POSIX (real/user/sys, detik)
+//   --json        satu baris JSON (total + stages) untuk skrip benchmark
+//   --perf        tambah total counter perf_event_open job (job_perf.h)
+//   --pipes       tambah throughput per sambungan pipe (pipe_meter.h)
+
+struct StageTiming {
+    std::string command;
+    pid_t pid = 0;               // 0: builtin (di shell atau thread pipeline)
+    bool finished = false;       // false: stage di-stop (Ctrl-Z) atau gagal dijalankan
+    int exit_code = 0;
+    struct timespec started = {};
+    struct timespec ended = {};
+    struct rusage usage = {};
+    struct rusage baseline = {}; // builtin: snapshot saat mulai
+    bool with_children = false;  // builtin: ikut hitung child yang di-reap (parallel, timeout)
+};
+
+struct JobTiming {
+    struct timespec started = {};
+    struct timespec ended = {};
+    std::vector<StageTiming> stages;
+    bool perf_requested = false; // time --perf
+    PerfTotals perf;             // diisi execute_job jika job dihitung
+    bool pipes_requested = false; // time --pipes
+    PipeMeters pipes;            // diisi execute_job saat job selesai
+};
+
+struct timespec timing_now();
+
+// Dipanggil execute_job untuk setiap stage. pid 0: builtin yang dijalankan
+// di thread pemanggil (snapshot RUSAGE_THREAD, dan RUSAGE_CHILDREN jika
+// with_children).
+void timing_stage_start(StageTiming &stage, pid_t pid, bool with_children = false);
+void timing_stage_builtin_done(StageTiming &stage, int exit_code);
+void timing_stage_process_done(StageTiming &stage, int status, const struct rusage &usage,
+                               const struct timespec &exited_at);
+
+// True jika pipeline diawali keyword `time`
+bool is_timed_job(const ParsedCommand &group);
+
+// Jalankan `time PIPELINE` (group sudah di-expand): strip keyword dan
+// opsinya, execute_job, lalu tulis laporan ke stderr (atau -o FILE).
+int execute_timed_job(const ParsedCommand &group, bool use_env);
+
+#endif // JOB_TIMING_H
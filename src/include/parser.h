@@ -12,6 +12,8 @@ enum class TokenType
 {
     WORD,
     STRING,
+    IO_NUMBER,      // fd di depan redirection, e.g. `2` pada `2>file`
+    PROCESS_SUBST,  // `<(cmd)` / `>(cmd)` tanpa kutip
     PIPE,
     AND_IF,
     OR_IF,
@@ -51,6 +53,7 @@ private:
     std::string get_history_by_number(int number);
     std::string get_history_by_pattern(const std::string& pattern);
     void expand_aliases(std::vector<Token> &tokens);
+    std::vector<ParsedCommand> parse_tokens(const std::vector<Token> &tokens);
     std::string clean_EOF_IN_line(std::string line) const;
 };
 
@@ -0,0 +1,53 @@
+#ifndef PIPE_METER_H
+#define PIPE_METER_H
+
+#include "command.h"
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Throughput per sambungan pipe: NSH_PIPE_METER=1 (per shell atau per
+// command, juga untuk job `&`) atau `time --pipes`. Setiap sambungan `a | b`
+// yang dibuat execute_job diberi relay splice(2) (pipe_relay.h) yang
+// menghitung byte yang lewat dan waktu relay menunggu:
+//   producer-blocked  relay memegang data tapi pipe ke b penuh: b yang
+//                     lambat, a tertahan di pipe-nya
+//   consumer-blocked  pipe dari a kosong: b kelaparan menunggu a
+// Di `a |buf SIZE| b` relay buffer sendiri yang mengukur; producer-blocked
+// di sana berarti buffer penuh. Sambungan fan-out dan merge tidak diukur.
+// Laporan ditulis saat job selesai: ke stderr (foreground), bersama "Done"
+// (background), atau di laporan `time --pipes`.
+
+struct PipeMeter {
+    size_t producer = 0;          // index stage penulis, pembacanya producer + 1
+    std::string command;          // "a | b"
+    struct timespec started = {}; // diisi shell saat relay dimulai
+    struct timespec ended = {};   // diisi relay sebelum finished
+    std::atomic<unsigned long long> bytes{0};
+    std::atomic<long long> producer_blocked_ns{0};
+    std::atomic<long long> consumer_blocked_ns{0};
+    std::atomic<bool> finished{false};
+};
+
+using PipeMeters = std::vector<std::shared_ptr<PipeMeter>>;
+
+// NSH_PIPE_METER=1 di command pertama job atau di shell
+bool pipe_meter_requested(const ParsedCommand &group);
+
+// Relay selesai: catat waktu akhir lalu tandai finished
+void pipe_meter_finish(PipeMeter &meter);
+
+// Semua proses job sudah exit, relay tinggal melihat EOF/EPIPE: tunggu
+// sebentar. Relay yang masih berjalan (ujung pipe diwarisi proses lain)
+// dilaporkan sampai saat ini.
+void pipe_meter_settle(const PipeMeters &meters);
+
+// Tabel per sambungan (EDGE BYTES MB/s PRODUCER-BLOCKED CONSUMER-BLOCKED),
+// diakhiri newline; array JSON untuk `time --json --pipes`
+std::string pipe_meter_format(const PipeMeters &meters);
+std::string pipe_meter_json(const PipeMeters &meters);
+
+#endif // PIPE_METER_H
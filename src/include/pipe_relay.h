@@ -0,0 +1,48 @@
+#ifndef PIPE_RELAY_H
+#define PIPE_RELAY_H
+
+#include "pipe_meter.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Relay data pipeline yang berjalan di shell, untuk topologi yang tidak
+// bisa dibuat dengan satu pipe per stage:
+//   producer |{ c1 ; c2 ; c3 }   fan-out: output producer diduplikasi ke
+//                                stdin setiap cabang dengan tee(2) dan
+//                                splice(2), tanpa menyalin ke user space
+//   { p1 & p2 } |merge consumer  fan-in: baris utuh dari setiap producer
+//                                diteruskan ke stdin consumer (epoll)
+//   a |buf 256M| b               buffer elastis: a tidak tertahan saat b
+//                                berhenti membaca, sampai 256M
+//   NSH_PIPE_METER=1 a | b       meter: byte dan waktu tunggu sambungan
+//                                (pipe_meter.h)
+// Relay berjalan di thread sendiri (detached) dan memiliki fd yang
+// diberikan: semuanya ditutup saat relay selesai, dan di child hasil fork
+// shell (pthread_atfork) supaya consumer tetap melihat EOF.
+
+// Mulai relay fan-out dari in_fd (read end pipe) ke setiap out_fds (write
+// end pipe). Semua cabang maju bersama, secepat consumer paling lambat,
+// seperti tee(1). Consumer yang keluar lebih dulu dilepas; jika semua
+// sudah keluar, in_fd ditutup dan producer mendapat SIGPIPE. false jika
+// thread gagal dibuat (fd sudah ditutup).
+bool relay_start_fanout(int in_fd, const std::vector<int> &out_fds);
+
+// Mulai relay merge dari setiap in_fds (read end pipe producer) ke out_fd
+// (write end pipe consumer). Hanya baris utuh yang diteruskan, jadi baris
+// dari producer berbeda tidak pernah tercampur; baris terakhir tanpa
+// newline diberi newline. tagged: setiap baris diawali "[N] " (producer
+// ke-N, mulai 1). Antrian ke consumer dibatasi buffer_limit byte (0:
+// default 1M): jika penuh relay berhenti membaca, producer tertahan di
+// pipe-nya sendiri. Baris yang lebih panjang dari batas diteruskan per
+// bagian. Jika consumer keluar, producer mendapat SIGPIPE.
+bool relay_start_merge(const std::vector<int> &in_fds, int out_fd, size_t buffer_limit, bool tagged);
+
+// Mulai relay buffer dari in_fd ke out_fd (keduanya pipe). Selama buffer
+// kosong data dipindah dengan splice(2) tanpa salinan; saat out_fd penuh
+// data ditampung di memori shell sampai limit byte, dialokasikan per blok
+// dan dibebaskan lagi begitu terkirim. limit 0: tanpa buffer, hanya meter.
+// meter (boleh nullptr) diisi selama relay berjalan dan di-finish di akhir.
+bool relay_start_buffer(int in_fd, int out_fd, size_t limit, std::shared_ptr<PipeMeter> meter = nullptr);
+
+#endif // PIPE_RELAY_H
@@ -0,0 +1,24 @@
+#ifndef REDIR_CACHE_H
+#define REDIR_CACHE_H
+
+#include "command.h"
+#include <string>
+#include <vector>
+
+// Cache kecil fd untuk target redirection yang sering dipakai ulang
+// (`cmd >> log` di dalam loop, `2>/dev/null`). Fd dibuka oleh shell dengan
+// O_CLOEXEC di nomor fd tinggi, lalu child cukup dup2() tanpa open/close.
+
+// Dipanggil di parent sebelum fork: buka/validasi entry untuk semua
+// redirection yang bisa di-cache di pipeline.
+void redir_cache_prepare(const std::vector<SimpleCommand> &pipeline);
+
+// Fd cache untuk redirection ini, atau -1. Tidak melakukan open().
+int redir_cache_lookup(const Redirection &redir);
+
+// Lupakan entry yang memakai fd ini (fd sudah di-dup2/close oleh `exec`).
+void redir_cache_forget_fd(int fd);
+
+void redir_cache_clear();
+
+#endif // REDIR_CACHE_H
@@ -2,9 +2,11 @@
 #define UTILS_H
 
 #include <string>
+#include <iosfwd>
 
 int get_terminal_width();
 void safe_print(const std::string &text);
+void safe_print(const std::string &text, std::ostream &out);
 //std::string rtrim(std::string s);
 bool ends_with_EOF_IN_operator(const std::string &line);
 size_t visible_width(const std::string &s);
@@ -17,5 +19,11 @@ unsigned int xrand(unsigned int seed, int min, int max);
 void input_redisplay();
 // In utils.h
 bool is_string_numeric(const std::string& s);
+// Nomor fd redirection ("2", "10"); false jika bukan angka atau di luar int
+bool parse_fd_number(const std::string& s, int& fd);
+// Ukuran dengan akhiran K/M/G/T (kelipatan 1024): "256M", "2G"
+bool parse_byte_size(const std::string& s, unsigned long long& bytes);
+// Kebalikannya, dengan akhiran terbesar yang pas: 268435456 -> "256M"
+std::string format_byte_size(unsigned long long bytes);
 
 #endif // UTILS_H
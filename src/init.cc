@@ -2,6 +2,7 @@
 #include "utils.h" // untuk xrand(seed, min, max);
 #include "globals.h"
 #include "terminal.h"
+#include "job_registry.h"
 
 #include <filesystem>
 #include <iostream>
@@ -28,37 +29,17 @@ extern int current_session_number;
 // Tambahkan fungsi-fungsi ini di init.cc
 
 void initialize_session_manager() {
+    // Daftar session sekarang ada di registry bersama (job_registry.cc);
+    // session.cache lama tidak dipakai lagi
     ns_SESSION_FILE = ns_CONFIG_DIR / "session.cache";
-    
-    // Baca session yang ada dan bersihkan yang sudah tidak aktif
-    std::ifstream session_file(ns_SESSION_FILE);
-    std::vector<int> active_sessions;
-    
-    if (session_file.is_open()) {
-        int session_id;
-        while (session_file >> session_id) {
-            // Periksa apakah session masih aktif dengan mengirim signal 0
-            if (kill(session_id, 0) == 0 || errno == EPERM) {
-                // Process masih ada atau kita tidak punya permission (tapi process ada)
-                active_sessions.push_back(session_id);
-            }
-            // Jika kill return -1 dan errno ESRCH, process tidak ada - skip
-        }
-        session_file.close();
-    }
-    
+    std::error_code ec;
+    fs::remove(ns_SESSION_FILE, ec);
+
     // Generate session ID baru (menggunakan PID shell utama)
     int new_session_id = getpid();
-    current_session_number = active_sessions.size() + 1;
-    
-    // Tulis ulang file session dengan session yang masih aktif + yang baru
-    std::ofstream out_file(ns_SESSION_FILE, std::ios::trunc);
-    if (out_file.is_open()) {
-        for (int session_id : active_sessions) {
-            out_file << session_id << std::endl;
-        }
-        out_file << new_session_id << std::endl;
-        out_file.close();
+    current_session_number = registry_open();
+    if (current_session_number == 0) {
+        current_session_number = 1;
     }
     
     // Set foreground_pgid ke session ID baru
@@ -76,36 +57,8 @@ void initialize_session_manager() {
 }
 
 void cleanup_session_manager() {
-    // Hapus session current dari file session cache
-    if (!ns_SESSION_FILE.empty() && fs::exists(ns_SESSION_FILE)) {
-        std::ifstream session_file(ns_SESSION_FILE);
-        std::vector<int> active_sessions;
-        
-        if (session_file.is_open()) {
-            int session_id;
-            while (session_file >> session_id) {
-                // Jangan masukkan session current yang akan di-cleanup
-                if (session_id != getpid()) {
-                    active_sessions.push_back(session_id);
-                }
-            }
-            session_file.close();
-        }
-        
-        // Tulis ulang file tanpa session current
-        std::ofstream out_file(ns_SESSION_FILE, std::ios::trunc);
-        if (out_file.is_open()) {
-            for (int session_id : active_sessions) {
-                out_file << session_id << std::endl;
-            }
-            out_file.close();
-        }
-        
-        // Jika file kosong, hapus file session cache
-        if (active_sessions.empty()) {
-            fs::remove(ns_SESSION_FILE);
-        }
-    }
+    // Lepas slot session dan job milik shell ini dari registry
+    registry_close();
     
     // Reset foreground_pgid
     foreground_pgid = 0;
@@ -0,0 +1,218 @@
+#include "job_limits.h"
+#include "execution.h" // is_builtin, find_binary, erase_leading_tokens
+#include "utils.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+constexpr LimitSpec SPECS[] = {
+    {'c', RLIMIT_CORE, "core file size", "blocks", 1024, "core"},
+    {'d', RLIMIT_DATA, "data seg size", "kbytes", 1024, "data"},
+    {'e', RLIMIT_NICE, "scheduling priority", nullptr, 1, "nice"},
+    {'f', RLIMIT_FSIZE, "file size", "blocks", 1024, "fsize"},
+    {'i', RLIMIT_SIGPENDING, "pending signals", nullptr, 1, "sigpending"},
+    {'l', RLIMIT_MEMLOCK, "max locked memory", "kbytes", 1024, "memlock"},
+    {'m', RLIMIT_RSS, "max memory size", "kbytes", 1024, "rss"},
+    {'n', RLIMIT_NOFILE, "open files", nullptr, 1, "nofile"},
+    {'q', RLIMIT_MSGQUEUE, "POSIX message queues", "bytes", 1, "msgqueue"},
+    {'r', RLIMIT_RTPRIO, "real-time priority", nullptr, 1, "rtprio"},
+    {'s', RLIMIT_STACK, "stack size", "kbytes", 1024, "stack"},
+    {'t', RLIMIT_CPU, "cpu time", "seconds", 1, "cpu"},
+    {'u', RLIMIT_NPROC, "max user processes", nullptr, 1, "nproc"},
+    {'v', RLIMIT_AS, "virtual memory", "kbytes", 1024, "as"},
+    {'x', RLIMIT_LOCKS, "file locks", nullptr, 1, "locks"},
+};
+
+// glibc (_GNU_SOURCE) memakai enum untuk resource, bukan int
+using Resource = decltype(RLIMIT_CPU);
+
+bool is_size(const LimitSpec &spec)
+{
+    return spec.unit && strcmp(spec.unit, "seconds") != 0;
+}
+
+// Nilai limit untuk jobs -l: ukuran dalam K/M/G, detik untuk CPU
+std::string describe_value(const LimitSpec &spec, rlim_t value)
+{
+    if (value == RLIM_INFINITY)
+        return "unlimited";
+    if (spec.resource == RLIMIT_CPU)
+        return std::to_string(value) + "s";
+    if (!is_size(spec))
+        return std::to_string(value);
+    return format_byte_size(value);
+}
+
+} // namespace
+
+const LimitSpec *limit_spec(char option)
+{
+    for (const LimitSpec &spec : SPECS)
+    {
+        if (spec.option == option)
+            return &spec;
+    }
+    return nullptr;
+}
+
+const LimitSpec *limit_specs(size_t &count)
+{
+    count = sizeof(SPECS) / sizeof(SPECS[0]);
+    return SPECS;
+}
+
+bool limit_parse_value(const LimitSpec &spec, const std::string &text, rlim_t &value)
+{
+    if (text == "unlimited" || text == "infinity")
+    {
+        value = RLIM_INFINITY;
+        return true;
+    }
+    if (is_string_numeric(text))
+    {
+        errno = 0;
+        unsigned long long number = strtoull(text.c_str(), nullptr, 10);
+        if (errno != 0 || number > RLIM_INFINITY / spec.scale)
+            return false;
+        value = static_cast<rlim_t>(number) * spec.scale;
+        return true;
+    }
+
+    // 256M, 2G: byte langsung, hanya untuk limit berupa ukuran
+    unsigned long long bytes;
+    if (!is_size(spec) || !parse_byte_size(text, bytes))
+        return false;
+    value = static_cast<rlim_t>(bytes);
+    return true;
+}
+
+std::string limit_format_value(const LimitSpec &spec, rlim_t value)
+{
+    if (value == RLIM_INFINITY)
+        return "unlimited";
+    return std::to_string(value / spec.scale);
+}
+
+bool limits_has_prefix(const ParsedCommand &group)
+{
+    for (const SimpleCommand &cmd : group.pipeline)
+    {
+        if (!cmd.tokens.empty() && cmd.tokens[0] == "limit")
+            return true;
+    }
+    return false;
+}
+
+bool limits_strip_prefix(SimpleCommand &cmd)
+{
+    size_t i = 1;
+    std::vector<ResourceLimit> limits;
+    for (; i < cmd.tokens.size(); ++i)
+    {
+        const std::string &option = cmd.tokens[i];
+        if (option == "--")
+        {
+            i++;
+            break;
+        }
+        if (option.size() != 2 || option[0] != '-')
+            break;
+
+        // -m (RLIMIT_RSS) tidak ditegakkan Linux: limit yang diam-diam tidak
+        // berlaku lebih buruk daripada error, memori dibatasi dengan -v
+        const LimitSpec *spec = option[1] == 'm' ? nullptr : limit_spec(option[1]);
+        if (!spec)
+        {
+            if (option[1] == 'm')
+                std::cerr << "nsh: limit: -m: resident set size is not enforced by Linux, use -v" << std::endl;
+            else
+                std::cerr << "nsh: limit: " << option << ": invalid option" << std::endl;
+            std::cerr << "limit: usage: limit [-c|-d|-f|-n|-s|-t|-u|-v VALUE]... [--] COMMAND [ARG]..." << std::endl;
+            return false;
+        }
+        rlim_t value;
+        if (i + 1 >= cmd.tokens.size() || !limit_parse_value(*spec, cmd.tokens[i + 1], value))
+        {
+            std::cerr << "nsh: limit: " << option << ": invalid limit `"
+                      << (i + 1 < cmd.tokens.size() ? cmd.tokens[i + 1] : "") << "'" << std::endl;
+            return false;
+        }
+        limits.push_back({spec->resource, value});
+        i++;
+    }
+
+    if (i >= cmd.tokens.size())
+    {
+        std::cerr << "nsh: limit: missing command" << std::endl;
+        return false;
+    }
+    erase_leading_tokens(cmd, i);
+    cmd.limits.insert(cmd.limits.end(), limits.begin(), limits.end());
+
+    // Limit berlaku untuk proses sendiri, bukan untuk shell
+    if (is_builtin(cmd.tokens[0]))
+    {
+        std::string binary = find_binary(cmd.tokens[0]);
+        if (binary.empty())
+        {
+            std::cerr << "nsh: limit: " << cmd.tokens[0] << ": shell builtin cannot be run with resource limits" << std::endl;
+            return false;
+        }
+        cmd.tokens[0] = binary;
+    }
+    return true;
+}
+
+/**
+ * @brief Pasang limit `limit ... -- cmd` di child, tepat sebelum execve.
+ *
+ * Soft dan hard limit sama-sama diturunkan, jadi command tidak bisa
+ * menaikkannya lagi. Menaikkan di atas hard limit shell butuh
+ * CAP_SYS_RESOURCE; jika gagal command tidak dijalankan.
+ */
+bool limits_apply(const SimpleCommand &cmd)
+{
+    for (const ResourceLimit &limit : cmd.limits)
+    {
+        struct rlimit value = {limit.value, limit.value};
+        if (setrlimit(static_cast<Resource>(limit.resource), &value) != 0)
+        {
+            const char *name = "?";
+            for (const LimitSpec &spec : SPECS)
+            {
+                if (spec.resource == limit.resource)
+                    name = spec.name;
+            }
+            std::cerr << "nsh: limit: " << name << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string limits_describe(pid_t pid)
+{
+    if (pid <= 0)
+        return "-";
+
+    // Hanya yang berbeda dari shell itu sendiri yang ditampilkan
+    std::string text;
+    for (const LimitSpec &spec : SPECS)
+    {
+        struct rlimit limit, shell_limit;
+        Resource resource = static_cast<Resource>(spec.resource);
+        if (prlimit(pid, resource, nullptr, &limit) != 0 || getrlimit(resource, &shell_limit) != 0 ||
+            limit.rlim_cur == shell_limit.rlim_cur)
+            continue;
+        if (!text.empty())
+            text += ' ';
+        text += std::string(spec.name) + "=" + describe_value(spec, limit.rlim_cur);
+    }
+    return text.empty() ? "-" : text;
+}
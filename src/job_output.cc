@@ -0,0 +1,327 @@
+#include "job_output.h"
+#include "events.h"
+#include "globals.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+namespace {
+
+constexpr unsigned long long DEFAULT_JOB_LIMIT = 1ULL << 20;
+constexpr unsigned long long DEFAULT_TOTAL_LIMIT = 64ULL << 20;
+constexpr size_t READ_CHUNK = 64 * 1024;
+constexpr int READS_PER_EVENT = 16; // job yang sangat cerewet tidak memonopoli loop
+
+struct Capture {
+    int fd = -1;               // read end pipe, -1 setelah EOF
+    std::vector<char> data;    // ring, tumbuh sampai limit
+    size_t start = 0;          // posisi byte tertua
+    size_t used = 0;
+    size_t limit = 0;
+    uint64_t dropped = 0;
+    uint64_t closed_order = 0; // urutan EOF, untuk membuang buffer tertua
+    std::function<void(const char *, size_t)> follower;
+};
+
+std::unordered_map<pid_t, Capture> captures;
+size_t total_allocated = 0;
+uint64_t close_counter = 0;
+bool atfork_registered = false;
+
+// Pipe yang sedang disiapkan untuk job berikutnya
+int pending_fds[2] = {-1, -1};
+size_t pending_limit = 0;
+size_t total_limit = DEFAULT_TOTAL_LIMIT;
+
+const char *capture_setting(const ParsedCommand &group, const char *name)
+{
+    if (!group.pipeline.empty())
+    {
+        auto it = group.pipeline[0].env_vars.find(name);
+        if (it != group.pipeline[0].env_vars.end())
+            return it->second.c_str();
+    }
+    const char *value = get_env_var(name);
+    return (value && *value) ? value : nullptr;
+}
+
+int move_high(int fd)
+{
+    if (fd < 0 || fd >= 10)
+        return fd;
+    int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+    if (high_fd == -1)
+        return fd;
+    close(fd);
+    return high_fd;
+}
+
+void close_pending()
+{
+    for (int &fd : pending_fds)
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+}
+
+// Child hasil fork (builtin `&`, `jobs -o %1 | grep x`) tidak ikut memegang
+// read end; isi buffer tetap bisa dibaca
+void reset_after_fork()
+{
+    for (auto &[pgid, capture] : captures)
+    {
+        if (capture.fd >= 0)
+            close(capture.fd);
+        capture.fd = -1;
+        capture.follower = nullptr;
+    }
+    if (pending_fds[0] >= 0)
+        close(pending_fds[0]);
+    pending_fds[0] = -1;
+}
+
+void stop_reading(Capture &capture)
+{
+    if (capture.fd < 0)
+        return;
+    event_loop_remove_fd(capture.fd);
+    close(capture.fd);
+    capture.fd = -1;
+    capture.closed_order = ++close_counter;
+}
+
+void free_capture(std::unordered_map<pid_t, Capture>::iterator it)
+{
+    stop_reading(it->second);
+    total_allocated -= it->second.data.size();
+    captures.erase(it);
+}
+
+// Buang buffer job yang sudah selesai (EOF), yang tertua dulu, sampai
+// `needed` byte muat di batas total
+void evict_closed(size_t needed, pid_t keep)
+{
+    while (total_allocated + needed > total_limit)
+    {
+        auto oldest = captures.end();
+        for (auto it = captures.begin(); it != captures.end(); ++it)
+        {
+            if (it->first == keep || it->second.fd >= 0)
+                continue;
+            if (oldest == captures.end() || it->second.closed_order < oldest->second.closed_order)
+                oldest = it;
+        }
+        if (oldest == captures.end())
+            return;
+        free_capture(oldest);
+    }
+}
+
+// Perbesar ring (disusun ulang mulai dari byte tertua) sebanyak yang
+// diizinkan limit job dan batas total
+void grow(pid_t pgid, Capture &capture, size_t wanted)
+{
+    size_t target = std::min(capture.limit, std::max(wanted, capture.data.size() * 2));
+    if (target <= capture.data.size())
+        return;
+    evict_closed(target - capture.data.size(), pgid);
+    size_t available = total_limit > total_allocated ? total_limit - total_allocated : 0;
+    target = std::min(target, capture.data.size() + available);
+    if (target <= capture.data.size())
+        return;
+
+    std::vector<char> resized(target);
+    size_t first = std::min(capture.used, capture.data.size() - capture.start);
+    std::copy_n(capture.data.begin() + capture.start, first, resized.begin());
+    std::copy_n(capture.data.begin(), capture.used - first, resized.begin() + first);
+    total_allocated += target - capture.data.size();
+    capture.data.swap(resized);
+    capture.start = 0;
+}
+
+void append(pid_t pgid, Capture &capture, const char *bytes, size_t length)
+{
+    if (capture.used + length > capture.data.size())
+        grow(pgid, capture, capture.used + length);
+
+    size_t capacity = capture.data.size();
+    if (capacity == 0)
+    {
+        capture.dropped += length; // batas total habis untuk job aktif
+        return;
+    }
+    if (length > capacity)
+    {
+        capture.dropped += length - capacity;
+        bytes += length - capacity;
+        length = capacity;
+    }
+    size_t overflow = capture.used + length > capacity ? capture.used + length - capacity : 0;
+    capture.dropped += overflow;
+    capture.start = (capture.start + overflow) % capacity;
+    capture.used -= overflow;
+
+    size_t end = (capture.start + capture.used) % capacity;
+    size_t first = std::min(length, capacity - end);
+    std::copy_n(bytes, first, capture.data.begin() + end);
+    std::copy_n(bytes + first, length - first, capture.data.begin());
+    capture.used += length;
+}
+
+void drain(pid_t pgid)
+{
+    char buffer[READ_CHUNK];
+    for (int i = 0; i < READS_PER_EVENT; ++i)
+    {
+        auto it = captures.find(pgid);
+        if (it == captures.end() || it->second.fd < 0)
+            return;
+        Capture &capture = it->second;
+        ssize_t n = read(capture.fd, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            append(pgid, capture, buffer, static_cast<size_t>(n));
+            if (capture.follower)
+                capture.follower(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1 && errno == EAGAIN)
+            return;
+        stop_reading(capture); // EOF: semua proses job sudah menutup output
+        return;
+    }
+}
+
+// "1" atau kosong: ukuran default, "0": mati, selain itu ukuran per job
+bool parse_job_limit(const char *value, size_t &limit)
+{
+    if (strcmp(value, "0") == 0)
+        return false;
+    unsigned long long bytes = DEFAULT_JOB_LIMIT;
+    if (strcmp(value, "1") != 0 && (!parse_byte_size(value, bytes) || bytes == 0))
+    {
+        std::cerr << "nsh: NSH_BG_CAPTURE: " << value << ": invalid size" << std::endl;
+        return false;
+    }
+    limit = static_cast<size_t>(bytes);
+    return true;
+}
+
+} // namespace
+
+int output_capture_prepare(const ParsedCommand &group)
+{
+    close_pending();
+    const char *value = capture_setting(group, "NSH_BG_CAPTURE");
+    if (!value || !parse_job_limit(value, pending_limit))
+        return -1;
+
+    unsigned long long bytes = DEFAULT_TOTAL_LIMIT;
+    if (const char *max = capture_setting(group, "NSH_BG_CAPTURE_MAX"))
+    {
+        if (!parse_byte_size(max, bytes))
+        {
+            std::cerr << "nsh: NSH_BG_CAPTURE_MAX: " << max << ": invalid size" << std::endl;
+            bytes = DEFAULT_TOTAL_LIMIT;
+        }
+    }
+    total_limit = static_cast<size_t>(bytes);
+
+    if (pipe2(pending_fds, O_CLOEXEC) != 0)
+    {
+        std::cerr << "nsh: NSH_BG_CAPTURE: pipe: " << strerror(errno) << std::endl;
+        pending_fds[0] = pending_fds[1] = -1;
+        return -1;
+    }
+    pending_fds[0] = move_high(pending_fds[0]);
+    pending_fds[1] = move_high(pending_fds[1]);
+    fcntl(pending_fds[0], F_SETFL, O_NONBLOCK);
+    if (!atfork_registered)
+    {
+        pthread_atfork(nullptr, nullptr, reset_after_fork);
+        atfork_registered = true;
+    }
+    return pending_fds[1];
+}
+
+void output_capture_attach(pid_t pgid)
+{
+    if (pending_fds[0] < 0)
+        return;
+    close(pending_fds[1]);
+    pending_fds[1] = -1;
+
+    // pgid bisa dipakai ulang kernel: buffer job lama tidak relevan lagi
+    auto old = captures.find(pgid);
+    if (old != captures.end())
+        free_capture(old);
+
+    Capture &capture = captures[pgid];
+    capture.fd = pending_fds[0];
+    capture.limit = pending_limit;
+    pending_fds[0] = -1;
+    if (!event_loop_add_fd(capture.fd, EPOLLIN, [pgid](uint32_t) { drain(pgid); }))
+    {
+        close(capture.fd);
+        captures.erase(pgid);
+    }
+}
+
+void output_capture_abort()
+{
+    close_pending();
+}
+
+bool output_capture_contents(pid_t pgid, std::string &contents, uint64_t *dropped)
+{
+    auto it = captures.find(pgid);
+    if (it == captures.end())
+        return false;
+    drain(pgid); // data yang belum sempat dikuras
+    it = captures.find(pgid);
+    if (it == captures.end())
+        return false;
+
+    const Capture &capture = it->second;
+    contents.clear();
+    contents.reserve(capture.used);
+    size_t first = std::min(capture.used, capture.data.size() - capture.start);
+    contents.append(capture.data.data() + capture.start, first);
+    contents.append(capture.data.data(), capture.used - first);
+    if (dropped)
+        *dropped = capture.dropped;
+    return true;
+}
+
+void output_capture_follow(pid_t pgid, std::function<void(const char *, size_t)> callback)
+{
+    auto it = captures.find(pgid);
+    if (it != captures.end())
+        it->second.follower = std::move(callback);
+}
+
+bool output_capture_active(pid_t pgid)
+{
+    auto it = captures.find(pgid);
+    return it != captures.end() && it->second.fd >= 0;
+}
+
+void output_capture_release(pid_t pgid)
+{
+    auto it = captures.find(pgid);
+    if (it != captures.end())
+        free_capture(it);
+}
@@ -0,0 +1,317 @@
+#include "job_perf.h"
+#include "globals.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+namespace {
+
+struct PerfEventSpec {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr PerfEventSpec EVENT_SPECS[PERF_EVENT_COUNT] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+struct Counter {
+    int event;
+    int fd;
+};
+
+// Semua counter proses di satu process group (job)
+struct CountedGroup {
+    std::vector<Counter> counters;
+    bool hardware = false;
+};
+
+std::mutex perf_mutex; // jobs -l bisa membaca dari thread pipeline
+std::unordered_map<pid_t, CountedGroup> groups;
+int sync_pipe[2] = {-1, -1};
+bool atfork_registered = false;
+
+// Hasil probe pertama, berlaku untuk sisa umur shell
+bool hardware_unavailable = false;
+bool perf_unavailable = false;
+bool exclude_kernel = false;
+
+// Child hasil fork tidak memakai counter milik parent
+void reset_after_fork()
+{
+    for (auto &[pgid, group] : groups)
+    {
+        for (const Counter &counter : group.counters)
+            close(counter.fd);
+    }
+    groups.clear();
+}
+
+int open_counter(pid_t pid, int event)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = EVENT_SPECS[event].type;
+    attr.config = EVENT_SPECS[event].config;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.exclude_hv = 1;
+    attr.exclude_kernel = exclude_kernel;
+
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd == -1 && errno == EACCES && !exclude_kernel)
+    {
+        // perf_event_paranoid >= 2: hanya user space yang boleh dihitung
+        exclude_kernel = true;
+        attr.exclude_kernel = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+    if (fd >= 0 && fd < 10)
+    {
+        int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+        if (high_fd >= 0)
+        {
+            close(fd);
+            fd = high_fd;
+        }
+    }
+    return fd;
+}
+
+// Nilai counter, diskalakan jika counter sempat di-multiplex dengan event lain
+bool read_counter(int fd, uint64_t &value)
+{
+    uint64_t data[3]; // value, time_enabled, time_running
+    if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+        return false;
+    value = data[0];
+    if (data[2] != 0 && data[2] < data[1])
+        value = static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]);
+    return true;
+}
+
+void close_sync_pipe()
+{
+    for (int &fd : sync_pipe)
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace
+
+bool perf_counters_requested(const ParsedCommand &group)
+{
+    const char *value = nullptr;
+    if (!group.pipeline.empty())
+    {
+        auto it = group.pipeline[0].env_vars.find("NSH_PERF_COUNTERS");
+        if (it != group.pipeline[0].env_vars.end())
+            value = it->second.c_str();
+    }
+    if (!value)
+        value = get_env_var("NSH_PERF_COUNTERS");
+    return value && *value && strcmp(value, "0") != 0;
+}
+
+void perf_before_fork()
+{
+    close_sync_pipe();
+    if (perf_unavailable)
+        return;
+    if (pipe2(sync_pipe, O_CLOEXEC) != 0)
+        sync_pipe[0] = sync_pipe[1] = -1;
+}
+
+/**
+ * @brief Di child: tunggu sampai parent memasang counter ke proses ini.
+ *
+ * Dipanggil sebelum exec, jadi seluruh kerja program (dan turunannya,
+ * lewat inherit) tercakup counter. No-op jika job tidak dihitung.
+ */
+void perf_child_ready()
+{
+    if (sync_pipe[0] < 0)
+        return;
+    close(sync_pipe[1]);
+    char byte;
+    while (read(sync_pipe[0], &byte, 1) == -1 && errno == EINTR)
+        ;
+    close(sync_pipe[0]);
+    sync_pipe[0] = sync_pipe[1] = -1;
+}
+
+void perf_attach(pid_t pid, pid_t pgid)
+{
+    std::lock_guard<std::mutex> lock(perf_mutex);
+    if (!atfork_registered)
+    {
+        pthread_atfork(nullptr, nullptr, reset_after_fork);
+        atfork_registered = true;
+    }
+
+    CountedGroup &group = groups[pgid];
+    if (!perf_unavailable)
+    {
+        for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+        {
+            bool hardware = EVENT_SPECS[event].type == PERF_TYPE_HARDWARE;
+            if (hardware && hardware_unavailable)
+                continue;
+            int fd = open_counter(pid, event);
+            if (fd >= 0)
+            {
+                group.counters.push_back({event, fd});
+                group.hardware |= hardware;
+            }
+            else if (hardware && (errno == ENOENT || errno == EOPNOTSUPP || errno == ENODEV))
+            {
+                hardware_unavailable = true; // tanpa PMU: cukup counter software
+            }
+        }
+        // Tidak satu pun counter bisa dibuka: selanjutnya pakai rusage saja
+        if (group.counters.empty())
+            perf_unavailable = true;
+    }
+
+    // Lepaskan child (EOF juga cukup, tapi tulis eksplisit)
+    if (sync_pipe[1] >= 0)
+    {
+        char byte = 0;
+        while (write(sync_pipe[1], &byte, 1) == -1 && errno == EINTR)
+            ;
+    }
+    close_sync_pipe();
+}
+
+void perf_fork_failed()
+{
+    close_sync_pipe();
+}
+
+bool perf_is_counted(pid_t pgid)
+{
+    std::lock_guard<std::mutex> lock(perf_mutex);
+    return groups.count(pgid) != 0;
+}
+
+PerfTotals perf_finish(pid_t pgid, const struct rusage &usage)
+{
+    PerfTotals totals;
+    std::lock_guard<std::mutex> lock(perf_mutex);
+    auto it = groups.find(pgid);
+    if (it == groups.end())
+        return totals;
+    totals.counted = true;
+
+    CountedGroup &group = it->second;
+    for (const Counter &counter : group.counters)
+    {
+        uint64_t value;
+        if (read_counter(counter.fd, value))
+        {
+            totals.have[counter.event] = true;
+            totals.values[counter.event] += value;
+        }
+        close(counter.fd);
+    }
+
+    if (!group.counters.empty())
+    {
+        totals.source = group.hardware ? "hardware" : "software";
+    }
+    else
+    {
+        totals.have[PERF_TASK_CLOCK] = totals.have[PERF_PAGE_FAULTS] = totals.have[PERF_CONTEXT_SWITCHES] = true;
+        totals.values[PERF_TASK_CLOCK] =
+            (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+        totals.values[PERF_PAGE_FAULTS] = usage.ru_minflt + usage.ru_majflt;
+        totals.values[PERF_CONTEXT_SWITCHES] = usage.ru_nvcsw + usage.ru_nivcsw;
+    }
+    groups.erase(it);
+    return totals;
+}
+
+void perf_discard(pid_t pgid)
+{
+    std::lock_guard<std::mutex> lock(perf_mutex);
+    auto it = groups.find(pgid);
+    if (it == groups.end())
+        return;
+    for (const Counter &counter : it->second.counters)
+        close(counter.fd);
+    groups.erase(it);
+}
+
+const char *perf_event_name(int event)
+{
+    return EVENT_SPECS[event].name;
+}
+
+std::string perf_format(const PerfTotals &totals)
+{
+    std::ostringstream out;
+    out << "perf (" << totals.source << "):";
+    const char *separator = " ";
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+    {
+        if (!totals.have[event])
+            continue;
+        out << separator;
+        separator = ", ";
+        if (event == PERF_TASK_CLOCK)
+            out << std::fixed << std::setprecision(3) << totals.values[event] / 1e6 << " ms task-clock";
+        else
+            out << totals.values[event] << ' ' << EVENT_SPECS[event].name;
+        if (event == PERF_INSTRUCTIONS && totals.have[PERF_CYCLES] && totals.values[PERF_CYCLES] > 0)
+            out << std::fixed << std::setprecision(2) << " (IPC "
+                << static_cast<double>(totals.values[PERF_INSTRUCTIONS]) / totals.values[PERF_CYCLES] << ")";
+    }
+    return out.str();
+}
+
+std::string perf_ipc(pid_t pgid)
+{
+    std::lock_guard<std::mutex> lock(perf_mutex);
+    auto it = groups.find(pgid);
+    if (it == groups.end() || !it->second.hardware)
+        return "-";
+
+    uint64_t cycles = 0, instructions = 0, value;
+    for (const Counter &counter : it->second.counters)
+    {
+        if (!read_counter(counter.fd, value))
+            continue;
+        if (counter.event == PERF_CYCLES)
+            cycles += value;
+        else if (counter.event == PERF_INSTRUCTIONS)
+            instructions += value;
+    }
+    if (cycles == 0)
+        return "-";
+    char text[16];
+    snprintf(text, sizeof(text), "%.2f", static_cast<double>(instructions) / cycles);
+    return text;
+}
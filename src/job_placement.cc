@@ -0,0 +1,251 @@
+#include "job_placement.h"
+#include "globals.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+namespace {
+
+// Konstanta ioprio dari linux/ioprio.h (tidak diekspor glibc)
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+constexpr int IOPRIO_CLASS_RT = 1;
+constexpr int IOPRIO_CLASS_BE = 2;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_WHO_PROCESS = 1;
+
+int ioprio_value(int io_class, int level)
+{
+    return (io_class << IOPRIO_CLASS_SHIFT) | level;
+}
+
+// Variabel per command menang atas variabel shell
+const char *placement_setting(const SimpleCommand &cmd, const std::string &name)
+{
+    auto it = cmd.env_vars.find(name);
+    if (it != cmd.env_vars.end())
+        return it->second.c_str();
+    const char *value = get_env_var(name);
+    return (value && *value) ? value : nullptr;
+}
+
+bool parse_int(const std::string &text, long min, long max, int &out)
+{
+    if (text.empty())
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    long value = strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || value < min || value > max)
+        return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+// "4-15", "0,2,8-11"
+bool parse_cpu_list(const std::string &text, cpu_set_t &set)
+{
+    CPU_ZERO(&set);
+    size_t pos = 0;
+    while (pos <= text.size())
+    {
+        size_t comma = text.find(',', pos);
+        std::string part = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = part.find('-');
+        int first = 0, last = 0;
+        if (dash == std::string::npos)
+        {
+            if (!parse_int(part, 0, CPU_SETSIZE - 1, first))
+                return false;
+            last = first;
+        }
+        else if (!parse_int(part.substr(0, dash), 0, CPU_SETSIZE - 1, first) ||
+                 !parse_int(part.substr(dash + 1), 0, CPU_SETSIZE - 1, last) || last < first)
+        {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+            CPU_SET(cpu, &set);
+        if (comma == std::string::npos)
+            break;
+        pos = comma + 1;
+    }
+    return CPU_COUNT(&set) > 0;
+}
+
+std::string format_cpu_list(const cpu_set_t &set)
+{
+    std::string text;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &set))
+            continue;
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set))
+            last++;
+        if (!text.empty())
+            text += ',';
+        text += std::to_string(cpu);
+        if (last > cpu)
+            text += '-' + std::to_string(last);
+        cpu = last;
+    }
+    return text;
+}
+
+bool parse_sched(const std::string &text, int &policy, int &priority)
+{
+    std::string name = text.substr(0, text.find(':'));
+    std::string level = text.find(':') == std::string::npos ? "" : text.substr(text.find(':') + 1);
+    priority = 0;
+    if (name == "other" || name == "normal")
+        policy = SCHED_OTHER;
+    else if (name == "batch")
+        policy = SCHED_BATCH;
+    else if (name == "idle")
+        policy = SCHED_IDLE;
+    else if (name == "fifo" || name == "rr")
+    {
+        policy = (name == "fifo") ? SCHED_FIFO : SCHED_RR;
+        return parse_int(level, sched_get_priority_min(policy), sched_get_priority_max(policy), priority);
+    }
+    else
+        return false;
+    return level.empty();
+}
+
+bool parse_ioprio(const std::string &text, int &value)
+{
+    int level = 4;
+    if (parse_int(text, 0, 7, level))
+    {
+        value = ioprio_value(IOPRIO_CLASS_BE, level);
+        return true;
+    }
+    if (text == "idle")
+    {
+        value = ioprio_value(IOPRIO_CLASS_IDLE, 0);
+        return true;
+    }
+
+    std::string name = text.substr(0, text.find(':'));
+    std::string data = text.find(':') == std::string::npos ? "4" : text.substr(text.find(':') + 1);
+    if ((name != "be" && name != "rt") || !parse_int(data, 0, 7, level))
+        return false;
+    value = ioprio_value(name == "rt" ? IOPRIO_CLASS_RT : IOPRIO_CLASS_BE, level);
+    return true;
+}
+
+void report(const char *name, const char *value, const char *what)
+{
+    std::cerr << "nsh: " << name << ": " << what << " `" << value << "'" << std::endl;
+}
+
+} // namespace
+
+/**
+ * @brief Terapkan placement job background di child, tepat sebelum execve.
+ *
+ * Urutan: scheduling class dulu (SCHED_IDLE/BATCH mempertahankan nilai
+ * nice), lalu nice, affinity dan I/O priority. Kegagalan syscall (e.g.
+ * fifo tanpa CAP_SYS_NICE) dilaporkan, command tetap dijalankan.
+ */
+void placement_apply(const SimpleCommand &cmd)
+{
+    if (const char *value = placement_setting(cmd, "NSH_BG_SCHED"))
+    {
+        int policy, priority;
+        if (!parse_sched(value, policy, priority))
+        {
+            report("NSH_BG_SCHED", value, "invalid scheduling class");
+        }
+        else
+        {
+            struct sched_param param = {};
+            param.sched_priority = priority;
+            if (sched_setscheduler(0, policy, &param) != 0)
+                std::cerr << "nsh: NSH_BG_SCHED: " << strerror(errno) << std::endl;
+        }
+    }
+
+    if (const char *value = placement_setting(cmd, "NSH_BG_NICE"))
+    {
+        int nice_value;
+        if (!parse_int(value, -20, 19, nice_value))
+            report("NSH_BG_NICE", value, "invalid nice value");
+        else if (setpriority(PRIO_PROCESS, 0, nice_value) != 0)
+            std::cerr << "nsh: NSH_BG_NICE: " << strerror(errno) << std::endl;
+    }
+
+    if (const char *value = placement_setting(cmd, "NSH_BG_CPUS"))
+    {
+        cpu_set_t set;
+        if (!parse_cpu_list(value, set))
+            report("NSH_BG_CPUS", value, "invalid CPU list");
+        else if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            std::cerr << "nsh: NSH_BG_CPUS: " << strerror(errno) << std::endl;
+    }
+
+    if (const char *value = placement_setting(cmd, "NSH_BG_IOPRIO"))
+    {
+        int ioprio;
+        if (!parse_ioprio(value, ioprio))
+            report("NSH_BG_IOPRIO", value, "invalid I/O priority");
+        else if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, ioprio) != 0)
+            std::cerr << "nsh: NSH_BG_IOPRIO: " << strerror(errno) << std::endl;
+    }
+}
+
+std::string placement_describe(pid_t pid)
+{
+    if (pid <= 0)
+        return "-";
+
+    std::string text;
+    auto add = [&text](const std::string &part) {
+        if (!text.empty())
+            text += ' ';
+        text += part;
+    };
+
+    // Hanya yang berbeda dari shell itu sendiri yang ditampilkan
+    cpu_set_t set, shell_set;
+    if (sched_getaffinity(pid, sizeof(set), &set) == 0 &&
+        sched_getaffinity(0, sizeof(shell_set), &shell_set) == 0 && !CPU_EQUAL(&set, &shell_set))
+        add("cpus=" + format_cpu_list(set));
+
+    errno = 0;
+    int nice_value = getpriority(PRIO_PROCESS, pid);
+    if (errno == 0 && nice_value != getpriority(PRIO_PROCESS, 0))
+        add("nice=" + std::to_string(nice_value));
+
+    int policy = sched_getscheduler(pid);
+    struct sched_param param = {};
+    if (policy == SCHED_BATCH)
+        add("batch");
+    else if (policy == SCHED_IDLE)
+        add("idle");
+    else if ((policy == SCHED_FIFO || policy == SCHED_RR) && sched_getparam(pid, &param) == 0)
+        add((policy == SCHED_FIFO ? "fifo:" : "rr:") + std::to_string(param.sched_priority));
+
+    long ioprio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, pid);
+    if (ioprio > 0 && ioprio != syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0))
+    {
+        int io_class = static_cast<int>(ioprio >> IOPRIO_CLASS_SHIFT);
+        int level = static_cast<int>(ioprio & ((1 << IOPRIO_CLASS_SHIFT) - 1));
+        if (io_class == IOPRIO_CLASS_IDLE)
+            add("io=idle");
+        else if (io_class == IOPRIO_CLASS_RT)
+            add("io=rt:" + std::to_string(level));
+        else if (io_class == IOPRIO_CLASS_BE)
+            add("io=be:" + std::to_string(level));
+    }
+
+    return text.empty() ? "-" : text;
+}
@@ -0,0 +1,647 @@
+#include "job_registry.h"
+#include "events.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr uint32_t REGISTRY_MAGIC = 0x4e534852; // "NSHR"
+constexpr uint32_t REGISTRY_VERSION = 2;
+constexpr uint32_t SESSION_SLOTS = 256;
+constexpr uint32_t JOB_SLOTS = 1024;
+constexpr size_t COMMAND_MAX = 256;
+constexpr int REGISTRY_MIN_FD = 10;
+// Nama file ikut versi layout: shell dengan layout lain memakai file
+// sendiri dan tidak pernah memotong mapping milik shell yang masih hidup
+constexpr const char *REGISTRY_FILE = "registry-v2.map";
+
+struct RegistryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t session_slots;
+    uint32_t job_slots;
+    std::atomic<uint64_t> generation; // naik setiap registry_notify
+};
+
+struct SessionData {
+    pid_t pid;
+    int64_t start_sec;
+};
+
+struct JobData {
+    pid_t owner_pid;
+    uint32_t owner_session;
+    pid_t pgid;            // 0: slot kosong
+    int32_t job_id;
+    int32_t status;
+    int32_t term_status;
+    int64_t utime_usec;
+    int64_t stime_usec;
+    int64_t start_sec;
+    int64_t start_usec;
+    char command[COMMAND_MAX];
+};
+
+// seq ganjil: slot sedang ditulis pemiliknya
+struct SessionSlot {
+    std::atomic<uint32_t> seq;
+    SessionData data;
+};
+
+struct JobSlot {
+    std::atomic<uint32_t> seq;
+    JobData data;
+};
+
+struct RegistryLayout {
+    RegistryHeader header;
+    SessionSlot sessions[SESSION_SLOTS];
+    JobSlot jobs[JOB_SLOTS];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "seqlock di shared memory butuh atomic lock-free");
+
+int registry_fd = -1;
+std::string registry_file;  // path untuk dibuka ulang oleh child hasil fork
+bool atfork_registered = false;
+RegistryLayout *registry = nullptr;
+pid_t registry_owner = 0;   // shell yang membuka registry; child hasil fork tidak menulis
+int my_session = -1;
+uint32_t free_job_hint = 0;
+std::unordered_map<pid_t, uint32_t> my_job_slots; // pgid -> index slot
+bool notify_pending = false;
+
+// inotify pada direktori registry. Tulisan lewat mmap tidak memicu inotify,
+// jadi penulis menyentuh timestamp file registry (registry_notify) dan
+// watcher di sini cukup menandai snapshot job session lain sebagai basi.
+// Shell juga menerima IN_ATTRIB dari futimens-nya sendiri; generation yang
+// sudah terlihat membedakannya dari perubahan session lain.
+int watch_fd = -1;
+bool foreign_changed = true;
+uint64_t seen_generation = 0;
+std::vector<RegistryJob> foreign_cache;
+std::vector<RegistryJob> foreign_finished;
+
+bool usable()
+{
+    return registry && getpid() == registry_owner;
+}
+
+template <typename Slot, typename Fill>
+void seq_write(Slot &slot, Fill fill)
+{
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    if (seq & 1)
+        seq++; // penulis sebelumnya mati di tengah update
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    fill(slot.data);
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+template <typename Slot, typename Data>
+bool seq_read(const Slot &slot, Data &out)
+{
+    for (int attempt = 0; attempt < 64; ++attempt)
+    {
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            sched_yield();
+            continue;
+        }
+        memcpy(&out, &slot.data, sizeof(Data));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
+
+struct flock session_lock_range(uint32_t index)
+{
+    struct flock fl = {};
+    fl.l_whence = SEEK_SET;
+    fl.l_start = offsetof(RegistryLayout, sessions) + index * sizeof(SessionSlot);
+    fl.l_len = 1;
+    return fl;
+}
+
+// Masih ada session yang memegang slot (dan mungkin me-mmap file ini)
+bool any_session_locked()
+{
+    struct flock fl = session_lock_range(0);
+    fl.l_len = SESSION_SLOTS * sizeof(SessionSlot);
+    fl.l_type = F_WRLCK;
+    if (fcntl(registry_fd, F_OFD_GETLK, &fl) != 0)
+        return true;
+    return fl.l_type != F_UNLCK;
+}
+
+bool lock_session_slot(uint32_t index)
+{
+    struct flock fl = session_lock_range(index);
+    fl.l_type = F_WRLCK;
+    return fcntl(registry_fd, F_OFD_SETLK, &fl) == 0;
+}
+
+// Session hidup selama OFD lock pada slot-nya masih dipegang
+bool session_slot_alive(uint32_t index)
+{
+    if (static_cast<int>(index) == my_session)
+        return true;
+    if (index >= SESSION_SLOTS)
+        return false;
+    struct flock fl = session_lock_range(index);
+    fl.l_type = F_WRLCK;
+    if (fcntl(registry_fd, F_OFD_GETLK, &fl) != 0)
+        return false;
+    return fl.l_type != F_UNLCK;
+}
+
+bool job_owner_alive(const JobData &job)
+{
+    if (!session_slot_alive(job.owner_session))
+        return false;
+    SessionData session;
+    return seq_read(registry->sessions[job.owner_session], session) && session.pid == job.owner_pid;
+}
+
+bool process_group_gone(pid_t pgid)
+{
+    return kill(-pgid, 0) == -1 && errno == ESRCH;
+}
+
+void clear_job_slot(uint32_t index)
+{
+    seq_write(registry->jobs[index], [](JobData &data) { memset(&data, 0, sizeof(data)); });
+}
+
+// Dipanggil dengan flock dipegang
+bool job_slot_reusable(uint32_t index)
+{
+    JobData job;
+    if (!seq_read(registry->jobs[index], job))
+        return !job_owner_alive(registry->jobs[index].data);
+    if (job.pgid == 0)
+        return true;
+    return !job_owner_alive(job) && process_group_gone(job.pgid);
+}
+
+uint32_t claim_job_slot(pid_t pgid)
+{
+    flock(registry_fd, LOCK_EX);
+    uint32_t found = JOB_SLOTS;
+    for (uint32_t n = 0; n < JOB_SLOTS; ++n)
+    {
+        uint32_t index = (free_job_hint + n) % JOB_SLOTS;
+        if (job_slot_reusable(index))
+        {
+            found = index;
+            break;
+        }
+    }
+    if (found != JOB_SLOTS)
+    {
+        seq_write(registry->jobs[found], [&](JobData &data) {
+            memset(&data, 0, sizeof(data));
+            data.owner_pid = registry_owner;
+            data.owner_session = static_cast<uint32_t>(my_session);
+            data.pgid = pgid;
+        });
+        free_job_hint = (found + 1) % JOB_SLOTS;
+    }
+    flock(registry_fd, LOCK_UN);
+    return found;
+}
+
+// Child hasil fork tanpa exec (subshell, producer <(cmd)) berbagi open file
+// description dengan shell lewat fd dan mmap, jadi ikut memegang OFD lock
+// session: slot shell yang sudah mati masih terlihat hidup selama child
+// berjalan. Child memakai open baru tanpa lock, dipetakan di alamat yang
+// sama (MAP_FIXED), sehingga tetap bisa membaca registry.
+void reset_after_fork()
+{
+    if (registry_fd < 0)
+        return;
+    int fd = open(registry_file.c_str(), O_RDWR | O_CLOEXEC);
+    bool remapped = fd >= 0 && registry &&
+                    mmap(registry, sizeof(RegistryLayout), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) !=
+                        MAP_FAILED;
+    if (!remapped || dup3(fd, registry_fd, O_CLOEXEC) < 0)
+    {
+        if (registry)
+            munmap(registry, sizeof(RegistryLayout));
+        registry = nullptr;
+        close(registry_fd);
+        registry_fd = -1;
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+// Tandai perubahan lalu sentuh timestamp untuk watcher session lain. Jika
+// tidak ada session lain yang menulis sejak snapshot terakhir, generation
+// baru ini milik shell ini sendiri dan tidak memicu scan ulang.
+void bump_generation()
+{
+    uint64_t generation = registry->header.generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if (generation == seen_generation + 1)
+        seen_generation = generation;
+    futimens(registry_fd, nullptr);
+}
+
+void unmap_registry()
+{
+    if (registry)
+        munmap(registry, sizeof(RegistryLayout));
+    if (registry_fd >= 0)
+        close(registry_fd); // melepas OFD lock session
+    registry = nullptr;
+    registry_fd = -1;
+    my_session = -1;
+    my_job_slots.clear();
+}
+
+void unwatch_registry()
+{
+    if (watch_fd < 0)
+        return;
+    event_loop_remove_fd(watch_fd);
+    close(watch_fd);
+    watch_fd = -1;
+}
+
+bool job_finished(JobStatus status)
+{
+    return status != JobStatus::RUNNING && status != JobStatus::STOPPED;
+}
+
+// Baca ulang slot job hanya jika ada perubahan. Tanpa watcher
+// (inotify gagal, atau child hasil fork) selalu baca ulang.
+void refresh_foreign_jobs()
+{
+    if (!foreign_changed && watch_fd >= 0 && getpid() == registry_owner)
+        return;
+    foreign_changed = false;
+    if (registry)
+        seen_generation = registry->header.generation.load(std::memory_order_acquire);
+
+    std::vector<RegistryJob> fresh = registry_foreign_jobs();
+    std::unordered_map<pid_t, const RegistryJob *> by_pgid;
+    for (const RegistryJob &job : fresh)
+        by_pgid[job.pgid] = &job;
+
+    // Job yang tadinya berjalan lalu hilang dari registry sudah selesai
+    for (const RegistryJob &old : foreign_cache)
+    {
+        if (job_finished(old.status))
+            continue;
+        auto it = by_pgid.find(old.pgid);
+        if (it == by_pgid.end())
+        {
+            RegistryJob done = old;
+            done.status = JobStatus::DONE;
+            done.term_status = 0;
+            foreign_finished.push_back(std::move(done));
+        }
+        else if (job_finished(it->second->status))
+        {
+            foreign_finished.push_back(*it->second);
+        }
+    }
+    foreign_cache = std::move(fresh);
+
+    // Shell non-interaktif tidak pernah mengambil laporan ini
+    if (foreign_finished.size() > JOB_SLOTS)
+        foreign_finished.erase(foreign_finished.begin(), foreign_finished.end() - JOB_SLOTS);
+}
+
+void on_registry_event(uint32_t)
+{
+    alignas(struct inotify_event) char buf[4096];
+    ssize_t n;
+    while ((n = read(watch_fd, buf, sizeof(buf))) > 0)
+    {
+        for (char *p = buf; p < buf + n;)
+        {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len && strcmp(event->name, REGISTRY_FILE) == 0))
+                foreign_changed = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    // Hanya sentuhan shell ini sendiri: tidak ada yang perlu dibaca ulang
+    if (foreign_changed && registry &&
+        registry->header.generation.load(std::memory_order_acquire) == seen_generation)
+        foreign_changed = false;
+    // Scan langsung di sini (bukan di prompt): job yang mulai dan selesai
+    // di antara dua prompt tetap terlihat selesai
+    refresh_foreign_jobs();
+}
+
+void watch_registry()
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return;
+    watch_fd = fcntl(fd, F_DUPFD_CLOEXEC, REGISTRY_MIN_FD);
+    close(fd);
+    if (watch_fd < 0)
+        return;
+
+    std::string dir = (ns_CONFIG_DIR / "jobs").string();
+    uint32_t mask = IN_ATTRIB | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO;
+    if (inotify_add_watch(watch_fd, dir.c_str(), mask) < 0 ||
+        !event_loop_add_fd(watch_fd, EPOLLIN, on_registry_event))
+    {
+        close(watch_fd);
+        watch_fd = -1;
+        return;
+    }
+    refresh_foreign_jobs(); // snapshot awal sebagai pembanding
+}
+
+} // namespace
+
+std::string registry_path()
+{
+    return (ns_CONFIG_DIR / "jobs" / REGISTRY_FILE).string();
+}
+
+int registry_open()
+{
+    if (registry)
+        return 0;
+
+    std::error_code ec;
+    fs::create_directories(ns_CONFIG_DIR / "jobs", ec);
+
+    if (!atfork_registered)
+    {
+        pthread_atfork(nullptr, nullptr, reset_after_fork);
+        atfork_registered = true;
+    }
+
+    registry_file = registry_path();
+    int fd = open(registry_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return 0;
+    registry_fd = fcntl(fd, F_DUPFD_CLOEXEC, REGISTRY_MIN_FD);
+    close(fd);
+    if (registry_fd < 0)
+        return 0;
+
+    flock(registry_fd, LOCK_EX);
+
+    // File dengan ukuran atau header lain hanya diinisialisasi ulang jika
+    // tidak ada session hidup: memotong file yang di-mmap shell lain
+    // membuat shell itu SIGBUS. Selama masih dipakai, registry dimatikan.
+    struct stat st;
+    bool fresh = fstat(registry_fd, &st) != 0 || st.st_size != static_cast<off_t>(sizeof(RegistryLayout));
+    if (fresh && (any_session_locked() || ftruncate(registry_fd, 0) != 0 ||
+                  ftruncate(registry_fd, sizeof(RegistryLayout)) != 0))
+    {
+        flock(registry_fd, LOCK_UN);
+        unmap_registry();
+        return 0;
+    }
+
+    void *map = mmap(nullptr, sizeof(RegistryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, registry_fd, 0);
+    if (map == MAP_FAILED)
+    {
+        flock(registry_fd, LOCK_UN);
+        unmap_registry();
+        return 0;
+    }
+    registry = static_cast<RegistryLayout *>(map);
+    registry_owner = getpid();
+
+    RegistryHeader &header = registry->header;
+    if (fresh || header.magic != REGISTRY_MAGIC || header.version != REGISTRY_VERSION ||
+        header.session_slots != SESSION_SLOTS || header.job_slots != JOB_SLOTS)
+    {
+        if (!fresh && any_session_locked())
+        {
+            flock(registry_fd, LOCK_UN);
+            unmap_registry();
+            return 0;
+        }
+        memset(static_cast<void *>(registry), 0, sizeof(RegistryLayout));
+        header.magic = REGISTRY_MAGIC;
+        header.version = REGISTRY_VERSION;
+        header.session_slots = SESSION_SLOTS;
+        header.job_slots = JOB_SLOTS;
+    }
+
+    int live_sessions = 0;
+    for (uint32_t i = 0; i < SESSION_SLOTS; ++i)
+    {
+        SessionData session;
+        bool readable = seq_read(registry->sessions[i], session);
+        bool occupied = readable ? session.pid != 0 : true;
+        if (occupied && session_slot_alive(i))
+        {
+            live_sessions++;
+            continue;
+        }
+        if (my_session < 0 && lock_session_slot(i))
+        {
+            my_session = static_cast<int>(i);
+            seq_write(registry->sessions[i], [](SessionData &data) {
+                data.pid = getpid();
+                data.start_sec = time(nullptr);
+            });
+            live_sessions++;
+        }
+    }
+
+    flock(registry_fd, LOCK_UN);
+
+    if (my_session < 0)
+    {
+        unmap_registry();
+        return 0;
+    }
+    watch_registry();
+    return live_sessions;
+}
+
+void registry_close()
+{
+    if (!usable())
+        return;
+
+    // Slot job yang masih berjalan dibiarkan: session lain tetap bisa
+    // melihatnya sampai process group-nya hilang (registry_reap_stale)
+    for (const auto &[pgid, index] : my_job_slots)
+    {
+        if (process_group_gone(pgid))
+            clear_job_slot(index);
+    }
+    seq_write(registry->sessions[my_session], [](SessionData &data) { memset(&data, 0, sizeof(data)); });
+    bump_generation();
+    unwatch_registry();
+    unmap_registry();
+}
+
+void registry_publish_job(int job_id, const Job &job)
+{
+    if (!usable())
+        return;
+
+    uint32_t index;
+    auto it = my_job_slots.find(job.pgid);
+    if (it != my_job_slots.end())
+    {
+        index = it->second;
+    }
+    else
+    {
+        index = claim_job_slot(job.pgid);
+        if (index == JOB_SLOTS)
+            return; // registry penuh: job tetap ada di session ini saja
+        my_job_slots[job.pgid] = index;
+    }
+
+    seq_write(registry->jobs[index], [&](JobData &data) {
+        data.owner_pid = registry_owner;
+        data.owner_session = static_cast<uint32_t>(my_session);
+        data.pgid = job.pgid;
+        data.job_id = job_id;
+        data.status = static_cast<int32_t>(job.status);
+        data.term_status = job.term_status;
+        data.utime_usec = job.usage.ru_utime.tv_sec * 1000000LL + job.usage.ru_utime.tv_usec;
+        data.stime_usec = job.usage.ru_stime.tv_sec * 1000000LL + job.usage.ru_stime.tv_usec;
+        data.start_sec = job.start_tv.tv_sec;
+        data.start_usec = job.start_tv.tv_usec;
+        size_t len = std::min(job.command.size(), COMMAND_MAX - 1);
+        memcpy(data.command, job.command.data(), len);
+        data.command[len] = '\0';
+    });
+    notify_pending = true;
+}
+
+void registry_remove_job(pid_t pgid)
+{
+    if (!usable())
+        return;
+    auto it = my_job_slots.find(pgid);
+    if (it == my_job_slots.end())
+        return;
+    clear_job_slot(it->second);
+    my_job_slots.erase(it);
+    notify_pending = true;
+}
+
+void registry_notify()
+{
+    if (!usable() || !notify_pending)
+        return;
+    notify_pending = false;
+    bump_generation();
+}
+
+std::vector<RegistryJob> registry_foreign_jobs()
+{
+    std::vector<RegistryJob> result;
+    if (!registry)
+        return result;
+
+    std::unordered_map<pid_t, bool> alive_cache;
+    for (uint32_t i = 0; i < JOB_SLOTS; ++i)
+    {
+        const JobSlot &slot = registry->jobs[i];
+        // Cek murah tanpa seqlock dulu: sebagian besar slot kosong
+        if (slot.data.pgid == 0)
+            continue;
+
+        JobData job;
+        if (!seq_read(slot, job) || job.pgid == 0 || job.owner_pid == getpid())
+            continue;
+
+        auto cached = alive_cache.find(job.owner_pid);
+        bool alive;
+        if (cached != alive_cache.end())
+        {
+            alive = cached->second;
+        }
+        else
+        {
+            alive = job_owner_alive(job);
+            alive_cache[job.owner_pid] = alive;
+        }
+
+        RegistryJob entry = {};
+        entry.owner_pid = job.owner_pid;
+        entry.pgid = job.pgid;
+        entry.job_id = job.job_id;
+        entry.status = static_cast<JobStatus>(job.status);
+        entry.term_status = job.term_status;
+        entry.usage.ru_utime.tv_sec = job.utime_usec / 1000000;
+        entry.usage.ru_utime.tv_usec = job.utime_usec % 1000000;
+        entry.usage.ru_stime.tv_sec = job.stime_usec / 1000000;
+        entry.usage.ru_stime.tv_usec = job.stime_usec % 1000000;
+        entry.start_tv.tv_sec = job.start_sec;
+        entry.start_tv.tv_usec = job.start_usec;
+        job.command[COMMAND_MAX - 1] = '\0';
+        entry.command = job.command;
+        entry.owner_alive = alive;
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+void registry_reap_stale()
+{
+    if (!usable())
+        return;
+
+    flock(registry_fd, LOCK_EX);
+    for (uint32_t i = 0; i < JOB_SLOTS; ++i)
+    {
+        if (registry->jobs[i].data.pgid != 0 && job_slot_reusable(i))
+        {
+            clear_job_slot(i);
+            notify_pending = true;
+        }
+    }
+    for (uint32_t i = 0; i < SESSION_SLOTS; ++i)
+    {
+        if (registry->sessions[i].data.pid != 0 && !session_slot_alive(i))
+            seq_write(registry->sessions[i], [](SessionData &data) { memset(&data, 0, sizeof(data)); });
+    }
+    flock(registry_fd, LOCK_UN);
+    registry_notify();
+}
+
+const std::vector<RegistryJob> &registry_foreign_jobs_cached()
+{
+    refresh_foreign_jobs();
+    return foreign_cache;
+}
+
+std::vector<RegistryJob> registry_take_foreign_finished()
+{
+    refresh_foreign_jobs();
+    std::vector<RegistryJob> finished;
+    finished.swap(foreign_finished);
+    return finished;
+}
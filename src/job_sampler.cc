@@ -0,0 +1,329 @@
+#include "job_sampler.h"
+#include "events.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Anggota group dicari ulang setiap sekian sample (proses baru dari
+// make/xargs), sample di antaranya cukup pread fd yang sudah terbuka
+constexpr unsigned DISCOVERY_EVERY = 5;
+constexpr size_t PROC_BUFFER = 1024;
+
+struct ProcessState {
+    int stat_fd = -1;      // -1: fd tidak disimpan (EMFILE), buka per sample
+    int io_fd = -1;
+    bool io_readable = true;
+    bool primed = false;   // sudah punya nilai sample sebelumnya
+    uint64_t ticks = 0;
+    uint64_t rchar = 0;
+    uint64_t wchar = 0;
+};
+
+struct GroupState {
+    std::unordered_map<pid_t, ProcessState> processes;
+};
+
+std::unordered_map<pid_t, GroupState> groups;
+struct timespec last_sample = {};
+unsigned sample_count = 0;
+
+int open_proc(pid_t pid, const char *name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/%s", static_cast<int>(pid), name);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && fd < 10)
+    {
+        int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+        if (high_fd >= 0)
+        {
+            close(fd);
+            fd = high_fd;
+        }
+    }
+    return fd;
+}
+
+// Baca file /proc lewat fd yang disimpan, atau buka-baca-tutup jika
+// fd tidak bisa disimpan (batas RLIMIT_NOFILE)
+bool read_proc(int fd, pid_t pid, const char *name, char *buffer)
+{
+    ssize_t n;
+    if (fd >= 0)
+    {
+        n = pread(fd, buffer, PROC_BUFFER - 1, 0);
+    }
+    else
+    {
+        int temp_fd = open_proc(pid, name);
+        if (temp_fd < 0)
+            return false;
+        n = read(temp_fd, buffer, PROC_BUFFER - 1);
+        close(temp_fd);
+    }
+    if (n <= 0)
+        return false;
+    buffer[n] = '\0';
+    return true;
+}
+
+struct StatFields {
+    pid_t pgrp = 0;
+    uint64_t ticks = 0;  // utime + stime
+    long threads = 0;
+    long rss_pages = 0;
+};
+
+// /proc/<pid>/stat: nama command (field 2) bisa berisi spasi, hitung field
+// dari ')' terakhir
+bool parse_stat(const char *text, StatFields &fields)
+{
+    const char *p = strrchr(text, ')');
+    if (!p)
+        return false;
+    p++;
+    for (int field = 3; field <= 24 && *p; ++field)
+    {
+        while (*p == ' ')
+            p++;
+        char *end;
+        if (field == 5)
+            fields.pgrp = static_cast<pid_t>(strtol(p, &end, 10));
+        else if (field == 14 || field == 15)
+            fields.ticks += strtoull(p, &end, 10);
+        else if (field == 20)
+            fields.threads = strtol(p, &end, 10);
+        else if (field == 24)
+            fields.rss_pages = strtol(p, &end, 10);
+        while (*p && *p != ' ')
+            p++;
+    }
+    return fields.pgrp != 0;
+}
+
+void parse_io(const char *text, uint64_t &rchar, uint64_t &wchar)
+{
+    const char *r = strstr(text, "rchar: ");
+    const char *w = strstr(text, "wchar: ");
+    rchar = r ? strtoull(r + 7, nullptr, 10) : 0;
+    wchar = w ? strtoull(w + 7, nullptr, 10) : 0;
+}
+
+void close_process(ProcessState &process)
+{
+    if (process.stat_fd >= 0)
+        close(process.stat_fd);
+    if (process.io_fd >= 0)
+        close(process.io_fd);
+    process.stat_fd = process.io_fd = -1;
+}
+
+void add_process(GroupState &group, pid_t pgid, pid_t pid)
+{
+    char buffer[PROC_BUFFER];
+    StatFields fields;
+    int stat_fd = open_proc(pid, "stat");
+    if (stat_fd < 0 && errno != EMFILE && errno != ENFILE)
+        return; // sudah exit
+    if (!read_proc(stat_fd, pid, "stat", buffer) || !parse_stat(buffer, fields) || fields.pgrp != pgid)
+    {
+        if (stat_fd >= 0)
+            close(stat_fd);
+        return;
+    }
+
+    ProcessState &process = group.processes[pid];
+    process.stat_fd = stat_fd;
+    if (stat_fd >= 0)
+        process.io_fd = open_proc(pid, "io");
+}
+
+// Cari anggota group: proses yang dicatat event loop, pemimpin group, lalu
+// turunannya lewat /proc/<pid>/task/<pid>/children
+void discover(GroupState &group, pid_t pgid)
+{
+    std::vector<pid_t> pending = event_loop_group_pids(pgid);
+    pending.push_back(pgid);
+    for (const auto &[pid, process] : group.processes)
+        pending.push_back(pid);
+
+    std::unordered_set<pid_t> visited;
+    char path[64];
+    char buffer[PROC_BUFFER];
+    while (!pending.empty())
+    {
+        pid_t pid = pending.back();
+        pending.pop_back();
+        if (!visited.insert(pid).second)
+            continue;
+        if (group.processes.find(pid) == group.processes.end())
+            add_process(group, pgid, pid);
+
+        snprintf(path, sizeof(path), "/proc/%d/task/%d/children", static_cast<int>(pid), static_cast<int>(pid));
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (n <= 0)
+            continue;
+        buffer[n] = '\0';
+        for (char *p = buffer; *p;)
+        {
+            char *end;
+            long child = strtol(p, &end, 10);
+            if (end == p)
+                break;
+            pending.push_back(static_cast<pid_t>(child));
+            p = end;
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Satu sample semua job: CPU%, thread, RSS dan throughput I/O per job.
+ *
+ * Proses yang sudah exit atau pindah group dibuang (fd ditutup). Rate
+ * dihitung dari selisih terhadap sample sebelumnya; sample pertama hanya
+ * mengisi nilai awal.
+ */
+std::vector<JobSample> sampler_sample(const std::vector<pid_t> &pgids)
+{
+    static const long clock_ticks = sysconf(_SC_CLK_TCK);
+    static const long page_size = sysconf(_SC_PAGESIZE);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = sample_count == 0 ? 0.0
+                                       : (now.tv_sec - last_sample.tv_sec) + (now.tv_nsec - last_sample.tv_nsec) / 1e9;
+    bool rediscover = sample_count % DISCOVERY_EVERY == 0;
+    last_sample = now;
+    sample_count++;
+
+    // Job yang sudah tidak ditampilkan
+    std::unordered_set<pid_t> wanted(pgids.begin(), pgids.end());
+    for (auto it = groups.begin(); it != groups.end();)
+    {
+        if (wanted.count(it->first))
+        {
+            ++it;
+            continue;
+        }
+        for (auto &[pid, process] : it->second.processes)
+            close_process(process);
+        it = groups.erase(it);
+    }
+
+    std::vector<JobSample> samples;
+    char buffer[PROC_BUFFER];
+    for (pid_t pgid : pgids)
+    {
+        JobSample sample;
+        sample.pgid = pgid;
+        auto [git, inserted] = groups.try_emplace(pgid);
+        GroupState &group = git->second;
+        if (rediscover || inserted)
+            discover(group, pgid);
+
+        uint64_t cpu_ticks = 0, read_bytes = 0, write_bytes = 0;
+        for (auto it = group.processes.begin(); it != group.processes.end();)
+        {
+            pid_t pid = it->first;
+            ProcessState &process = it->second;
+            StatFields fields;
+            if (!read_proc(process.stat_fd, pid, "stat", buffer) || !parse_stat(buffer, fields) || fields.pgrp != pgid)
+            {
+                close_process(process);
+                it = group.processes.erase(it);
+                continue;
+            }
+
+            uint64_t rchar = 0, wchar = 0;
+            bool have_io = process.io_readable && read_proc(process.io_fd, pid, "io", buffer);
+            if (have_io)
+                parse_io(buffer, rchar, wchar);
+            else
+                process.io_readable = false; // /proc/<pid>/io butuh izin ptrace
+
+            if (process.primed)
+            {
+                cpu_ticks += fields.ticks - process.ticks;
+                if (have_io)
+                {
+                    read_bytes += rchar - process.rchar;
+                    write_bytes += wchar - process.wchar;
+                }
+            }
+            process.primed = true;
+            process.ticks = fields.ticks;
+            process.rchar = rchar;
+            process.wchar = wchar;
+
+            sample.processes++;
+            sample.threads += fields.threads;
+            sample.rss_bytes += static_cast<uint64_t>(fields.rss_pages) * page_size;
+            sample.io_available |= have_io;
+            ++it;
+        }
+
+        if (elapsed > 0)
+        {
+            sample.cpu_percent = cpu_ticks * 100.0 / clock_ticks / elapsed;
+            sample.read_rate = read_bytes / elapsed;
+            sample.write_rate = write_bytes / elapsed;
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+/**
+ * @brief CPU time dan peak RSS proses yang masih berjalan, dari
+ *        /proc/<pid>/stat dan VmHWM di /proc/<pid>/status.
+ *
+ * Hanya ru_utime/ru_stime (gabungan, di ru_utime) dan ru_maxrss (KB) yang
+ * diisi; false jika proses sudah tidak ada.
+ */
+bool sampler_process_usage(pid_t pid, struct rusage &usage)
+{
+    static const long clock_ticks = sysconf(_SC_CLK_TCK);
+    char buffer[PROC_BUFFER];
+    StatFields fields;
+    if (!read_proc(-1, pid, "stat", buffer) || !parse_stat(buffer, fields))
+        return false;
+
+    usage = {};
+    usage.ru_utime.tv_sec = static_cast<time_t>(fields.ticks / clock_ticks);
+    usage.ru_utime.tv_usec = static_cast<suseconds_t>(fields.ticks % clock_ticks * 1000000 / clock_ticks);
+
+    // /proc/<pid>/status lebih dari PROC_BUFFER, VmHWM ada di awal
+    if (read_proc(-1, pid, "status", buffer))
+    {
+        const char *hwm = strstr(buffer, "VmHWM:");
+        if (hwm)
+            usage.ru_maxrss = strtol(hwm + 6, nullptr, 10);
+    }
+    return true;
+}
+
+void sampler_reset()
+{
+    for (auto &[pgid, group] : groups)
+    {
+        for (auto &[pid, process] : group.processes)
+            close_process(process);
+    }
+    groups.clear();
+    sample_count = 0;
+}
@@ -0,0 +1,304 @@
+#include "job_scheduler.h"
+#include "execution.h"
+#include "events.h"
+#include "globals.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <pthread.h>
+
+namespace {
+
+constexpr const char *DEFAULT_QUEUE = "default";
+
+// (-prioritas, urutan masuk): begin() selalu job berikutnya di antrian itu
+using QueueKey = std::pair<int, uint64_t>;
+
+struct PendingJob {
+    int job_id;
+    ParsedCommand group;
+    bool use_env;
+    std::string command;
+    int priority;
+};
+
+struct QueueState {
+    std::map<QueueKey, PendingJob> pending;
+    size_t running = 0;
+};
+
+struct TrackedJob {
+    std::string queue;
+    bool running;
+};
+
+std::map<std::string, QueueState> queues;
+std::unordered_map<int, std::pair<std::string, QueueKey>> queued_index; // job id -> posisi
+std::unordered_map<pid_t, TrackedJob> tracked;                          // pgid -> job background
+size_t running_total = 0;
+uint64_t next_seq = 0;
+int launching_job_id = 0;
+bool dispatching = false;
+bool atfork_registered = false;
+
+// Child hasil fork (subshell) tidak boleh ikut menjalankan antrian parent
+void reset_after_fork()
+{
+    queues.clear();
+    queued_index.clear();
+    tracked.clear();
+    running_total = 0;
+    launching_job_id = 0;
+    dispatching = false;
+}
+
+// Variabel per command (`NSH_BG_QUEUE=io cmd &`) menang atas variabel shell
+const char *job_setting(const ParsedCommand &group, const std::string &name)
+{
+    if (!group.pipeline.empty())
+    {
+        const auto &env = group.pipeline[0].env_vars;
+        auto it = env.find(name);
+        if (it != env.end())
+            return it->second.c_str();
+    }
+    return get_env_var(name);
+}
+
+std::string queue_name(const ParsedCommand &group)
+{
+    const char *value = job_setting(group, "NSH_BG_QUEUE");
+    return (value && *value) ? value : DEFAULT_QUEUE;
+}
+
+int job_priority(const ParsedCommand &group)
+{
+    const char *value = job_setting(group, "NSH_BG_PRIORITY");
+    if (!value || !*value)
+        return 0;
+    char *end = nullptr;
+    errno = 0;
+    long priority = strtol(value, &end, 10);
+    if (errno != 0 || *end != '\0' || priority < INT_MIN / 2 || priority > INT_MAX / 2)
+        return 0;
+    return static_cast<int>(priority);
+}
+
+// 0: tanpa batas
+size_t limit_value(const std::string &name)
+{
+    const char *value = get_env_var(name);
+    if (!value || !*value)
+        return 0;
+    char *end = nullptr;
+    long limit = strtol(value, &end, 10);
+    if (*end != '\0' || limit <= 0)
+        return 0;
+    return static_cast<size_t>(limit);
+}
+
+bool has_slot(const std::string &queue, const QueueState *state)
+{
+    size_t total = limit_value("NSH_MAX_BG_JOBS");
+    if (total != 0 && running_total >= total)
+        return false;
+    size_t per_queue = limit_value("NSH_MAX_BG_JOBS_" + queue);
+    return per_queue == 0 || (state ? state->running : 0) < per_queue;
+}
+
+void set_running(TrackedJob &job, bool running)
+{
+    if (job.running == running)
+        return;
+    job.running = running;
+    QueueState &state = queues[job.queue];
+    if (running)
+    {
+        running_total++;
+        state.running++;
+    }
+    else
+    {
+        running_total--;
+        state.running--;
+    }
+}
+
+void launch(PendingJob job, bool announce)
+{
+    launching_job_id = job.job_id;
+    execute_job(job.group, job.use_env);
+    launching_job_id = 0;
+
+    // Gagal sebelum fork (command not found): pesan sudah dicetak execute_job
+    auto it = jobs.find(job.job_id);
+    if (announce && it != jobs.end())
+        std::cout << "[" << job.job_id << "] " << it->second.pgid << std::endl;
+}
+
+void dispatch(bool announce)
+{
+    // execute_job -> job list -> dispatch lagi: cukup satu loop aktif
+    if (dispatching || queued_index.empty())
+        return;
+    dispatching = true;
+
+    while (!queued_index.empty())
+    {
+        // Job dengan prioritas tertinggi di antara antrian yang masih punya slot
+        QueueState *best = nullptr;
+        for (auto &[name, state] : queues)
+        {
+            if (state.pending.empty() || !has_slot(name, &state))
+                continue;
+            if (!best || state.pending.begin()->first < best->pending.begin()->first)
+                best = &state;
+        }
+        if (!best)
+            break;
+
+        auto node = best->pending.extract(best->pending.begin());
+        queued_index.erase(node.mapped().job_id);
+        launch(std::move(node.mapped()), announce);
+    }
+    dispatching = false;
+}
+
+} // namespace
+
+bool scheduler_enqueue_if_limited(const ParsedCommand &group, bool use_env, const std::string &command)
+{
+    if (launching_job_id != 0)
+        return false;
+
+    // Urutan dalam satu antrian tetap FIFO: job baru tidak menyalip yang menunggu
+    std::string queue = queue_name(group);
+    auto it = queues.find(queue);
+    QueueState *state = it == queues.end() ? nullptr : &it->second;
+    if ((!state || state->pending.empty()) && has_slot(queue, state))
+        return false;
+
+    if (!atfork_registered)
+    {
+        pthread_atfork(nullptr, nullptr, reset_after_fork);
+        atfork_registered = true;
+    }
+
+    int job_id = next_job_id++;
+    int priority = job_priority(group);
+    QueueKey key(-priority, next_seq++);
+    queues[queue].pending.emplace(key, PendingJob{job_id, group, use_env, command, priority});
+    queued_index[job_id] = {queue, key};
+
+    // Antrian yang belum penuh (prioritas lebih tinggi, batas baru diubah)
+    // langsung dijalankan
+    dispatch(true);
+    if (queued_index.count(job_id))
+        std::cout << "[" << job_id << "] Queued" << std::endl;
+    return true;
+}
+
+int scheduler_launching_job_id()
+{
+    return launching_job_id;
+}
+
+void scheduler_job_started(pid_t pgid, const ParsedCommand &group)
+{
+    TrackedJob &job = tracked[pgid];
+    job.queue = queue_name(group);
+    job.running = false;
+    set_running(job, true);
+}
+
+void scheduler_job_running(pid_t pgid, bool running)
+{
+    auto it = tracked.find(pgid);
+    if (it != tracked.end())
+        set_running(it->second, running);
+}
+
+void scheduler_job_gone(pid_t pgid)
+{
+    auto it = tracked.find(pgid);
+    if (it == tracked.end())
+        return;
+    set_running(it->second, false);
+    tracked.erase(it);
+}
+
+void scheduler_dispatch()
+{
+    dispatch(false);
+}
+
+std::vector<QueuedJobInfo> scheduler_queued_jobs()
+{
+    std::vector<QueuedJobInfo> result;
+    result.reserve(queued_index.size());
+    for (const auto &[name, state] : queues)
+    {
+        for (const auto &[key, job] : state.pending)
+            result.push_back({job.job_id, job.command, name, job.priority});
+    }
+    return result;
+}
+
+bool scheduler_is_queued(int job_id)
+{
+    return queued_index.count(job_id) != 0;
+}
+
+bool scheduler_cancel(int job_id)
+{
+    auto it = queued_index.find(job_id);
+    if (it == queued_index.end())
+        return false;
+    queues[it->second.first].pending.erase(it->second.second);
+    queued_index.erase(it);
+    return true;
+}
+
+bool scheduler_start_now(int job_id)
+{
+    auto it = queued_index.find(job_id);
+    if (it == queued_index.end())
+        return false;
+    auto &pending = queues[it->second.first].pending;
+    auto node = pending.extract(it->second.second);
+    queued_index.erase(it);
+    launch(std::move(node.mapped()), true);
+    return true;
+}
+
+size_t scheduler_queued_count()
+{
+    return queued_index.size();
+}
+
+size_t scheduler_running_count()
+{
+    return running_total;
+}
+
+void scheduler_drain()
+{
+    // Status keluar shell tetap milik command terakhir script
+    int exit_code = last_exit_code;
+    while (!queued_index.empty())
+    {
+        size_t before = queued_index.size();
+        check_child_status();
+        scheduler_dispatch();
+        if (queued_index.size() == before && running_total == 0)
+            break; // tidak ada yang bisa membebaskan slot
+        if (queued_index.empty())
+            break;
+        event_loop_run_once(-1);
+    }
+    last_exit_code = exit_code;
+}
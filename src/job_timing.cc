@@ -0,0 +1,456 @@
+#include "job_timing.h"
+#include "builtin_io.h"
+#include "execution.h"
+#include "globals.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+namespace {
+
+struct TimeOptions {
+    bool posix = false;
+    bool verbose = false;
+    bool json = false;
+    bool perf = false;
+    bool pipes = false;
+    std::string output_file;
+};
+
+void show_time_help()
+{
+    builtin_out() << "time: time [-p] [-v] [--json] [--perf] [--pipes] [-o FILE] PIPELINE\n"
+                  << "    Report time and resources consumed by PIPELINE's execution.\n\n"
+                  << "    `time' is a keyword: it applies to the whole foreground pipeline that\n"
+                  << "    follows it. The report is written to standard error when the\n"
+                  << "    pipeline finishes (or is stopped) and covers every stage: wall clock,\n"
+                  << "    user and system CPU time, maximum resident set size, major page\n"
+                  << "    faults and voluntary/involuntary context switches, in total and, for\n"
+                  << "    pipelines of more than one stage, per stage.\n\n"
+                  << "    Options:\n"
+                  << "      -p         print real/user/sys in the portable POSIX format\n"
+                  << "      -v         always print the per-stage breakdown\n"
+                  << "      --json     print one JSON object per run (total and stages)\n"
+                  << "      --perf     also count cycles, instructions, cache and branch\n"
+                  << "                 misses, page faults and task-clock with\n"
+                  << "                 perf_event_open (software events only without a\n"
+                  << "                 PMU); see NSH_PERF_COUNTERS\n"
+                  << "      --pipes    also measure every pipe between stages: bytes, MB/s\n"
+                  << "                 and the share of time the producer was blocked on\n"
+                  << "                 a full pipe or the consumer waited on an empty one;\n"
+                  << "                 see NSH_PIPE_METER\n"
+                  << "      -o FILE    append the report to FILE instead of standard error\n\n"
+                  << "    If TIMEFORMAT is set it is used instead of the default report:\n"
+                  << "      %[p][l]R, %[p][l]U, %[p][l]S   real, user and system seconds with\n"
+                  << "                                     p (0-3) decimals, l: MmSS.FFFs\n"
+                  << "      %P   CPU percentage, (user + sys) / real\n"
+                  << "      %M   maximum resident set size in KB    %F   major page faults\n"
+                  << "      %w   voluntary context switches         %c   involuntary ones\n"
+                  << "      %%   a literal %; \\n and \\t are a newline and a tab\n\n"
+                  << "    Exit Status:\n"
+                  << "    The exit status of PIPELINE; 2 on usage error.\n";
+}
+
+void add_usage(struct rusage &total, const struct rusage &usage)
+{
+    timeradd(&total.ru_utime, &usage.ru_utime, &total.ru_utime);
+    timeradd(&total.ru_stime, &usage.ru_stime, &total.ru_stime);
+    total.ru_maxrss = std::max(total.ru_maxrss, usage.ru_maxrss);
+    total.ru_majflt += usage.ru_majflt;
+    total.ru_nvcsw += usage.ru_nvcsw;
+    total.ru_nivcsw += usage.ru_nivcsw;
+}
+
+// Snapshot builtin: thread pemanggil, plus child yang sudah di-reap
+struct rusage usage_snapshot(bool with_children)
+{
+    struct rusage usage = {};
+    getrusage(RUSAGE_THREAD, &usage);
+    if (with_children)
+    {
+        struct rusage children = {};
+        getrusage(RUSAGE_CHILDREN, &children);
+        add_usage(usage, children);
+    }
+    return usage;
+}
+
+double elapsed_seconds(const struct timespec &from, const struct timespec &to)
+{
+    return static_cast<double>(to.tv_sec - from.tv_sec) + (to.tv_nsec - from.tv_nsec) / 1e9;
+}
+
+double timeval_seconds(const struct timeval &tv)
+{
+    return static_cast<double>(tv.tv_sec) + tv.tv_usec / 1e6;
+}
+
+std::string format_seconds(double seconds, int precision, bool long_format)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(precision);
+    if (long_format)
+    {
+        long minutes = static_cast<long>(seconds / 60);
+        out << minutes << 'm' << seconds - minutes * 60.0 << 's';
+    }
+    else
+    {
+        out << seconds;
+    }
+    return out.str();
+}
+
+std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+        {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+std::string stage_command(const SimpleCommand &cmd)
+{
+    std::string text;
+    for (const auto &token : cmd.tokens)
+    {
+        if (!text.empty())
+            text += ' ';
+        text += token;
+    }
+    return text;
+}
+
+std::string usage_fields_json(double real, const struct rusage &usage)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6) << "\"real\":" << real
+        << ",\"user\":" << timeval_seconds(usage.ru_utime) << ",\"sys\":" << timeval_seconds(usage.ru_stime)
+        << ",\"maxrss_kb\":" << usage.ru_maxrss << ",\"majflt\":" << usage.ru_majflt
+        << ",\"nvcsw\":" << usage.ru_nvcsw << ",\"nivcsw\":" << usage.ru_nivcsw;
+    return out.str();
+}
+
+void report_json(std::ostream &out, const JobTiming &timing, const std::string &command,
+                 const struct rusage &total, int exit_code)
+{
+    out << "{\"command\":" << json_string(command) << ",\"status\":" << exit_code << ','
+        << usage_fields_json(elapsed_seconds(timing.started, timing.ended), total) << ",\"stages\":[";
+    for (size_t i = 0; i < timing.stages.size(); ++i)
+    {
+        const StageTiming &stage = timing.stages[i];
+        out << (i ? "," : "") << "{\"command\":" << json_string(stage.command) << ",\"pid\":" << stage.pid
+            << ",\"builtin\":" << (stage.pid == 0 ? "true" : "false")
+            << ",\"finished\":" << (stage.finished ? "true" : "false") << ",\"status\":" << stage.exit_code << ','
+            << usage_fields_json(elapsed_seconds(stage.started, stage.ended), stage.usage) << '}';
+    }
+    out << ']';
+    if (timing.perf.counted)
+    {
+        out << ",\"perf\":{\"source\":\"" << timing.perf.source << '"';
+        for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+        {
+            if (timing.perf.have[event])
+                out << ",\"" << perf_event_name(event) << "\":" << timing.perf.values[event];
+        }
+        out << '}';
+    }
+    if (!timing.pipes.empty())
+        out << ",\"pipes\":" << pipe_meter_json(timing.pipes);
+    out << '}' << std::endl;
+}
+
+// TIMEFORMAT gaya bash, dengan tambahan %M %F %w %c (huruf GNU time)
+void report_format(std::ostream &out, const std::string &format, double real, const struct rusage &total)
+{
+    double user = timeval_seconds(total.ru_utime);
+    double sys = timeval_seconds(total.ru_stime);
+    std::string text;
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        char c = format[i];
+        if (c == '\\' && i + 1 < format.size() && (format[i + 1] == 'n' || format[i + 1] == 't' || format[i + 1] == '\\'))
+        {
+            char next = format[++i];
+            text += next == 'n' ? '\n' : next == 't' ? '\t' : '\\';
+            continue;
+        }
+        if (c != '%' || i + 1 >= format.size())
+        {
+            text += c;
+            continue;
+        }
+
+        size_t start = i;
+        int precision = 3;
+        bool long_format = false;
+        if (format[i + 1] >= '0' && format[i + 1] <= '9')
+            precision = std::min(format[++i] - '0', 3);
+        if (i + 1 < format.size() && format[i + 1] == 'l')
+        {
+            long_format = true;
+            ++i;
+        }
+        if (i + 1 >= format.size())
+        {
+            text += format.substr(start);
+            break;
+        }
+
+        switch (format[++i])
+        {
+        case '%': text += '%'; break;
+        case 'R': text += format_seconds(real, precision, long_format); break;
+        case 'U': text += format_seconds(user, precision, long_format); break;
+        case 'S': text += format_seconds(sys, precision, long_format); break;
+        case 'P': text += format_seconds(real > 0 ? (user + sys) * 100.0 / real : 0.0, 2, false); break;
+        case 'M': text += std::to_string(total.ru_maxrss); break;
+        case 'F': text += std::to_string(total.ru_majflt); break;
+        case 'w': text += std::to_string(total.ru_nvcsw); break;
+        case 'c': text += std::to_string(total.ru_nivcsw); break;
+        default: text += format.substr(start, i - start + 1); break;
+        }
+    }
+    out << text << std::endl;
+}
+
+void report_stages(std::ostream &out, const JobTiming &timing)
+{
+    out << std::left << std::setw(7) << "STAGE" << std::setw(9) << "PID" << std::setw(9) << "STATUS"
+        << std::setw(10) << "REAL" << std::setw(10) << "USER" << std::setw(10) << "SYS"
+        << std::setw(10) << "MAXRSS" << std::setw(8) << "MAJFLT" << std::setw(8) << "VCSW"
+        << std::setw(8) << "IVCSW" << "COMMAND" << std::endl;
+    for (size_t i = 0; i < timing.stages.size(); ++i)
+    {
+        const StageTiming &stage = timing.stages[i];
+        out << std::left << std::setw(7) << i + 1
+            << std::setw(9) << (stage.pid ? std::to_string(stage.pid) : "-")
+            << std::setw(9) << (stage.finished ? std::to_string(stage.exit_code) : "stopped")
+            << std::setw(10) << format_seconds(elapsed_seconds(stage.started, stage.ended), 3, false) + "s"
+            << std::setw(10) << format_seconds(timeval_seconds(stage.usage.ru_utime), 3, false) + "s"
+            << std::setw(10) << format_seconds(timeval_seconds(stage.usage.ru_stime), 3, false) + "s"
+            << std::setw(10) << std::to_string(stage.usage.ru_maxrss) + "K"
+            << std::setw(8) << stage.usage.ru_majflt << std::setw(8) << stage.usage.ru_nvcsw
+            << std::setw(8) << stage.usage.ru_nivcsw << stage.command
+            << (stage.pid == 0 ? " (builtin)" : "") << std::endl;
+    }
+}
+
+void report(const JobTiming &timing, const TimeOptions &options, int exit_code)
+{
+    std::ofstream file;
+    if (!options.output_file.empty())
+    {
+        file.open(options.output_file, std::ios::app);
+        if (!file)
+        {
+            std::cerr << "nsh: time: " << options.output_file << ": " << strerror(errno) << std::endl;
+            return;
+        }
+    }
+    std::ostream &out = file.is_open() ? static_cast<std::ostream &>(file) : std::cerr;
+
+    struct rusage total = {};
+    std::string command;
+    for (const auto &stage : timing.stages)
+    {
+        add_usage(total, stage.usage);
+        command += (command.empty() ? "" : " | ") + stage.command;
+    }
+    double real = elapsed_seconds(timing.started, timing.ended);
+
+    if (options.json)
+    {
+        report_json(out, timing, command, total, exit_code);
+        return;
+    }
+
+    const char *format = get_env_var("TIMEFORMAT");
+    if (options.posix)
+    {
+        out << "real " << format_seconds(real, 2, false) << "\nuser "
+            << format_seconds(timeval_seconds(total.ru_utime), 2, false) << "\nsys "
+            << format_seconds(timeval_seconds(total.ru_stime), 2, false) << std::endl;
+    }
+    else if (format)
+    {
+        // TIMEFORMAT kosong: tanpa laporan (seperti bash)
+        if (*format)
+            report_format(out, format, real, total);
+    }
+    else
+    {
+        out << "\nreal\t" << format_seconds(real, 3, true)
+            << "\nuser\t" << format_seconds(timeval_seconds(total.ru_utime), 3, true)
+            << "\nsys\t" << format_seconds(timeval_seconds(total.ru_stime), 3, true)
+            << "\nmaxrss\t" << total.ru_maxrss << " KB"
+            << "\nmajflt\t" << total.ru_majflt
+            << "\ncsw\t" << total.ru_nvcsw << " voluntary, " << total.ru_nivcsw << " involuntary" << std::endl;
+    }
+
+    if (timing.perf.counted)
+        out << perf_format(timing.perf) << std::endl;
+    if (options.verbose || (timing.stages.size() > 1 && !options.posix && !format))
+        report_stages(out, timing);
+    if (!timing.pipes.empty())
+        out << pipe_meter_format(timing.pipes) << std::flush;
+}
+
+} // namespace
+
+struct timespec timing_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now;
+}
+
+void timing_stage_start(StageTiming &stage, pid_t pid, bool with_children)
+{
+    stage.pid = pid;
+    stage.started = timing_now();
+    stage.ended = stage.started;
+    stage.with_children = with_children;
+    if (pid == 0)
+        stage.baseline = usage_snapshot(with_children);
+}
+
+void timing_stage_builtin_done(StageTiming &stage, int exit_code)
+{
+    struct rusage end = usage_snapshot(stage.with_children);
+    stage.ended = timing_now();
+    stage.finished = true;
+    stage.exit_code = exit_code;
+    stage.usage = {};
+    timersub(&end.ru_utime, &stage.baseline.ru_utime, &stage.usage.ru_utime);
+    timersub(&end.ru_stime, &stage.baseline.ru_stime, &stage.usage.ru_stime);
+    stage.usage.ru_maxrss = end.ru_maxrss;
+    stage.usage.ru_majflt = end.ru_majflt - stage.baseline.ru_majflt;
+    stage.usage.ru_nvcsw = end.ru_nvcsw - stage.baseline.ru_nvcsw;
+    stage.usage.ru_nivcsw = end.ru_nivcsw - stage.baseline.ru_nivcsw;
+}
+
+void timing_stage_process_done(StageTiming &stage, int status, const struct rusage &usage,
+                               const struct timespec &exited_at)
+{
+    stage.finished = WIFEXITED(status) || WIFSIGNALED(status);
+    if (!stage.finished)
+    {
+        stage.ended = timing_now();
+        return;
+    }
+    stage.ended = exited_at;
+    stage.usage = usage;
+    stage.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+bool is_timed_job(const ParsedCommand &group)
+{
+    return group.timed && !group.pipeline.empty() && !group.pipeline[0].tokens.empty();
+}
+
+/**
+ * @brief Jalankan pipeline yang diawali keyword `time` dan laporkan resource-nya.
+ *
+ * Keyword dan opsinya dibuang dari stage pertama, lalu execute_job mengisi
+ * JobTiming per stage: proses dari wait4 (lewat event loop), builtin dari
+ * getrusage(RUSAGE_THREAD) di thread yang menjalankannya.
+ */
+int execute_timed_job(const ParsedCommand &original_group, bool use_env)
+{
+    ParsedCommand group = original_group;
+    std::vector<std::string> &tokens = group.pipeline[0].tokens;
+    TimeOptions options;
+
+    size_t i = 1;
+    for (; i < tokens.size(); ++i)
+    {
+        const std::string &token = tokens[i];
+        if (token == "--")
+        {
+            ++i;
+            break;
+        }
+        if (token.size() < 2 || token[0] != '-')
+            break;
+        if (token == "--help")
+        {
+            show_time_help();
+            return 0;
+        }
+        if (token == "-p")
+            options.posix = true;
+        else if (token == "-v")
+            options.verbose = true;
+        else if (token == "--json")
+            options.json = true;
+        else if (token == "--perf")
+            options.perf = true;
+        else if (token == "--pipes")
+            options.pipes = true;
+        else if (token == "-o" && i + 1 < tokens.size())
+            options.output_file = tokens[++i];
+        else if (token.rfind("--output=", 0) == 0)
+            options.output_file = token.substr(9);
+        else
+        {
+            std::cerr << "nsh: time: " << token << ": invalid option" << std::endl;
+            std::cerr << "time: usage: time [-p] [-v] [--json] [--perf] [--pipes] [-o FILE] PIPELINE" << std::endl;
+            return 2;
+        }
+    }
+    erase_leading_tokens(group.pipeline[0], i);
+    group.timed = false;
+
+    if (tokens.empty() && group.pipeline.size() > 1)
+    {
+        std::cerr << "nsh: time: missing command before `|'" << std::endl;
+        return 2;
+    }
+    if (group.background)
+    {
+        std::cerr << "nsh: time: background jobs are not timed" << std::endl;
+        return execute_job(group, use_env);
+    }
+
+    JobTiming timing;
+    timing.perf_requested = options.perf;
+    timing.pipes_requested = options.pipes;
+    timing.started = timing_now();
+    int exit_code = 0;
+    if (!tokens.empty())
+    {
+        timing.stages.resize(group.pipeline.size());
+        for (size_t stage = 0; stage < group.pipeline.size(); ++stage)
+            timing.stages[stage].command = stage_command(group.pipeline[stage]);
+        exit_code = execute_job(group, use_env, &timing);
+    }
+    timing.ended = timing_now();
+
+    report(timing, options, exit_code);
+    return exit_code;
+}
@@ -6,6 +6,10 @@
 #include "execution.h"
 #include "utils.h" // xrand and others
 #include "input.h"
+#include "events.h"
+#include "job_registry.h"
+#include "job_scheduler.h"
+#include "job_output.h"
 
 #include <iostream>
 #include <string>
@@ -16,6 +20,7 @@
 #include <filesystem>
 #include <csignal> // Added for strsignal
 #include <iomanip> // Added for std::left, std::setw
+#include <algorithm> // std::sort for report_finished_jobs
 
 #include <unistd.h>     // For usleep (Unix-like sleep for microseconds)
 #include <cstdlib>      // For system("clear") or similar
@@ -228,6 +233,7 @@ int main(int argc, char* argv[]) {
                     last_exit_code = 1;
                 }
             }
+            scheduler_drain();
             return last_exit_code;
         }
         
@@ -279,6 +285,7 @@ void handle_command_line_args(int argc, char *argv[]) {
       if (i + 1 < args.size()) {
         std::string command = args[i + 1];
         run_subshell_command(command);
+        scheduler_drain();
         exit_shell(last_exit_code); // Keluar setelah menjalankan command
       } else {
         std::cerr << "nsh: option requires an argument -- '" << args[i] << "'"
@@ -302,6 +309,7 @@ void handle_command_line_args(int argc, char *argv[]) {
       if (i + 1 < args.size()) {
         std::string file = args[i + 1];
         execute_script_file(file);
+        scheduler_drain();
         exit_shell(last_exit_code);
       } else {
         std::cerr << "nsh: option requires target file -- '" << args[i] << "'"
@@ -311,6 +319,7 @@ void handle_command_line_args(int argc, char *argv[]) {
     } else if (args[i][0] != '-') {
       // Ini kemungkinan nama file script
       execute_script_file(args[i]);
+      scheduler_drain();
       exit_shell(last_exit_code);
     } else {
       std::cerr << "nsh: invalid option -- '" << args[i] << "'" << std::endl;
@@ -510,7 +519,19 @@ void process_rcfile()
 }
 
 void report_finished_jobs() {
-    if (!isatty(STDIN_FILENO) || finished_jobs.empty()) {
+    if (!isatty(STDIN_FILENO)) {
+        return;
+    }
+
+    // Job session lain yang selesai; snapshot registry hanya dibaca ulang
+    // jika watcher inotify melihat perubahan, jadi prompt idle tidak men-scan
+    for (const RegistryJob& job : registry_take_foreign_finished()) {
+        std::cout << "[" << job.job_id << "]" << "\t"
+                  << std::left << std::setw(10) << job_status_to_string(job.status, job.term_status) << "\t"
+                  << job.command << "  (session: " << job.owner_pid << ")" << std::endl;
+    }
+
+    if (finished_jobs.empty()) {
         return;
     }
 
@@ -525,6 +546,12 @@ void report_finished_jobs() {
         std::cout << "[" << id << "]+" << "\t"
                   << std::left << std::setw(10) << job_status_to_string(job.status, job.term_status) << "\t"
                   << job.command << std::endl;
+        if (!job.perf_summary.empty())
+            std::cout << "\t" << job.perf_summary << std::endl;
+        if (!job.pipe_summary.empty())
+            std::cout << job.pipe_summary;
+        // Output yang di-capture (NSH_BG_CAPTURE) tidak disimpan lagi
+        output_capture_release(job.pgid);
     }
     finished_jobs.clear();
 }
@@ -537,6 +564,10 @@ void run_interactive_shell() {
     
     load_history();  
     
+    // Readline menunggu input di event loop, jadi exit/stop job background
+    // diproses selagi prompt menunggu
+    rl_getc_function = event_loop_getc;
+
     Parser parser;
 
     while (true) {
@@ -555,6 +586,10 @@ void run_interactive_shell() {
         received_sigint = 0;
         reset_current_signal();
 
+        check_child_status();
+        flush_job_updates();
+        report_finished_jobs();
+
         std::string main_prompt = get_prompt_string();
         
         // Gunakan parser untuk mendapatkan input multiline
@@ -170,6 +170,36 @@ std::vector<Token> Parser::tokenize(const std::string &input) const
             }
         }
 
+        // Handle process substitution <(...) dan >(...), disimpan utuh
+        // sebagai satu WORD dan diganti /dev/fd/N saat eksekusi
+        if (!in_quote && !in_arithmetic && (c == '<' || c == '>') && current_token.empty() &&
+            i + 1 < input.length() && input[i+1] == '(')
+        {
+            paren_count = 1;
+            current_token = std::string(1, c) + "(";
+            i++; // Skip the '<' / '>'
+
+            while (i < input.length() && paren_count > 0)
+            {
+                i++;
+                if (i >= input.length()) break;
+
+                current_token += input[i];
+                if (input[i] == '(') paren_count++;
+                else if (input[i] == ')') paren_count--;
+            }
+
+            if (paren_count == 0) {
+                tokens.push_back({TokenType::PROCESS_SUBST, current_token});
+            } else {
+                std::cerr << "nsh: syntax error: unclosed process substitution\n";
+                return {};
+            }
+            current_token.clear();
+            is_assignment = false;
+            continue;
+        }
+
         // Handle command substitution $(...) dan `...`
         if (!in_quote && !in_arithmetic && c == '$' && i + 1 < input.length() && input[i+1] == '(')
         {
@@ -343,8 +373,14 @@ std::vector<Token> Parser::tokenize(const std::string &input) const
         {
             if (!current_token.empty())
             {
-                tokens.push_back({is_assignment && is_env_assignment(current_token) ? 
-                                TokenType::ASSIGNMENT_WORD : TokenType::WORD, current_token});
+                // `2>file`: angka yang menempel langsung ke < atau > adalah fd,
+                // sedangkan `echo 2 > file` tetap argumen biasa
+                TokenType type = TokenType::WORD;
+                if ((c == '<' || c == '>') && is_string_numeric(current_token))
+                    type = TokenType::IO_NUMBER;
+                else if (is_assignment && is_env_assignment(current_token))
+                    type = TokenType::ASSIGNMENT_WORD;
+                tokens.push_back({type, current_token});
                 current_token.clear();
             }
             in_assignment_word = false;
@@ -415,13 +451,9 @@ std::vector<Token> Parser::tokenize(const std::string &input) const
         }
         else
         {
+            // Nama variabel sudah divalidasi saat `=`; nilainya boleh berisi
+            // karakter apa saja (`PATH=/bin:/usr/bin`, `NSH_BG_CPUS=4-15`)
             current_token += c;
-            // Jika kita sedang dalam konteks assignment dan menemukan karakter non-identifier,
-            // maka ini bukan assignment word yang valid
-            if (in_assignment_word && !isalnum(c) && c != '_' && c != '=') {
-                in_assignment_word = false;
-                is_assignment = false;
-            }
         }
     }
 
@@ -463,6 +495,9 @@ void Parser::expand_aliases(std::vector<Token> &tokens)
 
         if (is_command_start && token.type == TokenType::WORD)
         {
+            // `producer |{ c1 ; c2 }`: kata setelah `{` juga awal command
+            if (token.text == "{")
+                continue;
             auto it = aliases.find(token.text);
             if (it != aliases.end() && expansion_guard.find(token.text) == expansion_guard.end())
             {
@@ -508,7 +543,12 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
         return command_list;
 
     expand_aliases(tokens);
+    return parse_tokens(tokens);
+}
 
+std::vector<ParsedCommand> Parser::parse_tokens(const std::vector<Token> &tokens)
+{
+    std::vector<ParsedCommand> command_list;
     command_list.emplace_back();
     SimpleCommand current_simple_cmd;
     // expect_redirect_file, last_redirect_type tidak lagi diperlukan
@@ -516,20 +556,33 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
     // TokenType last_redirect_type = TokenType::WORD;
 
     bool command_word_found = false;
+    bool after_fanout = false; // tepat setelah `}` penutup fan-out
 
     for (size_t i = 0; i < tokens.size(); ++i)
     {
         const Token &token = tokens[i];
 
+        // Fan-out harus menjadi akhir pipeline: setelah `}` hanya boleh
+        // operator list atau `&` penutup
+        if (after_fanout && token.type != TokenType::SEMICOLON && token.type != TokenType::AND_IF &&
+            token.type != TokenType::OR_IF && !(token.type == TokenType::AMPERSAND && i + 1 == tokens.size()))
+        {
+            std::cerr << "nsh: syntax error near unexpected token `" << token.text << "'" << std::endl;
+            return {};
+        }
+
         // --- AWAL PERBAIKAN BUG REDIREKSI FD DENGAN ANGKA AWAL ---
         // Pola: WORD(angka) diikuti oleh operator GREAT, LESS, etc.
-        if (token.type == TokenType::WORD && i + 1 < tokens.size() && is_string_numeric(token.text)) {
+        if (token.type == TokenType::IO_NUMBER && i + 1 < tokens.size()) {
             const Token &next_token = tokens[i+1];
             if (next_token.type == TokenType::GREAT || next_token.type == TokenType::DGREAT || next_token.type == TokenType::LESS) {
                  if (i + 2 < tokens.size()) {
                     const Token& target_token = tokens[i+2];
                     Redirection redir;
-                    redir.source_fd = std::stoi(token.text);
+                    if (!parse_fd_number(token.text, redir.source_fd)) {
+                        std::cerr << "nsh: " << token.text << ": bad file descriptor" << std::endl;
+                        return {};
+                    }
 
                     // Kasus Duplikasi FD (e.g., 2>&1) atau Penutupan FD (e.g., 2>&-)
                     if (target_token.type == TokenType::AMPERSAND) {
@@ -539,8 +592,14 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                                 // Menutup FD: 2>&-
                                 redir.type = RedirectionType::CLOSE_FD;
                             } else if (is_string_numeric(final_target.text)) {
-                                // Duplikasi FD: 2>&1
-                                redir.target_fd = std::stoi(final_target.text);
+                                // Duplikasi FD: 2>&1 (di luar jangkauan int:
+                                // dilaporkan saat redirection diterapkan)
+                                if (!parse_fd_number(final_target.text, redir.target_fd))
+                                    redir.target_file = final_target.text;
+                                redir.type = (next_token.type == TokenType::LESS) ? RedirectionType::DUPLICATE_IN : RedirectionType::DUPLICATE_OUT;
+                            } else if (final_target.text[0] == '$') {
+                                // FD dari variabel (2>&$COPROC_1), di-expand saat eksekusi
+                                redir.target_file = final_target.text;
                                 redir.type = (next_token.type == TokenType::LESS) ? RedirectionType::DUPLICATE_IN : RedirectionType::DUPLICATE_OUT;
                             } else {
                                 std::cerr << "nsh: " << final_target.text << ": ambiguous redirect" << std::endl;
@@ -555,8 +614,10 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                         }
                     }
                     // Kasus Pengalihan File Biasa dengan FD Spesifik (e.g., 2>file)
-                    else if (target_token.type == TokenType::WORD || target_token.type == TokenType::STRING) {
+                    else if (target_token.type == TokenType::WORD || target_token.type == TokenType::STRING ||
+                             target_token.type == TokenType::PROCESS_SUBST) {
                         redir.target_file = target_token.text;
+                        redir.process_substitution = target_token.type == TokenType::PROCESS_SUBST;
                         if (next_token.type == TokenType::GREAT) {
                             redir.type = RedirectionType::REDIR_OUT;
                         } else if (next_token.type == TokenType::DGREAT) {
@@ -592,9 +653,9 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                     auto [var_name, value] = parse_env_assignment(token.text);
                     current_simple_cmd.env_vars[var_name] = value;
                     current_simple_cmd.exported_vars.insert(var_name);
-
-                    // more recommended, because we don't know the original exported or default state
-                    set_env_var(var_name, value, 0);
+                    // Tidak di-set di shell: `VAR=x cmd` hanya berlaku untuk cmd
+                    // (launch_process/execute_builtin), `VAR=x` saja di-set oleh
+                    // execute_command_list
                 }
                 else
                 {
@@ -604,10 +665,190 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
             }
             case TokenType::WORD:
             case TokenType::STRING:
+                // `{ p1 & p2 | f } |merge [-t] [-b SIZE] consumer`: output
+                // setiap producer digabung per baris (relay di execute_job).
+                // `time [-p]` di depannya ikut ke stage pertama dan dibuang
+                // lagi oleh execute_timed_job.
+                if (token.type == TokenType::WORD && token.text == "{" &&
+                    command_list.back().pipeline.empty() && current_simple_cmd.env_vars.empty() &&
+                    current_simple_cmd.redirections.empty() &&
+                    (current_simple_cmd.tokens.empty() ||
+                     (command_list.back().timed &&
+                      std::all_of(current_simple_cmd.tokens.begin() + 1, current_simple_cmd.tokens.end(),
+                                  [](const std::string &word) { return word.size() > 1 && word[0] == '-'; }))))
+                {
+                    int depth = 1;
+                    size_t j = i + 1;
+                    for (; j < tokens.size(); ++j)
+                    {
+                        if (tokens[j].type != TokenType::WORD)
+                            continue;
+                        if (tokens[j].text == "{")
+                            depth++;
+                        else if (tokens[j].text == "}" && --depth == 0)
+                            break;
+                    }
+                    if (depth != 0)
+                    {
+                        std::cerr << "nsh: syntax error: merge: missing `}'" << std::endl;
+                        return {};
+                    }
+                    if (j + 2 >= tokens.size() || tokens[j + 1].type != TokenType::PIPE || tokens[j + 2].text != "merge")
+                    {
+                        std::cerr << "nsh: syntax error: `{ ... }' must be followed by `|merge'" << std::endl;
+                        return {};
+                    }
+
+                    // Producer dipisah `&`, kecuali `&` milik `2>&1` dan `&>`
+                    ParsedCommand &group = command_list.back();
+                    size_t start = i + 1;
+                    depth = 0;
+                    for (size_t k = i + 1; k <= j; ++k)
+                    {
+                        if (k < j && tokens[k].type == TokenType::WORD)
+                        {
+                            if (tokens[k].text == "{")
+                                depth++;
+                            else if (tokens[k].text == "}")
+                                depth--;
+                        }
+                        bool separator = k == j;
+                        if (k < j && depth == 0 && tokens[k].type == TokenType::AMPERSAND)
+                        {
+                            bool after_redirect = tokens[k - 1].type == TokenType::GREAT || tokens[k - 1].type == TokenType::LESS;
+                            bool before_redirect = tokens[k + 1].type == TokenType::GREAT || tokens[k + 1].type == TokenType::DGREAT;
+                            separator = !after_redirect && !before_redirect;
+                        }
+                        if (!separator)
+                            continue;
+
+                        std::vector<Token> body(tokens.begin() + start, tokens.begin() + k);
+                        start = k + 1;
+                        if (body.empty())
+                        {
+                            // `{ p1 & p2 & }`: `&` penutup boleh
+                            if (k == j && !group.merge_producers.empty())
+                                continue;
+                            std::cerr << "nsh: syntax error near unexpected token `" << tokens[k].text << "'" << std::endl;
+                            return {};
+                        }
+                        std::vector<ParsedCommand> producer = parse_tokens(body);
+                        if (producer.empty())
+                            return {};
+                        if (producer.size() != 1 || producer[0].background || !producer[0].fanout_branches.empty() ||
+                            !producer[0].merge_producers.empty())
+                        {
+                            std::cerr << "nsh: syntax error: merge: producers must be pipelines separated by `&'" << std::endl;
+                            return {};
+                        }
+                        group.merge_producers.push_back(group.pipeline.size());
+                        group.pipeline.insert(group.pipeline.end(), producer[0].pipeline.begin(), producer[0].pipeline.end());
+                    }
+
+                    size_t k = j + 3;
+                    for (; k < tokens.size() && tokens[k].type == TokenType::WORD && tokens[k].text.size() > 1 &&
+                           tokens[k].text[0] == '-'; ++k)
+                    {
+                        unsigned long long bytes = 0;
+                        if (tokens[k].text == "-t")
+                            group.merge_tagged = true;
+                        else if (tokens[k].text == "-b" && k + 1 < tokens.size() &&
+                                 parse_byte_size(tokens[k + 1].text, bytes) && bytes > 0)
+                            group.merge_buffer = static_cast<size_t>(bytes);
+                        else
+                        {
+                            std::cerr << "nsh: merge: " << tokens[k].text << ": invalid option" << std::endl;
+                            std::cerr << "merge: usage: { PRODUCER & PRODUCER... } |merge [-t] [-b SIZE] CONSUMER" << std::endl;
+                            return {};
+                        }
+                        if (bytes > 0)
+                            k++;
+                    }
+                    if (k >= tokens.size() || tokens[k].type == TokenType::SEMICOLON || tokens[k].type == TokenType::AND_IF ||
+                        tokens[k].type == TokenType::OR_IF || tokens[k].type == TokenType::PIPE ||
+                        tokens[k].type == TokenType::AMPERSAND)
+                    {
+                        std::cerr << "nsh: syntax error: merge: missing consumer" << std::endl;
+                        return {};
+                    }
+                    group.merge_consumer = group.pipeline.size();
+                    auto &first = group.pipeline[0];
+                    first.tokens.insert(first.tokens.begin(), current_simple_cmd.tokens.begin(), current_simple_cmd.tokens.end());
+                    std::set<size_t> shifted;
+                    for (size_t index : first.process_substitutions)
+                        shifted.insert(index + current_simple_cmd.tokens.size());
+                    first.process_substitutions = shifted;
+                    current_simple_cmd = {};
+                    command_word_found = false;
+                    i = k - 1; // consumer diparse seperti command biasa
+                    break;
+                }
+
+                // coproc [NAME] { command-list; } atau coproc command args...
+                // Body disatukan jadi satu token: `coproc NAME BODY`
+                if (!command_word_found && token.text == "coproc" && i + 1 < tokens.size())
+                {
+                    std::string name = "COPROC";
+                    size_t j = i + 1;
+                    if (tokens[j].type == TokenType::WORD && tokens[j].text != "{" &&
+                        j + 1 < tokens.size() && tokens[j + 1].text == "{")
+                    {
+                        name = tokens[j].text;
+                        j++;
+                    }
+
+                    std::string body;
+                    if (tokens[j].text == "{")
+                    {
+                        int depth = 1;
+                        for (j = j + 1; j < tokens.size(); ++j)
+                        {
+                            if (tokens[j].text == "{") depth++;
+                            else if (tokens[j].text == "}" && --depth == 0) break;
+                            body += (body.empty() ? "" : " ") + tokens[j].text;
+                        }
+                        if (depth != 0)
+                        {
+                            std::cerr << "nsh: syntax error: coproc: missing `}'" << std::endl;
+                            return {};
+                        }
+                    }
+                    else
+                    {
+                        for (; j < tokens.size(); ++j)
+                        {
+                            if (tokens[j].type == TokenType::SEMICOLON || tokens[j].type == TokenType::AND_IF ||
+                                tokens[j].type == TokenType::OR_IF)
+                            {
+                                j--;
+                                break;
+                            }
+                            body += (body.empty() ? "" : " ") + tokens[j].text;
+                        }
+                        if (j == tokens.size()) j--;
+                    }
+
+                    current_simple_cmd.tokens = {"coproc", name, body};
+                    command_word_found = true;
+                    i = j;
+                    break;
+                }
+                // Keyword `time` hanya kata pertama pipeline yang ditulis apa
+                // adanya: `"time"` atau `$x` yang berisi time adalah command biasa
+                if (token.type == TokenType::WORD && token.text == "time" && current_simple_cmd.tokens.empty() &&
+                    current_simple_cmd.env_vars.empty() && current_simple_cmd.redirections.empty() &&
+                    command_list.back().pipeline.empty())
+                    command_list.back().timed = true;
                 command_word_found = true;
                 current_simple_cmd.tokens.push_back(token.text);
                 break;
 
+            case TokenType::PROCESS_SUBST:
+                command_word_found = true;
+                current_simple_cmd.process_substitutions.insert(current_simple_cmd.tokens.size());
+                current_simple_cmd.tokens.push_back(token.text);
+                break;
+
             case TokenType::PIPE:
                 if (current_simple_cmd.tokens.empty() && current_simple_cmd.env_vars.empty() && current_simple_cmd.redirections.empty()) // Tambahkan cek untuk redirections juga
                 {
@@ -618,19 +859,91 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                 command_list.back().pipeline.push_back(current_simple_cmd);
                 current_simple_cmd = {};
                 command_word_found = false;
+
+                // `a |buf 256M| b`: buffer elastis di shell di antara a dan b
+                if (i + 3 < tokens.size() && tokens[i + 1].type == TokenType::WORD && tokens[i + 1].text == "buf" &&
+                    tokens[i + 3].type == TokenType::PIPE)
+                {
+                    unsigned long long bytes = 0;
+                    if (!parse_byte_size(tokens[i + 2].text, bytes) || bytes == 0)
+                    {
+                        std::cerr << "nsh: buf: " << tokens[i + 2].text << ": invalid size" << std::endl;
+                        return {};
+                    }
+                    if (i + 4 >= tokens.size() || tokens[i + 4].text == "{" ||
+                        (tokens[i + 4].type != TokenType::WORD && tokens[i + 4].type != TokenType::STRING &&
+                         tokens[i + 4].type != TokenType::ASSIGNMENT_WORD))
+                    {
+                        std::cerr << "nsh: syntax error: buf: expected command after `|buf " << tokens[i + 2].text << "|'" << std::endl;
+                        return {};
+                    }
+                    command_list.back().pipeline.back().pipe_buffer = static_cast<size_t>(bytes);
+                    i += 3;
+                    break;
+                }
+
+                // `producer |{ c1 ; c2 | c3 }`: output producer diduplikasi
+                // ke setiap cabang (relay di execute_job)
+                if (i + 1 < tokens.size() && tokens[i + 1].type == TokenType::WORD && tokens[i + 1].text == "{")
+                {
+                    int depth = 1;
+                    size_t j = i + 2;
+                    for (; j < tokens.size(); ++j)
+                    {
+                        if (tokens[j].type != TokenType::WORD)
+                            continue;
+                        if (tokens[j].text == "{")
+                            depth++;
+                        else if (tokens[j].text == "}" && --depth == 0)
+                            break;
+                    }
+                    if (depth != 0)
+                    {
+                        std::cerr << "nsh: syntax error: fan-out: missing `}'" << std::endl;
+                        return {};
+                    }
+
+                    std::vector<Token> body(tokens.begin() + i + 2, tokens.begin() + j);
+                    std::vector<ParsedCommand> branches = parse_tokens(body);
+                    if (branches.empty())
+                    {
+                        if (body.empty())
+                            std::cerr << "nsh: syntax error near unexpected token `}'" << std::endl;
+                        return {};
+                    }
+
+                    ParsedCommand &group = command_list.back();
+                    for (const ParsedCommand &branch : branches)
+                    {
+                        if (branch.background || !branch.fanout_branches.empty() || !branch.merge_producers.empty() ||
+                            branch.next_operator == ParsedCommand::Operator::AND ||
+                            branch.next_operator == ParsedCommand::Operator::OR)
+                        {
+                            std::cerr << "nsh: syntax error: fan-out: branches must be pipelines separated by `;'" << std::endl;
+                            return {};
+                        }
+                        group.fanout_branches.push_back(group.pipeline.size());
+                        group.pipeline.insert(group.pipeline.end(), branch.pipeline.begin(), branch.pipeline.end());
+                    }
+                    after_fanout = true;
+                    i = j;
+                }
                 break;
 
             case TokenType::AND_IF:
             case TokenType::OR_IF:
             case TokenType::SEMICOLON:
-                if (current_simple_cmd.tokens.empty() && current_simple_cmd.env_vars.empty() && current_simple_cmd.redirections.empty()) // Tambahkan cek untuk redirections juga
+                if (!after_fanout)
                 {
-                    std::cerr << "nsh: syntax error near unexpected token `" << token.text << "'" << std::endl;
-                    return {};
+                    if (current_simple_cmd.tokens.empty() && current_simple_cmd.env_vars.empty() && current_simple_cmd.redirections.empty()) // Tambahkan cek untuk redirections juga
+                    {
+                        std::cerr << "nsh: syntax error near unexpected token `" << token.text << "'" << std::endl;
+                        return {};
+                    }
+                    command_list.back().pipeline.push_back(current_simple_cmd);
                 }
-                
-                command_list.back().pipeline.push_back(current_simple_cmd);
                 current_simple_cmd = {};
+                after_fanout = false;
 
                 if (token.type == TokenType::AND_IF)
                     command_list.back().next_operator = ParsedCommand::Operator::AND;
@@ -663,7 +976,12 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                             redir.type = RedirectionType::CLOSE_FD;
                         } else if (is_string_numeric(target_token.text)) {
                             // Duplikasi FD: >&1
-                            redir.target_fd = std::stoi(target_token.text);
+                            if (!parse_fd_number(target_token.text, redir.target_fd))
+                                redir.target_file = target_token.text;
+                            redir.type = (token.type == TokenType::LESS) ? RedirectionType::DUPLICATE_IN : RedirectionType::DUPLICATE_OUT;
+                        } else if (target_token.text[0] == '$') {
+                            // FD dari variabel (>&$COPROC_1), di-expand saat eksekusi
+                            redir.target_file = target_token.text;
                             redir.type = (token.type == TokenType::LESS) ? RedirectionType::DUPLICATE_IN : RedirectionType::DUPLICATE_OUT;
                         } else {
                             std::cerr << "nsh: " << target_token.text << ": ambiguous redirect" << std::endl;
@@ -686,12 +1004,14 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                 const Token& target_token = tokens[i+1];
 
                 // Pastikan target adalah nama file/delimiter (WORD atau STRING)
-                if (target_token.type != TokenType::WORD && target_token.type != TokenType::STRING) {
+                if (target_token.type != TokenType::WORD && target_token.type != TokenType::STRING &&
+                    target_token.type != TokenType::PROCESS_SUBST) {
                      std::cerr << "nsh: syntax error: expected filename/delimiter after redirection operator" << std::endl;
                      return {};
                 }
 
                 Redirection redir;
+                redir.process_substitution = target_token.type == TokenType::PROCESS_SUBST;
                 redir.source_fd = (token.type == TokenType::LESS || token.type == TokenType::LESSLESS || token.type == TokenType::LESSLESSLESS) ? 0 : 1;
 
                 if (token.type == TokenType::LESS) {
@@ -721,12 +1041,14 @@ std::vector<ParsedCommand> Parser::parse(const std::string &input)
                 if (i + 1 < tokens.size() && (tokens[i+1].type == TokenType::GREAT || tokens[i+1].type == TokenType::DGREAT)) {
                     if (i + 2 < tokens.size()) {
                         const Token& target_token = tokens[i+2];
-                        if (target_token.type != TokenType::WORD && target_token.type != TokenType::STRING) {
+                        if (target_token.type != TokenType::WORD && target_token.type != TokenType::STRING &&
+                            target_token.type != TokenType::PROCESS_SUBST) {
                             std::cerr << "nsh: syntax error: expected filename after redirect" << std::endl;
                             return {};
                         }
                         Redirection redir;
                         redir.target_file = target_token.text;
+                        redir.process_substitution = target_token.type == TokenType::PROCESS_SUBST;
                         redir.type = (tokens[i+1].type == TokenType::GREAT) ? RedirectionType::REDIR_OUT_ERR : RedirectionType::REDIR_OUT_ERR_APPEND;
                         current_simple_cmd.redirections.push_back(redir);
                         i += 2; // Lewati '&', '>', dan 'file'
@@ -0,0 +1,107 @@
+#include "pipe_meter.h"
+#include "globals.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+// Batas tunggu relay setelah job selesai
+constexpr auto SETTLE_TIMEOUT = std::chrono::milliseconds(200);
+
+struct timespec now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts;
+}
+
+// Durasi relay sejauh ini (sampai sekarang jika belum selesai)
+double elapsed_seconds(const PipeMeter &meter)
+{
+    struct timespec end = meter.finished.load(std::memory_order_acquire) ? meter.ended : now();
+    return static_cast<double>(end.tv_sec - meter.started.tv_sec) + (end.tv_nsec - meter.started.tv_nsec) / 1e9;
+}
+
+double percent(long long blocked_ns, double seconds)
+{
+    if (seconds <= 0)
+        return 0.0;
+    return std::min(100.0, blocked_ns / 1e7 / seconds);
+}
+
+} // namespace
+
+bool pipe_meter_requested(const ParsedCommand &group)
+{
+    const char *value = nullptr;
+    if (!group.pipeline.empty())
+    {
+        auto it = group.pipeline[0].env_vars.find("NSH_PIPE_METER");
+        if (it != group.pipeline[0].env_vars.end())
+            value = it->second.c_str();
+    }
+    if (!value)
+        value = get_env_var("NSH_PIPE_METER");
+    return value && *value && strcmp(value, "0") != 0;
+}
+
+void pipe_meter_finish(PipeMeter &meter)
+{
+    meter.ended = now();
+    meter.finished.store(true, std::memory_order_release);
+}
+
+void pipe_meter_settle(const PipeMeters &meters)
+{
+    auto deadline = std::chrono::steady_clock::now() + SETTLE_TIMEOUT;
+    for (const auto &meter : meters)
+    {
+        while (!meter->finished.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+std::string pipe_meter_format(const PipeMeters &meters)
+{
+    std::ostringstream out;
+    out << std::left << std::setw(9) << "EDGE" << std::setw(15) << "BYTES" << std::setw(11) << "MB/s"
+        << std::setw(18) << "PRODUCER-BLOCKED" << std::setw(18) << "CONSUMER-BLOCKED" << "PIPE" << '\n';
+    for (const auto &meter : meters)
+    {
+        double seconds = elapsed_seconds(*meter);
+        unsigned long long bytes = meter->bytes.load(std::memory_order_relaxed);
+        std::ostringstream rate, producer, consumer;
+        rate << std::fixed << std::setprecision(1) << (seconds > 0 ? bytes / 1e6 / seconds : 0.0);
+        producer << std::fixed << std::setprecision(1)
+                 << percent(meter->producer_blocked_ns.load(std::memory_order_relaxed), seconds) << '%';
+        consumer << std::fixed << std::setprecision(1)
+                 << percent(meter->consumer_blocked_ns.load(std::memory_order_relaxed), seconds) << '%';
+        out << std::left << std::setw(9) << std::to_string(meter->producer + 1) + "->" + std::to_string(meter->producer + 2)
+            << std::setw(15) << bytes << std::setw(11) << rate.str() << std::setw(18) << producer.str()
+            << std::setw(18) << consumer.str() << meter->command
+            << (meter->finished.load(std::memory_order_acquire) ? "" : " (still open)") << '\n';
+    }
+    return out.str();
+}
+
+std::string pipe_meter_json(const PipeMeters &meters)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(6) << '[';
+    for (size_t i = 0; i < meters.size(); ++i)
+    {
+        const PipeMeter &meter = *meters[i];
+        double seconds = elapsed_seconds(meter);
+        out << (i ? "," : "") << "{\"producer\":" << meter.producer + 1 << ",\"consumer\":" << meter.producer + 2
+            << ",\"bytes\":" << meter.bytes.load(std::memory_order_relaxed) << ",\"seconds\":" << seconds
+            << ",\"producer_blocked\":" << meter.producer_blocked_ns.load(std::memory_order_relaxed) / 1e9
+            << ",\"consumer_blocked\":" << meter.consumer_blocked_ns.load(std::memory_order_relaxed) / 1e9 << '}';
+    }
+    out << ']';
+    return out.str();
+}
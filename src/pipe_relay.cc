@@ -0,0 +1,657 @@
+#include "pipe_relay.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+
+namespace {
+
+constexpr size_t DEFAULT_MERGE_BUFFER = 1 << 20;
+constexpr size_t MERGE_READ_CHUNK = 64 * 1024;
+constexpr size_t BUFFER_BLOCK = 1 << 20;
+constexpr size_t SPLICE_CHUNK = 1 << 20;
+
+// Semua fd milik relay yang sedang berjalan, ditutup di child hasil fork
+std::mutex relay_mutex;
+std::vector<int> relay_fds;
+std::once_flag atfork_once;
+
+void lock_relays()
+{
+    relay_mutex.lock();
+}
+
+void unlock_relays()
+{
+    relay_mutex.unlock();
+}
+
+void close_relays_in_child()
+{
+    for (int fd : relay_fds)
+        close(fd);
+    relay_fds.clear();
+    relay_mutex.unlock();
+}
+
+void own_fds(const std::vector<int> &fds)
+{
+    std::call_once(atfork_once, [] { pthread_atfork(lock_relays, unlock_relays, close_relays_in_child); });
+    std::lock_guard<std::mutex> lock(relay_mutex);
+    relay_fds.insert(relay_fds.end(), fds.begin(), fds.end());
+}
+
+// Di bawah lock: fork tidak boleh terjadi di antara close dan penghapusan
+// dari daftar, nomor fd bisa langsung dipakai ulang
+void release_fd(int &fd)
+{
+    if (fd < 0)
+        return;
+    std::lock_guard<std::mutex> lock(relay_mutex);
+    relay_fds.erase(std::remove(relay_fds.begin(), relay_fds.end(), fd), relay_fds.end());
+    close(fd);
+    fd = -1;
+}
+
+// Pindahkan sampai length byte dari pipe in_fd ke out_fd; return jumlah
+// yang terkirim (kurang dari length jika out_fd error, e.g. EPIPE)
+size_t splice_all(int in_fd, int out_fd, size_t length)
+{
+    size_t moved = 0;
+    while (moved < length)
+    {
+        ssize_t n = splice(in_fd, nullptr, out_fd, nullptr, length - moved, SPLICE_F_MOVE);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        moved += static_cast<size_t>(n);
+    }
+    return moved;
+}
+
+// Buang data dari pipe (bagian untuk consumer yang sudah keluar); jalur
+// jarang, jadi cukup read biasa
+void discard(int fd, size_t length)
+{
+    char buffer[64 * 1024];
+    while (length > 0)
+    {
+        ssize_t n = read(fd, buffer, std::min(length, sizeof(buffer)));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        length -= static_cast<size_t>(n);
+    }
+}
+
+struct Fanout {
+    int in_fd = -1;
+    std::vector<int> outs;
+    int scratch[2] = {-1, -1}; // salinan sementara untuk tee yang terpotong
+};
+
+bool open_scratch(Fanout &fanout)
+{
+    if (fanout.scratch[0] >= 0)
+        return true;
+    if (pipe2(fanout.scratch, O_CLOEXEC) != 0)
+        return false;
+    own_fds({fanout.scratch[0], fanout.scratch[1]});
+    // Sebesar pipe input, jadi tee ke scratch yang kosong selalu muat
+    int size = fcntl(fanout.in_fd, F_GETPIPE_SZ);
+    if (size > fcntl(fanout.scratch[1], F_GETPIPE_SZ))
+        fcntl(fanout.scratch[1], F_SETPIPE_SZ, size);
+    return true;
+}
+
+/**
+ * @brief Salin length byte pertama in_fd ke out_fd tanpa mengonsumsinya.
+ *
+ * tee(2) selalu mulai dari awal pipe input, jadi jika out_fd hanya muat
+ * sebagian, data diduplikasi dulu ke pipe scratch, bagian yang sudah
+ * terkirim dibuang, dan sisanya di-splice dari sana. Tetap tanpa salinan
+ * ke user space, kecuali bagian yang dibuang.
+ */
+bool tee_all(Fanout &fanout, int out_fd, size_t length)
+{
+    ssize_t n;
+    do
+        n = tee(fanout.in_fd, out_fd, length, 0);
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return false;
+    size_t sent = static_cast<size_t>(n);
+    if (sent == length)
+        return true;
+
+    if (!open_scratch(fanout))
+        return false;
+    ssize_t copied = tee(fanout.in_fd, fanout.scratch[1], length, SPLICE_F_NONBLOCK);
+    bool ok = copied == static_cast<ssize_t>(length);
+    if (ok)
+    {
+        discard(fanout.scratch[0], sent);
+        ok = splice_all(fanout.scratch[0], out_fd, length - sent) == length - sent;
+    }
+    // Scratch harus kosong untuk round berikutnya
+    int left = 0;
+    if (ioctl(fanout.scratch[0], FIONREAD, &left) == 0 && left > 0)
+        discard(fanout.scratch[0], static_cast<size_t>(left));
+    return ok;
+}
+
+void run_fanout(Fanout fanout)
+{
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    while (!fanout.outs.empty())
+    {
+        struct pollfd pfd = {fanout.in_fd, POLLIN, 0};
+        if (poll(&pfd, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        int available = 0;
+        if (ioctl(fanout.in_fd, FIONREAD, &available) != 0 || available <= 0)
+        {
+            if (pfd.revents & (POLLHUP | POLLERR))
+                break; // EOF: semua writer sudah menutup pipe
+            continue;
+        }
+        size_t length = static_cast<size_t>(available);
+
+        // Semua consumer kecuali yang terakhir mendapat salinan (tee), yang
+        // terakhir mengambil data dari pipe input (splice)
+        for (size_t k = 0; k + 1 < fanout.outs.size();)
+        {
+            if (tee_all(fanout, fanout.outs[k], length))
+            {
+                k++;
+                continue;
+            }
+            release_fd(fanout.outs[k]);
+            fanout.outs.erase(fanout.outs.begin() + static_cast<long>(k));
+        }
+        size_t moved = splice_all(fanout.in_fd, fanout.outs.back(), length);
+        if (moved < length)
+        {
+            discard(fanout.in_fd, length - moved);
+            release_fd(fanout.outs.back());
+            fanout.outs.pop_back();
+        }
+    }
+
+    // Tanpa consumer tersisa producer mendapat EPIPE/SIGPIPE
+    release_fd(fanout.in_fd);
+    for (int &fd : fanout.outs)
+        release_fd(fd);
+    release_fd(fanout.scratch[0]);
+    release_fd(fanout.scratch[1]);
+}
+
+struct MergeInput {
+    int fd = -1;
+    std::string pending; // baris yang belum lengkap
+    std::string tag;
+};
+
+struct Merge {
+    std::vector<MergeInput> inputs;
+    int out_fd = -1;
+    std::string queue;   // baris utuh untuk consumer
+    size_t queue_pos = 0;
+    size_t limit = DEFAULT_MERGE_BUFFER;
+};
+
+void queue_lines(Merge &merge, const MergeInput &input, const char *data, size_t length)
+{
+    if (input.tag.empty())
+    {
+        merge.queue.append(data, length);
+        return;
+    }
+    size_t start = 0;
+    while (start < length)
+    {
+        const char *newline = static_cast<const char *>(memchr(data + start, '\n', length - start));
+        size_t end = newline ? static_cast<size_t>(newline - data) + 1 : length;
+        merge.queue += input.tag;
+        merge.queue.append(data + start, end - start);
+        start = end;
+    }
+}
+
+// Pindahkan baris utuh dari pending input ke antrian consumer
+void absorb(Merge &merge, MergeInput &input)
+{
+    size_t end = input.pending.rfind('\n');
+    if (end == std::string::npos)
+    {
+        if (input.pending.size() < merge.limit)
+            return;
+        end = input.pending.size() - 1; // baris terlalu panjang: teruskan bagian ini
+    }
+    queue_lines(merge, input, input.pending.data(), end + 1);
+    input.pending.erase(0, end + 1);
+}
+
+// Tulis antrian tanpa blocking; false jika consumer sudah keluar
+bool flush_queue(Merge &merge)
+{
+    while (merge.queue_pos < merge.queue.size())
+    {
+        ssize_t n = write(merge.out_fd, merge.queue.data() + merge.queue_pos, merge.queue.size() - merge.queue_pos);
+        if (n > 0)
+        {
+            merge.queue_pos += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && errno == EAGAIN)
+            break;
+        return false;
+    }
+    if (merge.queue_pos == merge.queue.size())
+    {
+        merge.queue.clear();
+        merge.queue_pos = 0;
+    }
+    else if (merge.queue_pos >= merge.limit)
+    {
+        merge.queue.erase(0, merge.queue_pos);
+        merge.queue_pos = 0;
+    }
+    return true;
+}
+
+void finish_input(Merge &merge, MergeInput &input, int epoll_fd)
+{
+    if (!input.pending.empty())
+    {
+        if (input.pending.back() != '\n')
+            input.pending += '\n';
+        queue_lines(merge, input, input.pending.data(), input.pending.size());
+        input.pending.clear();
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, input.fd, nullptr);
+    release_fd(input.fd);
+}
+
+/**
+ * @brief Loop relay merge: epoll atas semua producer dan consumer.
+ *
+ * Producer hanya dibaca selama antrian di bawah batas; saat penuh semua
+ * producer dilepas dari epoll (bukan sekadar dimatikan EPOLLIN-nya, karena
+ * EPOLLHUP tetap dilaporkan) sampai consumer menguras antrian.
+ */
+void run_merge(Merge merge)
+{
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd >= 0)
+        own_fds({epoll_fd});
+    const uint64_t OUTPUT = merge.inputs.size();
+    size_t open_inputs = merge.inputs.size();
+    bool reading = false, writing = false;
+    bool consumer_alive = epoll_fd >= 0;
+    if (consumer_alive)
+    {
+        struct epoll_event event = {};
+        event.data.u64 = OUTPUT;
+        consumer_alive = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, merge.out_fd, &event) == 0;
+    }
+    fcntl(merge.out_fd, F_SETFL, fcntl(merge.out_fd, F_GETFL) | O_NONBLOCK);
+    for (MergeInput &input : merge.inputs)
+        fcntl(input.fd, F_SETFL, fcntl(input.fd, F_GETFL) | O_NONBLOCK);
+
+    while (consumer_alive && (open_inputs > 0 || merge.queue_pos < merge.queue.size()))
+    {
+        size_t queued = merge.queue.size() - merge.queue_pos;
+        bool want_read = queued < merge.limit;
+        if (want_read != reading)
+        {
+            for (size_t k = 0; k < merge.inputs.size(); ++k)
+            {
+                if (merge.inputs[k].fd < 0)
+                    continue;
+                struct epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.u64 = k;
+                epoll_ctl(epoll_fd, want_read ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, merge.inputs[k].fd, &event);
+            }
+            reading = want_read;
+        }
+        // EPOLLERR consumer tetap dilaporkan walau EPOLLOUT tidak diminta
+        bool want_write = queued > 0;
+        if (want_write != writing)
+        {
+            struct epoll_event event = {};
+            event.events = want_write ? static_cast<uint32_t>(EPOLLOUT) : 0;
+            event.data.u64 = OUTPUT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, merge.out_fd, &event);
+            writing = want_write;
+        }
+
+        struct epoll_event events[16];
+        int count = epoll_wait(epoll_fd, events, 16, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int e = 0; e < count && consumer_alive; ++e)
+        {
+            uint64_t source = events[e].data.u64;
+            if (source == OUTPUT)
+            {
+                consumer_alive = !(events[e].events & EPOLLERR) && flush_queue(merge);
+                continue;
+            }
+            MergeInput &input = merge.inputs[source];
+            if (input.fd < 0)
+                continue;
+            size_t old_size = input.pending.size();
+            input.pending.resize(old_size + MERGE_READ_CHUNK);
+            ssize_t n = read(input.fd, &input.pending[old_size], MERGE_READ_CHUNK);
+            input.pending.resize(old_size + (n > 0 ? static_cast<size_t>(n) : 0));
+            if (n > 0)
+                absorb(merge, input);
+            else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                finish_input(merge, input, epoll_fd);
+                open_inputs--;
+            }
+        }
+        // Tulis langsung tanpa menunggu EPOLLOUT: consumer biasanya siap
+        if (consumer_alive)
+            consumer_alive = flush_queue(merge);
+    }
+
+    // Consumer keluar lebih dulu: producer mendapat EPIPE/SIGPIPE
+    for (MergeInput &input : merge.inputs)
+        release_fd(input.fd);
+    release_fd(merge.out_fd);
+    release_fd(epoll_fd);
+}
+
+struct BufferBlock {
+    std::vector<char> data;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+struct Buffer {
+    int in_fd = -1;
+    int out_fd = -1;
+    size_t limit = 0; // 0: hanya meter, tanpa buffer
+    size_t buffered = 0;
+    std::deque<BufferBlock> blocks;
+    std::shared_ptr<PipeMeter> meter;
+};
+
+long long monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Baca ke blok terakhir; false saat EOF atau error
+bool buffer_fill(Buffer &buffer)
+{
+    if (buffer.blocks.empty() || buffer.blocks.back().end == buffer.blocks.back().data.size())
+    {
+        buffer.blocks.emplace_back();
+        buffer.blocks.back().data.resize(std::min(BUFFER_BLOCK, buffer.limit));
+    }
+    BufferBlock &block = buffer.blocks.back();
+    size_t room = std::min(block.data.size() - block.end, buffer.limit - buffer.buffered);
+    ssize_t n = read(buffer.in_fd, block.data.data() + block.end, room);
+    if (n > 0)
+    {
+        block.end += static_cast<size_t>(n);
+        buffer.buffered += static_cast<size_t>(n);
+        if (buffer.meter)
+            buffer.meter->bytes.fetch_add(static_cast<unsigned long long>(n), std::memory_order_relaxed);
+        return true;
+    }
+    return n < 0 && (errno == EAGAIN || errno == EINTR);
+}
+
+// Kirim isi buffer tanpa blocking; false jika consumer sudah keluar
+bool buffer_drain(Buffer &buffer)
+{
+    while (!buffer.blocks.empty())
+    {
+        BufferBlock &block = buffer.blocks.front();
+        if (block.begin < block.end)
+        {
+            ssize_t n = write(buffer.out_fd, block.data.data() + block.begin, block.end - block.begin);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno == EAGAIN)
+                return true;
+            if (n <= 0)
+                return false;
+            block.begin += static_cast<size_t>(n);
+            buffer.buffered -= static_cast<size_t>(n);
+            if (block.begin < block.end)
+                continue;
+        }
+        // Blok yang masih diisi dipakai lagi, sisanya dibebaskan
+        if (buffer.blocks.size() == 1)
+        {
+            block.begin = block.end = 0;
+            break;
+        }
+        buffer.blocks.pop_front();
+    }
+    return true;
+}
+
+/**
+ * @brief Loop relay buffer.
+ *
+ * Buffer kosong: splice langsung in -> out. Jika out penuh (splice EAGAIN
+ * padahal input berisi) data dibaca ke buffer, dan selama buffer berisi
+ * semua data lewat buffer supaya urutannya terjaga. fd yang tidak ditunggu
+ * diberi -1 di poll, karena POLLHUP/POLLERR tetap dilaporkan walau events
+ * kosong. Tanpa limit (relay meter) out yang penuh hanya ditunggu.
+ *
+ * Dengan meter, waktu poll dicatat sebagai consumer-blocked jika buffer
+ * kosong dan relay menunggu input, producer-blocked jika relay hanya
+ * menunggu out padahal input masih berjalan. Jalur splice sendiri tidak
+ * membaca jam.
+ */
+void run_buffer(Buffer buffer)
+{
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    fcntl(buffer.in_fd, F_SETFL, fcntl(buffer.in_fd, F_GETFL) | O_NONBLOCK);
+    fcntl(buffer.out_fd, F_SETFL, fcntl(buffer.out_fd, F_GETFL) | O_NONBLOCK);
+    bool eof = false;
+    for (;;)
+    {
+        struct pollfd fds[2] = {{-1, POLLIN, 0}, {-1, POLLOUT, 0}};
+        if (buffer.buffered == 0)
+        {
+            if (eof)
+                break;
+            ssize_t n = splice(buffer.in_fd, nullptr, buffer.out_fd, nullptr, SPLICE_CHUNK,
+                               SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0 && buffer.meter)
+                buffer.meter->bytes.fetch_add(static_cast<unsigned long long>(n), std::memory_order_relaxed);
+            if (n > 0 || (n < 0 && errno == EINTR))
+                continue;
+            if (n == 0 || errno != EAGAIN)
+                break; // EOF tanpa sisa, atau consumer sudah keluar (EPIPE)
+
+            int available = 0;
+            if (ioctl(buffer.in_fd, FIONREAD, &available) == 0 && available > 0)
+            {
+                if (buffer.limit == 0)
+                {
+                    fds[1].fd = buffer.out_fd; // output penuh: tunggu consumer
+                }
+                else
+                {
+                    // Output penuh: mulai menampung
+                    if (!buffer_fill(buffer))
+                        eof = true;
+                    continue;
+                }
+            }
+            else
+            {
+                fds[0].fd = buffer.in_fd; // input kosong: tunggu data
+            }
+        }
+        else
+        {
+            if (!eof && buffer.buffered < buffer.limit)
+                fds[0].fd = buffer.in_fd;
+            fds[1].fd = buffer.out_fd;
+        }
+
+        long long waited_from = buffer.meter ? monotonic_ns() : 0;
+        int ready = poll(fds, 2, -1);
+        if (buffer.meter)
+        {
+            long long waited = monotonic_ns() - waited_from;
+            if (fds[0].fd >= 0 && buffer.buffered == 0)
+                buffer.meter->consumer_blocked_ns.fetch_add(waited, std::memory_order_relaxed);
+            else if (fds[0].fd < 0 && !eof)
+                buffer.meter->producer_blocked_ns.fetch_add(waited, std::memory_order_relaxed);
+        }
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents & POLLERR)
+            break;
+        if ((fds[0].revents & (POLLIN | POLLHUP)) && buffer.buffered > 0 && !buffer_fill(buffer))
+            eof = true;
+        if ((fds[1].revents & POLLOUT) && !buffer_drain(buffer))
+            break;
+        if (buffer.buffered == 0 && !buffer.blocks.empty())
+            buffer.blocks.clear(); // elastis: memori kembali setelah lonjakan
+    }
+
+    release_fd(buffer.in_fd);
+    release_fd(buffer.out_fd);
+    if (buffer.meter)
+        pipe_meter_finish(*buffer.meter);
+}
+
+} // namespace
+
+bool relay_start_fanout(int in_fd, const std::vector<int> &out_fds)
+{
+    Fanout fanout;
+    fanout.in_fd = in_fd;
+    fanout.outs = out_fds;
+
+    std::vector<int> fds = out_fds;
+    fds.push_back(in_fd);
+    own_fds(fds);
+    try
+    {
+        std::thread(run_fanout, fanout).detach();
+    }
+    catch (const std::system_error &e)
+    {
+        std::cerr << "nsh: fan-out: " << e.what() << std::endl;
+        for (int fd : fds)
+            release_fd(fd);
+        return false;
+    }
+    return true;
+}
+
+bool relay_start_merge(const std::vector<int> &in_fds, int out_fd, size_t buffer_limit, bool tagged)
+{
+    Merge merge;
+    merge.out_fd = out_fd;
+    if (buffer_limit > 0)
+        merge.limit = buffer_limit;
+    for (size_t k = 0; k < in_fds.size(); ++k)
+    {
+        MergeInput input;
+        input.fd = in_fds[k];
+        if (tagged)
+            input.tag = "[" + std::to_string(k + 1) + "] ";
+        merge.inputs.push_back(std::move(input));
+    }
+
+    std::vector<int> fds = in_fds;
+    fds.push_back(out_fd);
+    own_fds(fds);
+    try
+    {
+        std::thread(run_merge, std::move(merge)).detach();
+    }
+    catch (const std::system_error &e)
+    {
+        std::cerr << "nsh: merge: " << e.what() << std::endl;
+        for (int fd : fds)
+            release_fd(fd);
+        return false;
+    }
+    return true;
+}
+
+bool relay_start_buffer(int in_fd, int out_fd, size_t limit, std::shared_ptr<PipeMeter> meter)
+{
+    Buffer buffer;
+    buffer.in_fd = in_fd;
+    buffer.out_fd = out_fd;
+    buffer.limit = limit;
+    buffer.meter = meter;
+    if (meter)
+        clock_gettime(CLOCK_MONOTONIC, &meter->started);
+
+    own_fds({in_fd, out_fd});
+    try
+    {
+        std::thread(run_buffer, std::move(buffer)).detach();
+    }
+    catch (const std::system_error &e)
+    {
+        std::cerr << "nsh: " << (limit ? "buf: " : "pipe meter: ") << e.what() << std::endl;
+        release_fd(in_fd);
+        release_fd(out_fd);
+        if (meter)
+            pipe_meter_finish(*meter);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,179 @@
+#include "redir_cache.h"
+#include "expansion.h"
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct CachedFd {
+    std::string key;    // path absolut
+    int fd;
+    dev_t dev;
+    ino_t ino;
+    unsigned long last_used;
+};
+
+constexpr size_t REDIR_CACHE_MAX = 8;
+// Fd cache ditaruh di atas range yang biasa dipakai user (`exec 3>log`)
+constexpr int REDIR_CACHE_MIN_FD = 10;
+
+std::vector<CachedFd> cache;
+unsigned long use_clock = 0;
+std::string prepared_cwd;
+
+const char DEV_NULL[] = "/dev/null";
+
+bool is_append(RedirectionType type)
+{
+    return type == RedirectionType::REDIR_OUT_APPEND ||
+           type == RedirectionType::REDIR_OUT_ERR_APPEND;
+}
+
+bool is_cacheable_type(RedirectionType type)
+{
+    return is_append(type) || type == RedirectionType::REDIR_OUT ||
+           type == RedirectionType::REDIR_OUT_ERR || type == RedirectionType::REDIR_IN;
+}
+
+// Path absolut untuk target redirection, "" jika tidak bisa di-cache.
+// File biasa hanya di-cache untuk append (truncate/read harus open ulang),
+// /dev/null di-cache untuk semua arah karena dibuka O_RDWR.
+std::string cache_key(const Redirection &redir)
+{
+    if (!is_cacheable_type(redir.type) || redir.target_file.empty())
+        return "";
+
+    std::string path = expand_tilde(redir.target_file);
+    if (path == DEV_NULL)
+        return path;
+    if (!is_append(redir.type))
+        return "";
+
+    if (path[0] != '/') {
+        if (prepared_cwd.empty())
+            return "";
+        path = (fs::path(prepared_cwd) / path).lexically_normal().string();
+    }
+    return path;
+}
+
+CachedFd *find_entry(const std::string &key)
+{
+    for (auto &entry : cache) {
+        if (entry.key == key)
+            return &entry;
+    }
+    return nullptr;
+}
+
+void drop_entry(size_t index, bool close_fd)
+{
+    if (close_fd)
+        close(cache[index].fd);
+    cache.erase(cache.begin() + index);
+}
+
+void open_entry(const std::string &key)
+{
+    bool dev_null = (key == DEV_NULL);
+    struct stat st;
+
+    if (!dev_null && stat(key.c_str(), &st) == 0 && !S_ISREG(st.st_mode)) {
+        // FIFO, tty, socket...: open() bisa blocking atau punya efek samping
+        return;
+    }
+
+    int flags = dev_null ? O_RDWR : (O_WRONLY | O_CREAT | O_APPEND);
+    int fd = open(key.c_str(), flags | O_CLOEXEC, 0666);
+    if (fd == -1)
+        return; // biarkan child yang melaporkan error seperti biasa
+
+    int high_fd = fcntl(fd, F_DUPFD_CLOEXEC, REDIR_CACHE_MIN_FD);
+    close(fd);
+    if (high_fd == -1 || fstat(high_fd, &st) != 0) {
+        if (high_fd != -1)
+            close(high_fd);
+        return;
+    }
+
+    if (cache.size() >= REDIR_CACHE_MAX) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < cache.size(); ++i) {
+            if (cache[i].last_used < cache[oldest].last_used)
+                oldest = i;
+        }
+        drop_entry(oldest, true);
+    }
+    cache.push_back({key, high_fd, st.st_dev, st.st_ino, ++use_clock});
+}
+
+} // namespace
+
+void redir_cache_prepare(const std::vector<SimpleCommand> &pipeline)
+{
+    bool cwd_known = false;
+
+    for (const auto &cmd : pipeline) {
+        for (const auto &redir : cmd.redirections) {
+            if (!is_cacheable_type(redir.type))
+                continue;
+
+            if (!cwd_known) {
+                std::error_code ec;
+                prepared_cwd = fs::current_path(ec).string();
+                cwd_known = true;
+            }
+
+            std::string key = cache_key(redir);
+            if (key.empty())
+                continue;
+
+            CachedFd *entry = find_entry(key);
+            if (entry && key != DEV_NULL) {
+                // File di-rotate/dihapus sejak dibuka: buka ulang
+                struct stat st;
+                if (stat(key.c_str(), &st) != 0 || st.st_dev != entry->dev || st.st_ino != entry->ino) {
+                    drop_entry(entry - cache.data(), true);
+                    entry = nullptr;
+                }
+            }
+
+            if (entry)
+                entry->last_used = ++use_clock;
+            else
+                open_entry(key);
+        }
+    }
+}
+
+int redir_cache_lookup(const Redirection &redir)
+{
+    std::string key = cache_key(redir);
+    if (key.empty())
+        return -1;
+    CachedFd *entry = find_entry(key);
+    return entry ? entry->fd : -1;
+}
+
+void redir_cache_forget_fd(int fd)
+{
+    for (size_t i = 0; i < cache.size(); ++i) {
+        if (cache[i].fd == fd) {
+            drop_entry(i, false);
+            return;
+        }
+    }
+}
+
+void redir_cache_clear()
+{
+    while (!cache.empty())
+        drop_entry(cache.size() - 1, true);
+}
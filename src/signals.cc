@@ -10,6 +10,7 @@
 #include "terminal.h"
 #include "execution.h"  // Add this include
 #include "globals.h"    // Make sure this is included
+#include "events.h"
 
 #include <termios.h>
 
@@ -18,7 +19,6 @@
 #include <csignal> // Pastikan ini sudah termasuk
 
 volatile sig_atomic_t current_signal = 0;
-volatile sig_atomic_t sigchld_flag = 0;
 
 // Definisikan struct untuk pasangan Nama Sinyal dan Nilai Sinyal
 struct SignalInfo {
@@ -49,32 +49,11 @@ const std::vector<SignalInfo> what_signal = {
  * berhenti (stopped), selesai (terminated), atau diinterupsi oleh sinyal.
  * Fungsi ini juga memastikan kontrol terminal dikembalikan ke shell setelahnya.
  * * @param pgid Process Group ID dari job yang akan ditunggu.
- * @return Status integer yang dikembalikan oleh `waitpid`.
+ * @return Status gaya `waitpid` (stop atau exit stage terakhir).
  */
 int wait_for_job(pid_t pgid) {
-    int status = 0;
-    pid_t result;
-
-    do {
-        // Tunggu proses dalam process group -pgid
-        // dengan opsi WUNTRACED untuk mendeteksi proses berhenti (Ctrl+Z)
-        result = waitpid(-pgid, &status, WUNTRACED);
-        
-        // Cek jika proses berhenti (WIFSTOPPED) atau selesai (WIFEXITED/WIFSIGNALED)
-        if (result > 0) {
-            if (WIFSTOPPED(status) || WIFSIGNALED(status) || WIFEXITED(status)) {
-                return status; // Langsung kembalikan status
-            }
-        }
-    } while (result == -1 && errno == EINTR);
-
-    // Jika waitpid gagal karena alasan lain
-    if (result == -1) {
-        perror("waitpid");
-        return -1;
-    }
-
-    return status;
+    // Reaping hanya dilakukan event loop; tunggu di sana
+    return event_loop_wait_group(pgid);
 }
 
 
@@ -99,27 +78,10 @@ void sigtstp_handler(int signum) {
         return;
     }
 
+    // Status stopped dibaca event loop dari signalfd; handler tidak
+    // melakukan waitpid maupun menyentuh job list
     if (kill(-foreground_pgid, SIGTSTP) < 0) {
         perror("kill (SIGTSTP)");
-    } else {
-        int status;
-        // Tunggu hingga proses benar-benar stopped
-        waitpid(-foreground_pgid, &status, WUNTRACED);
-        clear_readline_input();
-
-        // UPDATE STATUS JOB DI MEMORY - PERBAIKAN: Pastikan status di-update
-        for (auto& [id, job] : jobs) {
-            if (job.pgid == foreground_pgid) {
-                job.status = JobStatus::STOPPED;
-                job.term_status = WSTOPSIG(status);
-                write_job_controle_file(job); // Update file kontrol
-                std::cout << "\n[" << id << "]+ Stopped\t" << job.command << std::endl;
-                break;
-            }
-        }
-        
-        // Reset foreground_pgid setelah job di-stop
-        foreground_pgid = 0;
     }
 }
 
@@ -221,45 +183,6 @@ void sigpipe_handler(int signum) {
     current_signal = signum;
 }
 
-void sigchld_handler(int signum) {
-    (void)signum;
-    int status;
-    sigchld_flag = 1;
-    current_signal = signum;
-    pid_t pid;
-
-    while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0) {
-        for (auto it = jobs.begin(); it != jobs.end(); ) {
-            if (it->second.pgid == pid || it->second.pgid == getpgid(pid)) {
-                if (WIFEXITED(status) || WIFSIGNALED(status)) {
-                    // Job completed
-                    it->second.status = WIFEXITED(status) ? JobStatus::EXITED : JobStatus::SIGNALED;
-                    it->second.term_status = WIFEXITED(status) ? WEXITSTATUS(status) : WTERMSIG(status);
-                    
-                    write_job_controle_file(it->second);
-                    finished_jobs.push_back(*it);
-                    it = jobs.erase(it);
-                } else if (WIFSTOPPED(status)) {
-                    // Job stopped - PERBAIKAN: Update status ke STOPPED
-                    it->second.status = JobStatus::STOPPED;
-                    it->second.term_status = WSTOPSIG(status);
-                    write_job_controle_file(it->second);
-                    ++it;
-                } else if (WIFCONTINUED(status)) {
-                    // Job continued
-                    it->second.status = JobStatus::RUNNING;
-                    write_job_controle_file(it->second);
-                    ++it;
-                } else {
-                    ++it;
-                }
-            } else {
-                ++it;
-            }
-        }
-    }
-}
-
 /**
  * @brief Menonaktifkan sinyal dengan mengaturnya agar diabaikan (SIG_IGN)
  * menggunakan variabel terpusat what_signal.
@@ -354,8 +277,8 @@ void setup_signals() {
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = SA_RESTART | SA_NODEFER; // Tambahkan SA_NODEFER untuk menghindari rekursi
 
-    sa.sa_handler = sigchld_handler;
-    sigaction(SIGCHLD, &sa, NULL);
+    // SIGCHLD tidak punya handler: diblok dan dibaca lewat signalfd
+    event_loop_init();
 
     sa.sa_handler = sigtstp_handler;
     sigaction(SIGTSTP, &sa, NULL);
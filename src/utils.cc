@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <climits>
 // utils.cc
 #include <readline/history.h>
 #include <readline/readline.h>
@@ -31,6 +33,11 @@ int get_terminal_width()
 }
 
 void safe_print(const std::string &text)
+{
+    safe_print(text, std::cout);
+}
+
+void safe_print(const std::string &text, std::ostream &out)
 {
     int width = get_terminal_width();
     std::stringstream ss(text);
@@ -40,11 +47,11 @@ void safe_print(const std::string &text)
     {
         if (line.length() > (size_t)width)
         {
-            std::cout << line.substr(0, width - 3) << "..." << std::endl;
+            out << line.substr(0, width - 3) << "..." << std::endl;
         }
         else
         {
-            std::cout << line << std::endl;
+            out << line << std::endl;
         }
     }
 }
@@ -213,3 +220,56 @@ bool is_string_numeric(const std::string& s) {
     }
     return true;
 }
+
+bool parse_fd_number(const std::string& s, int& fd) {
+    if (!is_string_numeric(s))
+        return false;
+    errno = 0;
+    long value = strtol(s.c_str(), nullptr, 10);
+    if (errno != 0 || value > INT_MAX)
+        return false;
+    fd = static_cast<int>(value);
+    return true;
+}
+
+// "4096", "256K", "1M", "2G" (1K = 1024 byte, huruf besar/kecil, akhiran
+// B opsional)
+bool parse_byte_size(const std::string& s, unsigned long long& bytes) {
+    if (s.empty() || !std::isdigit(static_cast<unsigned char>(s[0])))
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long value = strtoull(s.c_str(), &end, 10);
+    if (errno != 0)
+        return false;
+
+    int shift = 0;
+    switch (std::toupper(static_cast<unsigned char>(*end))) {
+        case 'K': shift = 10; break;
+        case 'M': shift = 20; break;
+        case 'G': shift = 30; break;
+        case 'T': shift = 40; break;
+        default: break;
+    }
+    if (shift != 0)
+        end++;
+    if (std::toupper(static_cast<unsigned char>(*end)) == 'B')
+        end++;
+    if (*end != '\0' || (shift != 0 && value > (~0ULL >> shift)))
+        return false;
+    bytes = value << shift;
+    return true;
+}
+
+std::string format_byte_size(unsigned long long bytes) {
+    const char *units = "BKMGT";
+    int unit = 0;
+    while (bytes >= 1024 && bytes % 1024 == 0 && unit < 4) {
+        bytes /= 1024;
+        unit++;
+    }
+    std::string text = std::to_string(bytes);
+    if (unit > 0)
+        text += units[unit];
+    return text;
+}